@@ -0,0 +1,212 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Runs the same simulation with `Manager` (per-entity component pointers)
+// and `ArchetypeManager` (archetype chunks), checking that both end up in
+// the same state.
+
+#include <chrono>
+#include <cmath>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int entityCount{200000};
+static constexpr int frames{60};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct CPosition : Component
+{
+    float x, y;
+    CPosition(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CVelocity : Component
+{
+    float x, y;
+    CVelocity(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CAcceleration : Component
+{
+    float x, y;
+    CAcceleration(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CLife : Component
+{
+    float life;
+    bool persistent; // Loses `CLife` instead of dying
+    CLife(float mLife, bool mPersistent) : life{mLife}, persistent{mPersistent}
+    {
+    }
+};
+
+// Both layouts share the systems' logic, only the base class and the entity
+// type change
+template <typename TEntity>
+struct Logic
+{
+    double sum{0};
+
+    inline void move(CPosition& cPosition, CVelocity& cVelocity,
+        CAcceleration& cAcceleration, FT mFT)
+    {
+        cVelocity.x += cAcceleration.x * mFT;
+        cVelocity.y += cAcceleration.y * mFT;
+        cPosition.x += cVelocity.x * mFT;
+        cPosition.y += cVelocity.y * mFT;
+    }
+    inline void decay(TEntity& mEntity, CLife& cLife, FT mFT)
+    {
+        cLife.life -= mFT;
+        if(cLife.life >= 0) return;
+
+        if(cLife.persistent)
+            mEntity.template removeComponent<CLife>();
+        else
+            mEntity.destroy();
+    }
+};
+
+struct SMovement
+    : System<SMovement, Req<CPosition, CVelocity, CAcceleration>>,
+      Logic<Entity>
+{
+    inline void process(Entity&, CPosition& cPosition, CVelocity& cVelocity,
+        CAcceleration& cAcceleration, FT mFT)
+    {
+        move(cPosition, cVelocity, cAcceleration, mFT);
+    }
+};
+struct SDecay : System<SDecay, Req<CLife>>, Logic<Entity>
+{
+    inline void process(Entity& mEntity, CLife& cLife, FT mFT)
+    {
+        decay(mEntity, cLife, mFT);
+    }
+};
+struct SSum : System<SSum, Req<CPosition>, Not<CLife>>, Logic<Entity>
+{
+    inline void process(Entity&, CPosition& cPosition)
+    {
+        sum += cPosition.x + cPosition.y;
+    }
+};
+
+struct SAMovement
+    : ArchetypeSystem<SAMovement, Req<CPosition, CVelocity, CAcceleration>>,
+      Logic<ArchetypeEntity>
+{
+    inline void process(ArchetypeEntity&, CPosition& cPosition,
+        CVelocity& cVelocity, CAcceleration& cAcceleration, FT mFT)
+    {
+        move(cPosition, cVelocity, cAcceleration, mFT);
+    }
+};
+struct SADecay : ArchetypeSystem<SADecay, Req<CLife>>,
+                 Logic<ArchetypeEntity>
+{
+    inline void process(ArchetypeEntity& mEntity, CLife& cLife, FT mFT)
+    {
+        decay(mEntity, cLife, mFT);
+    }
+};
+struct SASum : ArchetypeSystem<SASum, Req<CPosition>, Not<CLife>>,
+               Logic<ArchetypeEntity>
+{
+    inline void process(ArchetypeEntity&, CPosition& cPosition)
+    {
+        sum += cPosition.x + cPosition.y;
+    }
+};
+
+struct Result
+{
+    Clock::duration create, update;
+    SizeT entities;
+    double sum;
+};
+
+// Same pseudo-random world for both layouts
+template <typename TEntity>
+inline void populate(TEntity mEntity, int mIdx)
+{
+    const auto& f(float(mIdx % 97) / 97.f);
+
+    mEntity.template createComponent<CPosition>(f * 1024.f, f * 768.f);
+    mEntity.template createComponent<CVelocity>(f - 0.5f, 0.5f - f);
+    if(mIdx % 4 != 0)
+        mEntity.template createComponent<CAcceleration>(f * 0.1f, -f * 0.1f);
+    if(mIdx % 3 != 0)
+        mEntity.template createComponent<CLife>(
+            float(mIdx % frames), mIdx % 2 == 0);
+}
+
+template <typename TManager, typename TMovement, typename TDecay,
+    typename TSum>
+inline Result run()
+{
+    Result result;
+    TManager manager;
+    TMovement sMovement;
+    TDecay sDecay;
+    TSum sSum;
+
+    manager.registerSystem(sMovement);
+    manager.registerSystem(sDecay);
+    manager.registerSystem(sSum);
+
+    auto start(Clock::now());
+    for(int i{0}; i < entityCount; ++i) populate(manager.createEntity(), i);
+    manager.refresh();
+    result.create = Clock::now() - start;
+
+    start = Clock::now();
+    for(int i{0}; i < frames; ++i)
+    {
+        sMovement.processAll(1.f);
+        sDecay.processAll(1.f);
+        manager.refresh();
+    }
+    result.update = Clock::now() - start;
+
+    sSum.processAll();
+    result.entities = manager.getEntityCount();
+    result.sum = sSum.sum;
+    return result;
+}
+
+inline long toMs(Clock::duration mDuration)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(mDuration)
+        .count();
+}
+
+inline void print(const std::string& mTitle, const Result& mResult)
+{
+    ssvu::lo(mTitle) << mResult.entities << " entities left | create: "
+                     << toMs(mResult.create)
+                     << " ms, update: " << toMs(mResult.update) << " ms ("
+                     << toMs(mResult.update) / double(frames)
+                     << " ms/frame)\n";
+}
+
+int main()
+{
+    const auto& pointers(run<Manager, SMovement, SDecay, SSum>());
+    print("Manager", pointers);
+
+    const auto& archetypes(
+        run<ArchetypeManager, SAMovement, SADecay, SASum>());
+    print("ArchetypeManager", archetypes);
+
+    const auto& ok(pointers.entities == archetypes.entities &&
+                   std::abs(pointers.sum - archetypes.sum) <=
+                       1e-6 * std::abs(pointers.sum));
+
+    if(!ok) ssvu::lo("Archetype") << "ERROR: the two layouts differ\n";
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Spawns bursts of identical entities one at a time and with
+// `createEntities`, then destroys them with `destroyAll`, checking that
+// systems see the same entities either way.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int burstSize{100000};
+static constexpr int bursts{5};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct CPosition : Component
+{
+    float x, y;
+    CPosition(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CVelocity : Component
+{
+    float x, y;
+    CVelocity(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CLife : Component
+{
+    float life;
+    CLife(float mLife) : life{mLife} {}
+};
+
+struct SMovement : System<SMovement, Req<CPosition, const CVelocity>>
+{
+    SizeT count{0};
+
+    inline void process(Entity&, CPosition& cPosition,
+        const CVelocity& cVelocity)
+    {
+        cPosition.x += cVelocity.x;
+        ++count;
+    }
+};
+struct SAMovement
+    : ArchetypeSystem<SAMovement, Req<CPosition, const CVelocity>>
+{
+    SizeT count{0};
+
+    inline void process(ArchetypeEntity&, CPosition& cPosition,
+        const CVelocity& cVelocity)
+    {
+        cPosition.x += cVelocity.x;
+        ++count;
+    }
+};
+
+inline double toMs(Clock::duration mDuration)
+{
+    return std::chrono::duration<double, std::milli>(mDuration).count();
+}
+
+// Returns the entities seen by the system after the bursts
+template <typename TManager, typename TSystem, typename TSpawn>
+inline SizeT bench(const std::string& mTitle, const TSpawn& mSpawn)
+{
+    TManager manager;
+    TSystem system;
+    manager.registerSystem(system);
+
+    auto start(Clock::now());
+    for(int i{0}; i < bursts; ++i)
+    {
+        mSpawn(manager);
+        manager.refresh();
+    }
+    const auto& spawnTime(Clock::now() - start);
+
+    system.processAll();
+    const auto& result(system.count);
+
+    ssvu::lo(mTitle) << manager.getEntityCount() << " entities, "
+                     << toMs(spawnTime) / bursts << " ms/burst\n";
+    return result;
+}
+
+int main()
+{
+    const CPosition position{0.f, 0.f};
+    const CVelocity velocity{1.f, 0.f};
+    const CLife life{10.f};
+
+    const auto& single(bench<Manager, SMovement>("createEntity",
+        [&](Manager& mManager)
+        {
+            for(int i{0}; i < burstSize; ++i)
+            {
+                auto e(mManager.createEntity());
+                e.createComponent<CPosition>(position);
+                e.createComponent<CVelocity>(velocity);
+                e.createComponent<CLife>(life);
+            }
+        }));
+
+    const auto& bulk(bench<Manager, SMovement>("createEntities",
+        [&](Manager& mManager)
+        {
+            mManager.createEntities(burstSize, position, velocity, life);
+        }));
+
+    const auto& archetypeSingle(
+        bench<ArchetypeManager, SAMovement>("Archetype createEntity",
+            [&](ArchetypeManager& mManager)
+            {
+                for(int i{0}; i < burstSize; ++i)
+                {
+                    auto e(mManager.createEntity());
+                    e.createComponent<CPosition>(position);
+                    e.createComponent<CVelocity>(velocity);
+                    e.createComponent<CLife>(life);
+                }
+            }));
+
+    const auto& archetypeBulk(
+        bench<ArchetypeManager, SAMovement>("Archetype createEntities",
+            [&](ArchetypeManager& mManager)
+            {
+                mManager.createEntities(burstSize, position, velocity, life);
+            }));
+
+    // Destroy a grouped half of the world
+    Manager manager;
+    SMovement sMovement;
+    manager.registerSystem(sMovement);
+
+    const auto& first(manager.createEntities(burstSize, position, velocity));
+    manager.createEntities(burstSize, position, velocity);
+    for(auto i(first); i < first + burstSize; ++i)
+        manager.getEntities()[i]->addGroups(0);
+
+    auto start(Clock::now());
+    manager.destroyAll(0);
+    manager.refresh();
+    const auto& destroyTime(Clock::now() - start);
+
+    sMovement.processAll();
+    ssvu::lo("destroyAll") << toMs(destroyTime) << " ms, "
+                           << manager.getEntityCount() << " entities left\n";
+
+    const SizeT expected{burstSize * bursts};
+    const auto& ok(single == expected && bulk == expected &&
+                   archetypeSingle == expected &&
+                   archetypeBulk == expected &&
+                   sMovement.count == SizeT(burstSize) &&
+                   manager.getEntityCount() == SizeT(burstSize) &&
+                   !manager.hasEntity(0));
+
+    if(!ok) ssvu::lo("Bulk") << "ERROR: unexpected entity counts\n";
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
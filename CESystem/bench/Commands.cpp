@@ -0,0 +1,174 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Runs a system which destroys and spawns entities through command buffers,
+// sequentially and split into parallel chunks, checking that both produce
+// the same entities in the same order. Also checks the order of commands
+// recorded concurrently by several threads outside of systems.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int entityCount{100000};
+static constexpr int frames{20};
+static constexpr SizeT minChunk{1024};
+static constexpr int outsideThreads{4};
+static constexpr int outsideCommands{1000};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct CLife : Component
+{
+    int life;
+    CLife(int mLife) : life{mLife} {}
+};
+struct CGeneration : Component
+{
+    int generation;
+    CGeneration(int mGeneration) : generation{mGeneration} {}
+};
+
+// Expired entities are replaced by two children, up to a generation limit
+struct SLife : System<SLife, Req<CLife, const CGeneration>>
+{
+    Manager& manager;
+    inline SLife(Manager& mManager) : manager(mManager) {}
+
+    inline void process(
+        Entity& mEntity, CLife& cLife, const CGeneration& cGeneration)
+    {
+        if(--cLife.life > 0) return;
+
+        auto& commands(manager.getCommands());
+        commands.get(mEntity).destroy();
+
+        if(cGeneration.generation >= 3) return;
+        for(int i{0}; i < 2; ++i)
+        {
+            auto child(commands.createEntity());
+            child.createComponent<CLife>(cGeneration.generation * 3 + i + 1);
+            child.createComponent<CGeneration>(cGeneration.generation + 1);
+        }
+    }
+};
+
+struct Result
+{
+    Clock::duration duration;
+    std::vector<std::pair<int, int>> entities;
+};
+
+inline Result run(ThreadPool* mPool)
+{
+    Manager manager;
+    SLife sLife{manager};
+    manager.registerSystem(sLife);
+
+    for(int i{0}; i < entityCount; ++i)
+    {
+        auto e(manager.createEntity());
+        e.createComponent<CLife>(i % 7 + 1);
+        e.createComponent<CGeneration>(0);
+    }
+    manager.refresh();
+
+    auto start(Clock::now());
+    for(int i{0}; i < frames; ++i)
+    {
+        if(mPool != nullptr)
+            sLife.processAllParallel(*mPool, minChunk);
+        else
+            sLife.processAll();
+
+        manager.refresh();
+    }
+
+    Result result{Clock::now() - start, {}};
+    for(const auto& e : manager.getEntities())
+        result.entities.emplace_back(e->getComponent<CLife>().life,
+            e->getComponent<CGeneration>().generation);
+    return result;
+}
+
+// Threads ask for their command buffers one after another, then record
+// concurrently: their commands are applied buffer by buffer
+inline bool runOutsideSystems()
+{
+    Manager manager;
+    std::atomic<int> ready{0};
+    std::vector<std::thread> threads;
+
+    for(int t{0}; t < outsideThreads; ++t)
+        threads.emplace_back([&manager, &ready, t]
+            {
+                while(ready != t) std::this_thread::yield();
+                auto& commands(manager.getCommands());
+                ++ready;
+                while(ready != outsideThreads) std::this_thread::yield();
+
+                for(int i{0}; i < outsideCommands; ++i)
+                {
+                    auto e(commands.createEntity());
+                    e.createComponent<CLife>(i);
+                    e.createComponent<CGeneration>(t);
+                }
+            });
+
+    for(auto& t : threads) t.join();
+    manager.refresh();
+
+    const auto& entities(manager.getEntities());
+    if(entities.size() != SizeT(outsideThreads * outsideCommands))
+        return false;
+
+    for(auto i(0u); i < entities.size(); ++i)
+        if(entities[i]->getComponent<CLife>().life !=
+               int(i % outsideCommands) ||
+            entities[i]->getComponent<CGeneration>().generation !=
+                int(i / outsideCommands))
+            return false;
+
+    return true;
+}
+
+inline void print(const std::string& mTitle, const Result& mResult)
+{
+    ssvu::lo(mTitle)
+        << std::chrono::duration<double, std::milli>(mResult.duration).count() /
+               frames
+        << " ms/frame, " << mResult.entities.size() << " entities\n";
+}
+
+int main()
+{
+    ThreadPool pool;
+    ssvu::lo("ThreadPool") << pool.getWorkerCount() << " workers\n";
+
+    const auto& sequential(run(nullptr));
+    print("Sequential", sequential);
+
+    const auto& parallel(run(&pool));
+    print("Parallel", parallel);
+
+    auto ok(!sequential.entities.empty() &&
+            sequential.entities == parallel.entities);
+    if(!ok) ssvu::lo("Commands") << "ERROR: results differ\n";
+
+    for(int i{0}; i < 10; ++i)
+        if(!runOutsideSystems())
+        {
+            ssvu::lo("Commands")
+                << "ERROR: commands recorded outside of systems out of order\n";
+            ok = false;
+            break;
+        }
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Queries groups every frame, as AI code does, through the handle range
+// and through a vector of handles built per query, while entities join and
+// leave groups; checks that groups stay consistent.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int entityCount{200000};
+static constexpr int frames{100};
+static constexpr int changesPerFrame{2000};
+static constexpr Group groupCount{8};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct CTarget : Component
+{
+    float x, y;
+    CTarget(float mX, float mY) : x{mX}, y{mY} {}
+};
+
+inline double toMs(Clock::duration mDuration)
+{
+    return std::chrono::duration<double, std::milli>(mDuration).count();
+}
+
+// What `getEntityHandles` used to return
+inline std::vector<EntityHandle> copyHandles(Manager& mManager, Group mGroup)
+{
+    std::vector<EntityHandle> result;
+    for(const auto& e : mManager.getEntities(mGroup)) result.emplace_back(*e);
+    return result;
+}
+
+template <typename TRange>
+inline float sumTargets(TRange&& mRange)
+{
+    float result{0.f};
+    for(auto h : mRange) result += h.template getComponent<CTarget>().x;
+    return result;
+}
+
+int main()
+{
+    Manager manager;
+    for(int i{0}; i < entityCount; ++i)
+    {
+        auto e(manager.createEntity());
+        e.createComponent<CTarget>(float(i % 10), 0.f);
+        e.addGroups(Group(i % groupCount));
+    }
+    manager.refresh();
+
+    Clock::duration rangeTime{0}, copyTime{0}, refreshTime{0};
+    float rangeSum{0.f}, copySum{0.f};
+
+    for(int f{0}; f < frames; ++f)
+    {
+        auto start(Clock::now());
+        for(Group g{0}; g < groupCount; ++g)
+            rangeSum += sumTargets(manager.getEntityHandles(g));
+        rangeTime += Clock::now() - start;
+
+        start = Clock::now();
+        for(Group g{0}; g < groupCount; ++g)
+            copySum += sumTargets(copyHandles(manager, g));
+        copyTime += Clock::now() - start;
+
+        // Move entities between groups, and replace some of them
+        auto& entities(manager.getEntities());
+        for(int i{0}; i < changesPerFrame; ++i)
+        {
+            auto& e(*entities[(f * 7919 + i * 104729) % entities.size()]);
+            if(i % 4 == 0)
+            {
+                e.destroy();
+                auto spawned(manager.createEntity());
+                spawned.createComponent<CTarget>(1.f, 0.f);
+                spawned.addGroups(Group(i % groupCount));
+                continue;
+            }
+
+            const auto& g(Group((f + i) % groupCount));
+            if(e.hasGroup(g))
+                e.delGroups(g);
+            else
+                e.addGroups(g);
+        }
+
+        start = Clock::now();
+        manager.refresh();
+        refreshTime += Clock::now() - start;
+    }
+
+    // Every grouped entity must be in its groups exactly once
+    bool ok{rangeSum == copySum};
+    std::vector<SizeT> expected(groupCount, 0);
+    for(const auto& e : manager.getEntities())
+        for(Group g{0}; g < groupCount; ++g)
+            if(e->hasGroup(g)) ++expected[g];
+    for(Group g{0}; g < groupCount; ++g)
+    {
+        ok = ok && manager.getEntityCount(g) == expected[g] &&
+             manager.getEntityHandles(g).size() == expected[g];
+        for(auto h : manager.getEntityHandles(g)) ok = ok && h.hasGroup(g);
+    }
+
+    ssvu::lo("Handle range") << toMs(rangeTime) / frames << " ms/frame\n";
+    ssvu::lo("Handle vector") << toMs(copyTime) / frames << " ms/frame\n";
+    ssvu::lo("Refresh") << toMs(refreshTime) / frames << " ms/frame\n";
+    if(!ok) ssvu::lo("Groups") << "ERROR: inconsistent groups\n";
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Profiles scheduled systems and refreshes over a few hundred frames,
+// prints the average cost of each system and writes the recorded frames as
+// CSV and as a Chrome trace.
+
+#define CESYSTEM_PROFILE 1
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int entityCount{100000};
+static constexpr int frames{400};
+static constexpr SizeT frameCapacity{300};
+
+struct CPosition : Component
+{
+    float x, y;
+    CPosition(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CVelocity : Component
+{
+    float x, y;
+    CVelocity(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CLife : Component
+{
+    int life;
+    CLife(int mLife) : life{mLife} {}
+};
+
+struct SMovement : System<SMovement, Req<CPosition, const CVelocity>>
+{
+    inline void process(
+        Entity&, CPosition& cPosition, const CVelocity& cVelocity)
+    {
+        cPosition.x += std::cos(cVelocity.x);
+        cPosition.y += std::sin(cVelocity.y);
+    }
+};
+
+// Replaces expired entities through the command buffer
+struct SLife : System<SLife, Req<CLife>>
+{
+    Manager& manager;
+    inline SLife(Manager& mManager) : manager(mManager) {}
+
+    inline void process(Entity& mEntity, CLife& cLife)
+    {
+        if(--cLife.life > 0) return;
+
+        auto& commands(manager.getCommands());
+        commands.get(mEntity).destroy();
+
+        auto e(commands.createEntity());
+        e.createComponent<CPosition>(0.f, 0.f);
+        e.createComponent<CVelocity>(1.f, 1.f);
+        e.createComponent<CLife>(50);
+    }
+};
+
+int main()
+{
+    ThreadPool pool;
+    Manager manager;
+    auto& profiler(manager.getProfiler());
+    profiler.setCapacity(frameCapacity);
+
+    SMovement sMovement;
+    SLife sLife{manager};
+    manager.registerSystem(sMovement);
+    manager.registerSystem(sLife);
+    profiler.setSystemName(0, "Movement");
+    profiler.setSystemName(1, "Life");
+
+    for(int i{0}; i < entityCount; ++i)
+    {
+        auto e(manager.createEntity());
+        e.createComponent<CPosition>(0.f, 0.f);
+        e.createComponent<CVelocity>(float(i % 7), 1.f);
+        e.createComponent<CLife>(i % 50 + 1);
+    }
+    manager.refresh();
+
+    Scheduler scheduler{pool};
+    scheduler.add(sMovement, [&sMovement]
+        {
+            sMovement.processAll();
+        });
+    scheduler.add(sLife, [&sLife]
+        {
+            sLife.processAll();
+        });
+
+    for(int i{0}; i < frames; ++i)
+    {
+        scheduler.run();
+        manager.refresh();
+    }
+
+    // Every frame of the buffer ran each system once, and the number of
+    // entities does not change, as each destroyed entity is replaced
+    bool ok{profiler.getFrameCount() == frameCapacity};
+    std::array<double, 2> systemUs{{0, 0}};
+    std::array<double, SizeT(RefreshPhase::Count)> refreshUs{};
+
+    for(auto i(0u); i < profiler.getFrameCount(); ++i)
+    {
+        const auto& f(profiler.getFrame(i));
+        ok = ok && f.frame == frames - frameCapacity + 1 + i &&
+             f.systems.size() == 2 && f.events.size() == 2 + refreshUs.size();
+
+        for(auto s(0u); s < f.systems.size(); ++s)
+        {
+            const auto& p(f.systems[s]);
+            ok = ok && p.runs == 1 && p.tuples == SizeT(entityCount) &&
+                 p.added == p.removed;
+            systemUs[s] += p.processUs;
+        }
+        for(auto p(0u); p < refreshUs.size(); ++p)
+            refreshUs[p] += f.refreshUs[p];
+    }
+
+    const auto& count(profiler.getFrameCount());
+    ssvu::lo("Movement") << systemUs[0] / count << " us/frame\n";
+    ssvu::lo("Life") << systemUs[1] / count << " us/frame\n";
+    ssvu::lo("Refresh") << refreshUs[0] / count << " us commands, "
+                        << refreshUs[1] / count << " us leave, "
+                        << refreshUs[2] / count << " us match\n";
+
+    std::ostringstream csv, trace;
+    profiler.dumpCSV(csv);
+    profiler.dumpChromeTrace(trace);
+    ok = ok && csv.str().find("\n101,system,Life,1,100000,") !=
+                   std::string::npos &&
+         trace.str().find("\"name\":\"refresh match\"") != std::string::npos;
+
+    std::ofstream{"CESystemProfile.csv"} << csv.str();
+    std::ofstream{"CESystemProfile.json"} << trace.str();
+    ssvu::lo("Profile") << "wrote CESystemProfile.csv and .json\n";
+
+    if(!ok) ssvu::lo("Profile") << "ERROR: unexpected profile\n";
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
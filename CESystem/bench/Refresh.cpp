@@ -0,0 +1,188 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Measures `Manager::refresh` on a large world as the number of entities
+// changed per frame grows, checking systems and groups stay consistent.
+//
+// The changes are made right before `refresh`, which finds the changed
+// entities in the L2 cache and the TLB as long as they fit there, so small
+// batches cost less per change than large ones. Every other frame first
+// writes a buffer larger than both ("cold"), which is closer to changes
+// spread over a whole frame. Times are medians over the frames.
+//
+// Also checks that entities destroyed by `added` hooks during a refresh are
+// removed by that same refresh.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int entityCount{500000};
+static constexpr int frames{50};
+static constexpr SizeT evictBytes{64 * 1024 * 1024};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct CPosition : Component
+{
+    float x, y;
+    CPosition(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CVelocity : Component
+{
+    float x, y;
+    CVelocity(float mX, float mY) : x{mX}, y{mY} {}
+};
+
+struct CKill : Component
+{
+    Entity* victim;
+    CKill(Entity& mVictim) : victim{&mVictim} {}
+};
+
+struct SCount : System<SCount, Req<CPosition>, Not<CVelocity>>
+{
+    SizeT count{0}, addedCount{0}, removedCount{0};
+
+    inline void process(Entity&, CPosition&) { ++count; }
+    inline void added(Entity&, CPosition&) { ++addedCount; }
+    inline void removed(Entity&, CPosition&) { ++removedCount; }
+};
+
+// Destroys each new killer and its victim
+struct SKill : System<SKill, Req<CKill>>
+{
+    inline void process(Entity&, CKill&) {}
+    inline void added(Entity& mEntity, CKill& cKill)
+    {
+        mEntity.destroy();
+        cKill.victim->destroy();
+    }
+};
+
+inline void spawn(Manager& mManager, int mIdx)
+{
+    auto e(mManager.createEntity());
+    e.createComponent<CPosition>(0.f, 0.f);
+    if(mIdx % 2 == 0) e.createComponent<CVelocity>(0.f, 0.f);
+    if(mIdx % 3 == 0) e.addGroups(0);
+}
+
+inline void evictCaches()
+{
+    static std::vector<char> buffer(evictBytes);
+    for(auto& c : buffer) ++c;
+}
+
+// Destroys and respawns `mChanges` entities per frame, and toggles the
+// group of as many others; returns whether the world is consistent
+inline bool bench(int mChanges)
+{
+    Manager manager;
+    SCount sCount;
+    manager.registerSystem(sCount);
+
+    for(int i{0}; i < entityCount; ++i) spawn(manager, i);
+    manager.refresh();
+
+    std::vector<double> warmUs, coldUs;
+    for(int f{0}; f < frames; ++f)
+    {
+        auto& entities(manager.getEntities());
+        for(int i{0}; i < mChanges; ++i)
+        {
+            auto& e(*entities[(f * 7919 + i * 104729) % entities.size()]);
+            if(i % 2 == 0)
+                e.destroy();
+            else if(e.hasGroup(0))
+                e.delGroups(0);
+            else
+                e.addGroups(0);
+        }
+        for(int i{0}; i < mChanges / 2; ++i) spawn(manager, i);
+
+        const auto& evicted(f % 2 == 1);
+        if(evicted) evictCaches();
+
+        auto start(Clock::now());
+        manager.refresh();
+        (evicted ? coldUs : warmUs)
+            .emplace_back(std::chrono::duration<double, std::micro>(
+                Clock::now() - start).count());
+    }
+
+    // Check systems and groups against the entities
+    SizeT expectedCount{0}, expectedGrouped{0};
+    for(const auto& e : manager.getEntities())
+    {
+        if(!e->hasComponent<CVelocity>()) ++expectedCount;
+        if(e->hasGroup(0)) ++expectedGrouped;
+    }
+
+    sCount.count = 0;
+    sCount.processAll();
+
+    bool ok{sCount.count == expectedCount &&
+            sCount.addedCount - sCount.removedCount == expectedCount &&
+            manager.getEntityCount(0) == expectedGrouped};
+    for(const auto& e : manager.getEntities(0)) ok = ok && e->hasGroup(0);
+
+    // A single slow frame would skew a mean
+    auto getMedian([](std::vector<double>& mUs)
+        {
+            const auto& mid(std::begin(mUs) + mUs.size() / 2);
+            std::nth_element(std::begin(mUs), mid, std::end(mUs));
+            return *mid;
+        });
+
+    ssvu::lo("Refresh") << mChanges << " changes/frame: " << getMedian(warmUs)
+                        << " us/refresh warm, " << getMedian(coldUs)
+                        << " us/refresh cold" << (ok ? "" : " - ERROR")
+                        << "\n";
+    return ok;
+}
+
+// Victims are created before or after their killer, so that they are
+// destroyed after or before being matched themselves
+inline bool checkHooks()
+{
+    Manager manager;
+    SCount sCount;
+    SKill sKill;
+    manager.registerSystem(sCount);
+    manager.registerSystem(sKill);
+
+    for(int i{0}; i < 1000; ++i)
+    {
+        auto first(manager.createEntity()), second(manager.createEntity());
+        auto& killer(i % 2 == 0 ? first : second);
+        auto& victim(i % 2 == 0 ? second : first);
+        victim.createComponent<CPosition>(0.f, 0.f);
+        killer.createComponent<CKill>(victim.getEntity());
+    }
+    for(int i{0}; i < 3; ++i)
+        manager.createEntity().createComponent<CPosition>(0.f, 0.f);
+    manager.refresh();
+
+    sCount.count = 0;
+    sCount.processAll();
+
+    const auto& ok(manager.getEntityCount() == 3 && sCount.count == 3 &&
+                   sCount.addedCount - sCount.removedCount == 3);
+    if(!ok)
+        ssvu::lo("Refresh") << "ERROR: " << manager.getEntityCount()
+                            << " entities left after hooks destroyed them\n";
+    return ok;
+}
+
+int main()
+{
+    bool ok{checkHooks()};
+    for(const auto& c : {0, 10, 100, 1000, 10000}) ok = bench(c) && ok;
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Runs the same frames with `Manager` and with a
+// `BasicManager<ComponentList<...>>`, whose component indices and system
+// signatures are resolved at compile time, checking that both produce the
+// same world.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int entityCount{100000};
+static constexpr int frames{50};
+static constexpr int rematchesPerFrame{10000};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct CPosition : Component
+{
+    float x, y;
+    CPosition(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CVelocity : Component
+{
+    float x, y;
+    CVelocity(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CLife : Component
+{
+    int life;
+    CLife(int mLife) : life{mLife} {}
+};
+struct CDead : Component
+{
+};
+
+using Components = ComponentList<CPosition, CVelocity, CLife, CDead>;
+
+// Indices, signatures and the bitset width are known at compile time
+static_assert(Components::getIdx<const CLife>() == 2, "");
+static_assert(sizeof(Components::Bitset) == 1, "");
+static_assert(Req<CPosition, const CVelocity>::getTypeIds<Components>() ==
+                  Components::getBitset<CVelocity, CPosition>(),
+    "");
+static_assert(Req<CPosition, const CVelocity>::getWriteTypeIds<Components>()
+                      .count() == 1,
+    "");
+
+template <typename TRegistry>
+struct SMovement : BasicSystem<TRegistry, SMovement<TRegistry>,
+                       Req<CPosition, const CVelocity>>
+{
+    using Entity = BasicEntity<TRegistry>;
+
+    inline void process(
+        Entity&, CPosition& cPosition, const CVelocity& cVelocity)
+    {
+        cPosition.x += cVelocity.x;
+        cPosition.y += cVelocity.y;
+    }
+};
+
+// Marks expired entities through the command buffer
+template <typename TRegistry>
+struct SLife
+    : BasicSystem<TRegistry, SLife<TRegistry>, Req<CLife>, Not<CDead>>
+{
+    using Entity = BasicEntity<TRegistry>;
+
+    BasicManager<TRegistry>& manager;
+    inline SLife(BasicManager<TRegistry>& mManager) : manager(mManager) {}
+
+    inline void process(Entity& mEntity, CLife& cLife)
+    {
+        if(--cLife.life > 0) return;
+
+        auto deferred(manager.getCommands().get(mEntity));
+        deferred.template createComponent<CDead>();
+    }
+};
+
+struct Result
+{
+    Clock::duration duration;
+    double checksum;
+};
+
+template <typename TRegistry>
+inline Result run()
+{
+    BasicManager<TRegistry> manager;
+    SMovement<TRegistry> sMovement;
+    SLife<TRegistry> sLife{manager};
+    manager.registerSystem(sMovement);
+    manager.registerSystem(sLife);
+
+    for(int i{0}; i < entityCount; ++i)
+    {
+        auto e(manager.createEntity());
+        e.template createComponent<CPosition>(0.f, 0.f);
+        e.template createComponent<CVelocity>(float(i % 13), 1.f);
+        e.template createComponent<CLife>(i % 97 + 1);
+    }
+    manager.refresh();
+
+    auto start(Clock::now());
+    for(int f{0}; f < frames; ++f)
+    {
+        sMovement.processAll();
+        sLife.processAll();
+
+        // Toggling a component makes the entity match systems again
+        auto& entities(manager.getEntities());
+        for(int i{0}; i < rematchesPerFrame; ++i)
+        {
+            auto& e(*entities[(f * rematchesPerFrame + i) % entityCount]);
+            if(e.template hasComponent<CVelocity>())
+                e.template removeComponent<CVelocity>();
+            else
+                e.template createComponent<CVelocity>(1.f, 0.f);
+        }
+
+        manager.refresh();
+    }
+
+    Result result{Clock::now() - start, 0.0};
+    for(const auto& e : manager.getEntities())
+    {
+        const auto& cPosition(e->template getComponent<CPosition>());
+        result.checksum += cPosition.x + cPosition.y;
+        if(e->template hasComponent<CDead>()) result.checksum += 1000.0;
+    }
+    return result;
+}
+
+inline void print(const std::string& mTitle, const Result& mResult)
+{
+    ssvu::lo(mTitle)
+        << std::chrono::duration<double, std::milli>(mResult.duration).count() /
+               frames
+        << " ms/frame, checksum " << mResult.checksum << "\n";
+}
+
+int main()
+{
+    const auto& dynamic(run<DynamicComponents>());
+    print("DynamicComponents", dynamic);
+
+    const auto& list(run<Components>());
+    print("ComponentList", list);
+
+    ssvu::lo("Registry") << "sizeof(Entity): " << sizeof(Entity) << " vs "
+                         << sizeof(BasicEntity<Components>) << " bytes\n";
+
+    const auto& ok(dynamic.checksum == list.checksum);
+    if(!ok) ssvu::lo("Registry") << "ERROR: results differ\n";
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Runs the same frames sequentially, with `Scheduler` running independent
+// systems concurrently, and with each system also split into parallel
+// chunks, checking that all three produce the same world.
+
+#include <chrono>
+#include <cmath>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int entityCount{200000};
+static constexpr int frames{20};
+static constexpr SizeT minChunk{4096};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct CPosition : Component
+{
+    float x, y;
+    CPosition(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CVelocity : Component
+{
+    float x, y;
+    CVelocity(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CHealth : Component
+{
+    float health;
+    CHealth(float mHealth) : health{mHealth} {}
+};
+struct CRegen : Component
+{
+    float rate;
+    CRegen(float mRate) : rate{mRate} {}
+};
+struct CAge : Component
+{
+    float age{0};
+};
+
+// Writes `CPosition`, reads `CVelocity`
+struct SMovement
+    : System<SMovement, Req<CPosition, const CVelocity>>
+{
+    inline void process(
+        Entity&, CPosition& cPosition, const CVelocity& cVelocity, FT mFT)
+    {
+        cPosition.x += std::cos(cVelocity.x) * mFT;
+        cPosition.y += std::sin(cVelocity.y) * mFT;
+    }
+};
+
+// Writes `CVelocity`, so it waits for `SMovement`
+struct SDamping : System<SDamping, Req<CVelocity>>
+{
+    inline void process(Entity&, CVelocity& cVelocity, FT mFT)
+    {
+        cVelocity.x *= std::pow(0.99f, mFT);
+        cVelocity.y *= std::pow(0.98f, mFT);
+    }
+};
+
+// Independent from the systems above
+struct SRegen : System<SRegen, Req<CHealth, const CRegen>>
+{
+    inline void process(
+        Entity&, CHealth& cHealth, const CRegen& cRegen, FT mFT)
+    {
+        cHealth.health = std::min(
+            100.f, cHealth.health + std::sqrt(cRegen.rate * mFT));
+    }
+};
+struct SAging : System<SAging, Req<CAge>>
+{
+    inline void process(Entity&, CAge& cAge, FT mFT)
+    {
+        cAge.age += std::exp(-cAge.age * 0.01f) * mFT;
+    }
+};
+
+struct World
+{
+    Manager manager;
+    SMovement sMovement;
+    SDamping sDamping;
+    SRegen sRegen;
+    SAging sAging;
+
+    inline World()
+    {
+        manager.registerSystem(sMovement);
+        manager.registerSystem(sDamping);
+        manager.registerSystem(sRegen);
+        manager.registerSystem(sAging);
+
+        for(int i{0}; i < entityCount; ++i)
+        {
+            const auto& f(float(i % 101) / 101.f);
+            auto e(manager.createEntity());
+
+            e.createComponent<CPosition>(f, -f);
+            e.createComponent<CVelocity>(1.f - f, f);
+            if(i % 2 == 0) e.createComponent<CHealth>(f * 50.f);
+            if(i % 3 == 0) e.createComponent<CRegen>(f);
+            if(i % 5 != 0) e.createComponent<CAge>();
+        }
+
+        manager.refresh();
+    }
+
+    inline double getChecksum()
+    {
+        double result{0};
+        for(const auto& e : manager.getEntities())
+        {
+            if(e->hasComponent<CPosition>())
+                result += e->getComponent<CPosition>().x +
+                          e->getComponent<CPosition>().y;
+            if(e->hasComponent<CVelocity>())
+                result += e->getComponent<CVelocity>().x;
+            if(e->hasComponent<CHealth>())
+                result += e->getComponent<CHealth>().health;
+            if(e->hasComponent<CAge>()) result += e->getComponent<CAge>().age;
+        }
+        return result;
+    }
+};
+
+struct Result
+{
+    Clock::duration duration;
+    double checksum;
+};
+
+// `mSetup` adds the world's systems to a scheduler, or is empty for the
+// sequential run
+template <typename TSetup>
+inline Result run(ThreadPool& mPool, bool mSequential, const TSetup& mSetup)
+{
+    World world;
+    Scheduler scheduler{mPool};
+    mSetup(world, scheduler);
+
+    auto start(Clock::now());
+    for(int i{0}; i < frames; ++i)
+    {
+        if(mSequential)
+        {
+            world.sMovement.processAll(1.f);
+            world.sDamping.processAll(1.f);
+            world.sRegen.processAll(1.f);
+            world.sAging.processAll(1.f);
+        }
+        else
+            scheduler.run();
+
+        world.manager.refresh();
+    }
+
+    return {Clock::now() - start, world.getChecksum()};
+}
+
+inline void print(const std::string& mTitle, const Result& mResult)
+{
+    ssvu::lo(mTitle)
+        << std::chrono::duration<double, std::milli>(mResult.duration).count() /
+               frames
+        << " ms/frame\n";
+}
+
+int main()
+{
+    ThreadPool pool;
+    ssvu::lo("ThreadPool") << pool.getWorkerCount() << " workers\n";
+
+    const auto& sequential(run(pool, true, [](World&, Scheduler&)
+        {
+        }));
+    print("Sequential", sequential);
+
+    const auto& scheduled(run(pool, false, [](World& mW, Scheduler& mS)
+        {
+            mS.add(mW.sMovement, [&mW]
+                {
+                    mW.sMovement.processAll(1.f);
+                });
+            mS.add(mW.sDamping, [&mW]
+                {
+                    mW.sDamping.processAll(1.f);
+                });
+            mS.add(mW.sRegen, [&mW]
+                {
+                    mW.sRegen.processAll(1.f);
+                });
+            mS.add(mW.sAging, [&mW]
+                {
+                    mW.sAging.processAll(1.f);
+                });
+        }));
+    print("Scheduler", scheduled);
+
+    const auto& chunked(run(pool, false, [&pool](World& mW, Scheduler& mS)
+        {
+            mS.add(mW.sMovement, [&]
+                {
+                    mW.sMovement.processAllParallel(pool, minChunk, 1.f);
+                });
+            mS.add(mW.sDamping, [&]
+                {
+                    mW.sDamping.processAllParallel(pool, minChunk, 1.f);
+                });
+            mS.add(mW.sRegen, [&]
+                {
+                    mW.sRegen.processAllParallel(pool, minChunk, 1.f);
+                });
+            mS.add(mW.sAging, [&]
+                {
+                    mW.sAging.processAllParallel(pool, minChunk, 1.f);
+                });
+        }));
+    print("Scheduler + chunks", chunked);
+
+    const auto& ok(sequential.checksum == scheduled.checksum &&
+                   sequential.checksum == chunked.checksum);
+
+    if(!ok) ssvu::lo("Scheduler") << "ERROR: results differ\n";
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
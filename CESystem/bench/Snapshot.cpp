@@ -0,0 +1,270 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Times snapshots and restores of a world, as medians and minimums over the
+// repeats, then checks that running the same frames after restoring it, in
+// the same manager and in another one, gives the same world as the first run,
+// and that truncated snapshots are rejected.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int entityCount{50000};
+static constexpr int frames{30};
+static constexpr int repeats{20};
+static constexpr Group groupCount{4};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct CPosition : Component
+{
+    float x, y;
+    CPosition(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CVelocity : Component
+{
+    float x, y;
+    CVelocity(float mX, float mY) : x{mX}, y{mY} {}
+};
+struct CLife : Component
+{
+    int life;
+    CLife(int mLife) : life{mLife} {}
+};
+struct CName : Component
+{
+    std::string name;
+    CName(std::string mName) : name{ssvu::mv(mName)} {}
+};
+
+namespace ssvces
+{
+    template <>
+    struct ComponentSerializer<CPosition>
+        : TrivialComponentSerializer<CPosition, float, float>
+    {
+        inline static auto getFields(const CPosition& mC)
+        {
+            return std::tie(mC.x, mC.y);
+        }
+    };
+    template <>
+    struct ComponentSerializer<CVelocity>
+        : TrivialComponentSerializer<CVelocity, float, float>
+    {
+        inline static auto getFields(const CVelocity& mC)
+        {
+            return std::tie(mC.x, mC.y);
+        }
+    };
+    template <>
+    struct ComponentSerializer<CLife> : TrivialComponentSerializer<CLife, int>
+    {
+        inline static auto getFields(const CLife& mC)
+        {
+            return std::tie(mC.life);
+        }
+    };
+
+    // Length-prefixed characters
+    template <>
+    struct ComponentSerializer<CName>
+    {
+        inline static void save(SnapshotWriter& mWriter, const CName& mName)
+        {
+            mWriter.write(std::uint32_t(mName.name.size()));
+            mWriter.write(mName.name.data(), mName.name.size());
+        }
+        inline static CName load(SnapshotReader& mReader)
+        {
+            const auto& size(mReader.read<std::uint32_t>());
+            return {std::string(mReader.skip(size), size)};
+        }
+    };
+}
+
+struct SMovement : System<SMovement, Req<CPosition, const CVelocity>>
+{
+    inline void process(
+        Entity&, CPosition& cPosition, const CVelocity& cVelocity)
+    {
+        cPosition.x += cVelocity.x;
+        cPosition.y += cVelocity.y * 0.5f;
+    }
+};
+
+// Replaces expired entities through the command buffer, so that ids are
+// recycled and groups change every frame. Systems keep no state of their
+// own, which snapshots would not capture.
+struct SLife : System<SLife, Req<CLife>>
+{
+    Manager& manager;
+    inline SLife(Manager& mManager) : manager(mManager) {}
+
+    inline void process(Entity& mEntity, CLife& cLife)
+    {
+        if(--cLife.life > 0) return;
+
+        // Every entity is in a single group
+        Group group{0};
+        while(!mEntity.hasGroup(group)) ++group;
+
+        auto& commands(manager.getCommands());
+        commands.get(mEntity).destroy();
+
+        auto e(commands.createEntity());
+        e.createComponent<CPosition>(float(group), 0.f);
+        e.createComponent<CVelocity>(1.f, 2.f);
+        e.createComponent<CLife>(17);
+        e.addGroups((group + 1) % groupCount);
+    }
+};
+
+struct World
+{
+    Manager manager;
+    SMovement sMovement;
+    SLife sLife{manager};
+
+    inline World()
+    {
+        manager.registerSystem(sMovement);
+        manager.registerSystem(sLife);
+    }
+
+    inline void populate()
+    {
+        for(int i{0}; i < entityCount; ++i)
+        {
+            auto e(manager.createEntity());
+            e.createComponent<CPosition>(float(i), 0.f);
+            e.createComponent<CVelocity>(float(i % 7), 1.f);
+            e.createComponent<CLife>(i % 40 + 1);
+            if(i % 3 == 0)
+                e.createComponent<CName>("entity" + ssvu::toStr(i));
+            e.addGroups(Group(i % groupCount));
+        }
+        manager.refresh();
+    }
+
+    inline void snapshot(Snapshot& mSnapshot) const
+    {
+        manager.snapshot<CPosition, CVelocity, CLife, CName>(mSnapshot);
+    }
+    inline bool restore(const Snapshot& mSnapshot)
+    {
+        return manager.restore<CPosition, CVelocity, CLife, CName>(mSnapshot);
+    }
+
+    inline void run()
+    {
+        for(int i{0}; i < frames; ++i)
+        {
+            sMovement.processAll();
+            sLife.processAll();
+            manager.refresh();
+        }
+    }
+
+    // Depends on entity, group and tuple order
+    inline double getChecksum() const
+    {
+        double result{0};
+        const auto& entities(manager.getEntities());
+        for(auto i(0u); i < entities.size(); ++i)
+        {
+            auto& e(*entities[i]);
+            const auto& cPosition(e.getComponent<CPosition>());
+            result += (i % 13) * (cPosition.x + cPosition.y);
+            result += e.getComponent<CLife>().life;
+            if(e.hasComponent<CName>())
+                result += e.getComponent<CName>().name.size();
+        }
+
+        for(Group g{0}; g < groupCount; ++g)
+        {
+            const auto& grouped(manager.getEntities(g));
+            for(auto i(0u); i < grouped.size(); ++i)
+                result += (i % 11) * grouped[i]->getComponent<CLife>().life;
+        }
+
+        return result + manager.getEntityCount();
+    }
+};
+
+inline double toMs(Clock::duration mDuration)
+{
+    return std::chrono::duration<double, std::milli>(mDuration).count();
+}
+
+int main()
+{
+    World world;
+    world.populate();
+    world.run();
+
+    // A single slow repeat would skew a mean
+    std::vector<double> snapshotMs, restoreMs;
+    const auto& timeRepeats([](std::vector<double>& mMs, auto mFn)
+        {
+            for(int i{0}; i < repeats; ++i)
+            {
+                const auto& start(Clock::now());
+                mFn();
+                mMs.emplace_back(toMs(Clock::now() - start));
+            }
+
+            const auto& mid(std::begin(mMs) + mMs.size() / 2);
+            std::nth_element(std::begin(mMs), mid, std::end(mMs));
+            return *std::min_element(std::begin(mMs), std::end(mMs));
+        });
+
+    Snapshot snapshot;
+    const auto& snapshotMin(
+        timeRepeats(snapshotMs, [&] { world.snapshot(snapshot); }));
+    const auto& restoreMin(
+        timeRepeats(restoreMs, [&] { world.restore(snapshot); }));
+
+    ssvu::lo("Snapshot") << snapshot.getSize() / 1024 << " KB, "
+                         << snapshotMs[repeats / 2] << " ms median, "
+                         << snapshotMin << " ms min\n";
+    ssvu::lo("Restore") << restoreMs[repeats / 2] << " ms median, "
+                        << restoreMin << " ms min\n";
+
+    // Same frames from the snapshot, in this manager and in a new one
+    // restored from a copy of the blob
+    world.run();
+    const auto& expected(world.getChecksum());
+
+    world.restore(snapshot);
+    world.run();
+    const auto& again(world.getChecksum());
+
+    World other;
+    other.restore(Snapshot{snapshot.getData(), snapshot.getSize()});
+    other.run();
+    const auto& copied(other.getChecksum());
+
+    ssvu::lo("Checksums") << expected << ", " << again << ", " << copied
+                          << "\n";
+
+    bool ok{expected == again && expected == copied};
+    if(!ok) ssvu::lo("Snapshot") << "ERROR: restored worlds differ\n";
+
+    // Neither may touch the world
+    const auto& rejected(
+        !other.restore(Snapshot{snapshot.getData(), snapshot.getSize() - 1}) &&
+        !other.restore(Snapshot{}) && other.getChecksum() == copied);
+    if(!rejected)
+    {
+        ssvu::lo("Snapshot") << "ERROR: truncated snapshot restored\n";
+        ok = false;
+    }
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
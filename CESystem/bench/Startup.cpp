@@ -0,0 +1,83 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Creates many short-lived managers holding small worlds, and checks the
+// id pool's reuse and liveness semantics.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "CESystem/CES.hpp"
+
+using namespace ssvces;
+
+static constexpr int managerCount{1000};
+static constexpr int entityCount{200};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct CPosition : Component
+{
+    float x, y;
+    CPosition(float mX, float mY) : x{mX}, y{mY} {}
+};
+
+struct SMovement : System<SMovement, Req<CPosition>>
+{
+    inline void process(Entity&, CPosition& cPosition)
+    {
+        cPosition.x += 1.f;
+    }
+};
+
+inline bool checkIdPool()
+{
+    Impl::IdPool pool;
+    if(pool.getCapacity() != 0) return false;
+
+    const auto& a(pool.getAvailable());
+    const auto& b(pool.getAvailable());
+    if(a.id == b.id || !pool.isAlive(a) || !pool.isAlive(b)) return false;
+
+    // Reclaimed ids are reused last-in first-out, with a new counter
+    pool.reclaim(a);
+    pool.reclaim(a);
+    const auto& c(pool.getAvailable());
+
+    return !pool.isAlive(a) && pool.isAlive(b) && pool.isAlive(c) &&
+           c.id == a.id && c.ctr == a.ctr + 1 && pool.getCapacity() == 2;
+}
+
+int main()
+{
+    const auto& ok(checkIdPool());
+    if(!ok) ssvu::lo("IdPool") << "ERROR: unexpected id pool behavior\n";
+
+    ssvu::lo("Startup") << "sizeof(Manager): " << sizeof(Manager)
+                        << " bytes\n";
+
+    SizeT processed{0};
+    auto start(Clock::now());
+    for(int m{0}; m < managerCount; ++m)
+    {
+        Manager manager;
+        SMovement sMovement;
+        manager.registerSystem(sMovement);
+
+        for(int i{0}; i < entityCount; ++i)
+            manager.createEntity().createComponent<CPosition>(0.f, 0.f);
+
+        manager.refresh();
+        sMovement.processAll();
+        processed += manager.getEntityCount();
+    }
+
+    const auto& duration(Clock::now() - start);
+    ssvu::lo("Startup")
+        << managerCount << " managers with " << entityCount << " entities: "
+        << std::chrono::duration<double, std::milli>(duration).count()
+        << " ms (" << processed << " entities)\n";
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
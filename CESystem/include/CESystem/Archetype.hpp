@@ -0,0 +1,189 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_ARCHETYPE
+#define CESYSTEM_ARCHETYPE
+
+namespace ssvces
+{
+    namespace Impl
+    {
+        // Type-erased contiguous array of components of a single type
+        class ColumnBase
+        {
+        public:
+            inline virtual ~ColumnBase() noexcept {}
+
+            // Returns an empty column storing the same type
+            virtual ssvu::UPtr<ColumnBase> createEmpty() const = 0;
+
+            // Moves element `mIdx` of `mSrc` (same type) to the back
+            virtual void pushFrom(ColumnBase& mSrc, SizeT mIdx) = 0;
+
+            // Moves element `mSrcIdx` of `mSrc` (same type) over `mIdx`
+            virtual void assignFrom(
+                ColumnBase& mSrc, SizeT mSrcIdx, SizeT mIdx) = 0;
+
+            virtual void popBack() noexcept = 0;
+        };
+
+        template <typename T>
+        class Column final : public ColumnBase
+        {
+        private:
+            std::vector<T> data;
+
+        public:
+            inline Column() { data.reserve(archetypeChunkCapacity); }
+
+            inline ssvu::UPtr<ColumnBase> createEmpty() const override
+            {
+                return std::make_unique<Column<T>>();
+            }
+            inline void pushFrom(ColumnBase& mSrc, SizeT mIdx) override
+            {
+                data.emplace_back(
+                    ssvu::mv(ssvu::castUp<Column<T>>(mSrc).data[mIdx]));
+            }
+            inline void assignFrom(
+                ColumnBase& mSrc, SizeT mSrcIdx, SizeT mIdx) override
+            {
+                data[mIdx] =
+                    ssvu::mv(ssvu::castUp<Column<T>>(mSrc).data[mSrcIdx]);
+            }
+            inline void popBack() noexcept override { data.pop_back(); }
+
+            template <typename... TArgs>
+            inline void emplace(TArgs&&... mArgs)
+            {
+                data.emplace_back(FWD(mArgs)...);
+            }
+            inline void fill(SizeT mCount, const T& mValue)
+            {
+                data.insert(std::end(data), mCount, mValue);
+            }
+
+            inline T* getData() noexcept { return data.data(); }
+        };
+
+        // Fixed-capacity block of entities sharing an archetype, with one
+        // column per component type. Columns never reallocate, as they are
+        // reserved to `archetypeChunkCapacity` elements.
+        struct ArchetypeChunk
+        {
+            std::array<ssvu::UPtr<ColumnBase>, maxComponents> columns;
+            std::vector<EntityStat> stats;
+
+            inline SizeT getSize() const noexcept { return stats.size(); }
+            inline bool isFull() const noexcept
+            {
+                return stats.size() == archetypeChunkCapacity;
+            }
+
+            template <typename T>
+            inline T* getData() noexcept
+            {
+                return ssvu::castUp<Column<std::remove_const_t<T>>>(
+                    *columns[getTypeIdx<T>()]).getData();
+            }
+        };
+
+        // Position of an entity inside its archetype
+        struct ArchetypeLocation
+        {
+            Archetype* archetype{nullptr};
+            SizeT chunk{0}, row{0};
+            bool mustDestroy{false};
+        };
+
+        // Set of entities with the same `TypeIdxBitset`. Entities are packed
+        // into chunks, and every chunk but the last one is full.
+        class Archetype
+        {
+            friend ssvces::ArchetypeManager;
+            template <typename, typename, typename>
+            friend class ssvces::ArchetypeSystem;
+
+        private:
+            TypeIdxBitset typeIds;
+            std::vector<TypeIdx> typeIdxs;
+            std::array<ssvu::UPtr<ColumnBase>, maxComponents> prototypes;
+            std::vector<ssvu::UPtr<ArchetypeChunk>> chunks;
+            std::vector<ArchetypeSystemBase*> systems;
+
+            // Cached transitions to the archetypes obtained by adding or
+            // removing a component type
+            std::array<Archetype*, maxComponents> nextAdd{}, nextDel{};
+
+            // Returns the chunk new entities are appended to
+            inline ArchetypeChunk& getBackChunk()
+            {
+                if(chunks.empty() || chunks.back()->isFull())
+                {
+                    auto chunk(std::make_unique<ArchetypeChunk>());
+                    chunk->stats.reserve(archetypeChunkCapacity);
+                    for(const auto& t : typeIdxs)
+                        chunk->columns[t] = prototypes[t]->createEmpty();
+                    chunks.emplace_back(ssvu::mv(chunk));
+                }
+
+                return *chunks.back();
+            }
+
+            // Removes the entity at `mLoc`, moving the last entity of the
+            // archetype in its place. Returns the moved entity's id, or -1.
+            inline EntityId erase(const ArchetypeLocation& mLoc) noexcept
+            {
+                auto& chunk(*chunks[mLoc.chunk]);
+                auto& last(*chunks.back());
+                const auto& lastRow(last.getSize() - 1);
+                EntityId moved{-1};
+
+                if(&chunk != &last || mLoc.row != lastRow)
+                {
+                    for(const auto& t : typeIdxs)
+                        chunk.columns[t]->assignFrom(
+                            *last.columns[t], lastRow, mLoc.row);
+
+                    chunk.stats[mLoc.row] = last.stats[lastRow];
+                    moved = chunk.stats[mLoc.row].id;
+                }
+
+                for(const auto& t : typeIdxs) last.columns[t]->popBack();
+                last.stats.pop_back();
+
+                if(last.stats.empty()) chunks.pop_back();
+                return moved;
+            }
+
+        public:
+            inline Archetype(const TypeIdxBitset& mTypeIds) : typeIds{mTypeIds}
+            {
+                for(auto i(0u); i < maxComponents; ++i)
+                    if(typeIds[i]) typeIdxs.emplace_back(i);
+            }
+
+            inline Archetype(const Archetype&) = delete;
+            inline Archetype& operator=(const Archetype&) = delete;
+
+            inline const TypeIdxBitset& getTypeIds() const noexcept
+            {
+                return typeIds;
+            }
+            inline SizeT getChunkCount() const noexcept
+            {
+                return chunks.size();
+            }
+            inline SizeT getEntityCount() const noexcept
+            {
+                return chunks.empty()
+                           ? 0
+                           : (chunks.size() - 1) * archetypeChunkCapacity +
+                                 chunks.back()->getSize();
+            }
+        };
+    }
+}
+
+#endif
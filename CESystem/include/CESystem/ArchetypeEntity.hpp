@@ -0,0 +1,47 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_ARCHETYPEENTITY
+#define CESYSTEM_ARCHETYPEENTITY
+
+namespace ssvces
+{
+    // Handle to an entity stored by `ArchetypeManager`. Entities have no
+    // object of their own: the handle only holds the entity's id, which
+    // locates its row in an archetype chunk.
+    class ArchetypeEntity
+    {
+    private:
+        ArchetypeManager* manager;
+        EntityStat stat;
+
+    public:
+        inline ArchetypeEntity(
+            ArchetypeManager& mManager, const EntityStat& mStat) noexcept
+            : manager(&mManager),
+              stat(mStat)
+        {
+        }
+
+        // Moves the entity to another archetype, or queues the change if a
+        // system is being processed
+        template <typename T, typename... TArgs>
+        inline void createComponent(TArgs&&... mArgs);
+        template <typename T>
+        inline void removeComponent();
+
+        template <typename T>
+        inline bool hasComponent() const noexcept;
+        template <typename T>
+        inline T& getComponent() noexcept;
+
+        inline void destroy() noexcept;
+        inline bool isAlive() const noexcept;
+
+        inline ArchetypeManager& getManager() noexcept { return *manager; }
+        inline const EntityStat& getStat() const noexcept { return stat; }
+    };
+}
+
+#endif
@@ -0,0 +1,69 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_ARCHETYPEENTITY_INL
+#define CESYSTEM_ARCHETYPEENTITY_INL
+
+namespace ssvces
+{
+    template <typename T, typename... TArgs>
+    inline void ArchetypeEntity::createComponent(TArgs&&... mArgs)
+    {
+        SSVU_ASSERT_STATIC(
+            ssvu::isBaseOf<Component, T>(), "`T` must derive from `Component`");
+        manager->createComponent<T>(stat, FWD(mArgs)...);
+    }
+    template <typename T>
+    inline void ArchetypeEntity::removeComponent()
+    {
+        SSVU_ASSERT_STATIC(
+            ssvu::isBaseOf<Component, T>(), "`T` must derive from `Component`");
+        manager->removeComponent<T>(stat);
+    }
+    template <typename T>
+    inline bool ArchetypeEntity::hasComponent() const noexcept
+    {
+        SSVU_ASSERT(isAlive());
+        return manager->hasComponent<T>(stat);
+    }
+    template <typename T>
+    inline T& ArchetypeEntity::getComponent() noexcept
+    {
+        SSVU_ASSERT(isAlive());
+        return manager->getComponent<T>(stat);
+    }
+    inline void ArchetypeEntity::destroy() noexcept { manager->destroy(stat); }
+    inline bool ArchetypeEntity::isAlive() const noexcept
+    {
+        return manager->isAlive(stat);
+    }
+
+    template <typename TDerived, typename... TReqs, typename TNot>
+    template <typename... TArgs>
+    inline void ArchetypeSystem<TDerived, Req<TReqs...>, TNot>::processAll(
+        TArgs&&... mArgs)
+    {
+        SSVU_ASSERT(manager != nullptr);
+        manager->beginIteration();
+
+        for(auto& a : archetypes)
+            for(auto& c : a->chunks)
+            {
+                auto& chunk(*c);
+                const auto& data(
+                    std::make_tuple(chunk.template getData<TReqs>()...));
+
+                for(auto i(0u); i < chunk.getSize(); ++i)
+                {
+                    ArchetypeEntity entity{*manager, chunk.stats[i]};
+                    getTD().process(
+                        entity, std::get<TReqs*>(data)[i]..., mArgs...);
+                }
+            }
+
+        manager->endIteration();
+    }
+}
+
+#endif
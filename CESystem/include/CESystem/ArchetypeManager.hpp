@@ -0,0 +1,401 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_ARCHETYPEMANAGER
+#define CESYSTEM_ARCHETYPEMANAGER
+
+namespace ssvces
+{
+    // Alternative to `Manager` storing components by value, grouped by
+    // archetype (the entity's `TypeIdxBitset`). Each archetype keeps its
+    // entities in chunks with one contiguous array per component type, so
+    // systems walk memory linearly instead of following a pointer per
+    // component. Adding or removing a component moves the entity to another
+    // archetype, hence components must be move constructible and assignable.
+    class ArchetypeManager
+    {
+        friend ArchetypeEntity;
+        template <typename, typename, typename>
+        friend class ArchetypeSystem;
+
+    private:
+        Impl::IdPool entityIdPool;
+        std::vector<Impl::ArchetypeLocation> locations;
+        std::vector<ssvu::UPtr<Impl::Archetype>> archetypes;
+        std::unordered_map<TypeIdxBitset, Impl::Archetype*> archetypeMap;
+        Impl::Archetype* root{nullptr}; // Archetype without components
+        std::vector<Impl::ArchetypeSystemBase*> systems;
+        std::vector<EntityStat> toDestroy;
+        SizeT entityCount{0};
+
+        // Structural changes requested while systems are being processed,
+        // which would otherwise move rows under the iterating system
+        std::vector<ssvu::Func<void()>> deferred;
+        SizeT iterationDepth{0};
+
+        inline Impl::ArchetypeLocation& getLocation(
+            const EntityStat& mStat) noexcept
+        {
+            SSVU_ASSERT(SizeT(mStat.id) < locations.size());
+            return locations[mStat.id];
+        }
+
+        inline void beginIteration() noexcept { ++iterationDepth; }
+        inline void endIteration()
+        {
+            SSVU_ASSERT(iterationDepth > 0);
+            if(--iterationDepth > 0) return;
+
+            while(!deferred.empty())
+            {
+                auto fns(ssvu::mv(deferred));
+                deferred.clear();
+                for(auto& f : fns) f();
+            }
+        }
+
+        // Returns the archetype for `mTypeIds`, creating it if needed. The
+        // column prototypes of a new archetype are copied from `mSrc`.
+        inline Impl::Archetype& getArchetype(
+            const TypeIdxBitset& mTypeIds, const Impl::Archetype* mSrc)
+        {
+            auto& result(archetypeMap[mTypeIds]);
+            if(result != nullptr) return *result;
+
+            archetypes.emplace_back(
+                std::make_unique<Impl::Archetype>(mTypeIds));
+            result = archetypes.back().get();
+
+            if(mSrc != nullptr)
+                for(const auto& t : result->typeIdxs)
+                    if(mSrc->typeIds[t])
+                        result->prototypes[t] =
+                            mSrc->prototypes[t]->createEmpty();
+
+            for(auto& s : systems)
+                if(s->matches(mTypeIds))
+                {
+                    s->archetypes.emplace_back(result);
+                    result->systems.emplace_back(s);
+                }
+
+            return *result;
+        }
+
+        template <typename T>
+        inline static void addPrototype(Impl::Archetype& mArchetype)
+        {
+            auto& prototype(mArchetype.prototypes[Impl::getTypeIdx<T>()]);
+            if(prototype == nullptr)
+                prototype = std::make_unique<Impl::Column<T>>();
+        }
+
+        template <typename T>
+        inline Impl::Archetype& getArchetypeAdd(Impl::Archetype& mSrc)
+        {
+            const auto& idx(Impl::getTypeIdx<T>());
+            auto& next(mSrc.nextAdd[idx]);
+            if(next != nullptr) return *next;
+
+            auto typeIds(mSrc.typeIds);
+            typeIds[idx] = true;
+
+            next = &getArchetype(typeIds, &mSrc);
+            addPrototype<T>(*next);
+            return *next;
+        }
+
+        template <typename T>
+        inline Impl::Archetype& getArchetypeDel(Impl::Archetype& mSrc)
+        {
+            const auto& idx(Impl::getTypeIdx<T>());
+            auto& next(mSrc.nextDel[idx]);
+            if(next != nullptr) return *next;
+
+            auto typeIds(mSrc.typeIds);
+            typeIds[idx] = false;
+
+            next = &getArchetype(typeIds, &mSrc);
+            return *next;
+        }
+
+        // Erases the row at `mLoc`, updating the location of the entity
+        // moved in its place
+        inline void eraseRow(const Impl::ArchetypeLocation& mLoc) noexcept
+        {
+            const auto& moved(mLoc.archetype->erase(mLoc));
+            if(moved == -1) return;
+
+            auto& movedLoc(locations[moved]);
+            movedLoc.chunk = mLoc.chunk;
+            movedLoc.row = mLoc.row;
+        }
+
+        // Moves `mStat` from its archetype to `mDst`, carrying the shared
+        // components. `mFill` constructs the components missing from the
+        // source in the destination chunk.
+        template <typename TF>
+        inline void moveEntity(
+            const EntityStat& mStat, Impl::Archetype& mDst, const TF& mFill)
+        {
+            auto& loc(getLocation(mStat));
+            auto& src(*loc.archetype);
+            auto& srcChunk(*src.chunks[loc.chunk]);
+            ArchetypeEntity entity{*this, mStat};
+
+            for(auto& s : src.systems)
+                if(!s->matches(mDst.typeIds))
+                    s->notifyRemoved(entity, srcChunk, loc.row);
+
+            auto& dstChunk(mDst.getBackChunk());
+            for(const auto& t : src.typeIdxs)
+                if(mDst.typeIds[t])
+                    dstChunk.columns[t]->pushFrom(
+                        *srcChunk.columns[t], loc.row);
+
+            mFill(dstChunk);
+            dstChunk.stats.emplace_back(mStat);
+
+            eraseRow(loc);
+            loc.archetype = &mDst;
+            loc.chunk = mDst.chunks.size() - 1;
+            loc.row = dstChunk.getSize() - 1;
+
+            for(auto& s : mDst.systems)
+                if(!s->matches(src.typeIds))
+                    s->notifyAdded(entity, dstChunk, loc.row);
+        }
+
+        inline void placeEntity(const EntityStat& mStat)
+        {
+            if(root == nullptr) root = &getArchetype({}, nullptr);
+
+            auto& chunk(root->getBackChunk());
+            chunk.stats.emplace_back(mStat);
+
+            auto& loc(getLocation(mStat));
+            loc.archetype = root;
+            loc.chunk = root->chunks.size() - 1;
+            loc.row = chunk.getSize() - 1;
+
+            ArchetypeEntity entity{*this, mStat};
+            for(auto& s : root->systems)
+                s->notifyAdded(entity, chunk, loc.row);
+        }
+
+        template <typename T, typename... TArgs>
+        inline void createComponent(const EntityStat& mStat, TArgs&&... mArgs)
+        {
+            if(iterationDepth > 0)
+            {
+                auto component(std::make_shared<T>(FWD(mArgs)...));
+                deferred.emplace_back([this, mStat, component]
+                    {
+                        if(isAlive(mStat))
+                            createComponent<T>(mStat, ssvu::mv(*component));
+                    });
+                return;
+            }
+
+            SSVU_ASSERT(isAlive(mStat) && !hasComponent<T>(mStat));
+
+            auto& dst(getArchetypeAdd<T>(*getLocation(mStat).archetype));
+            moveEntity(mStat, dst, [&](Impl::ArchetypeChunk& mChunk)
+                {
+                    ssvu::castUp<Impl::Column<T>>(
+                        *mChunk.columns[Impl::getTypeIdx<T>()])
+                        .emplace(FWD(mArgs)...);
+                });
+        }
+
+        template <typename T>
+        inline void removeComponent(const EntityStat& mStat)
+        {
+            if(iterationDepth > 0)
+            {
+                deferred.emplace_back([this, mStat]
+                    {
+                        if(isAlive(mStat)) removeComponent<T>(mStat);
+                    });
+                return;
+            }
+
+            SSVU_ASSERT(isAlive(mStat) && hasComponent<T>(mStat));
+
+            auto& dst(getArchetypeDel<T>(*getLocation(mStat).archetype));
+            moveEntity(mStat, dst, [](Impl::ArchetypeChunk&)
+                {
+                });
+        }
+
+        template <typename T>
+        inline bool hasComponent(const EntityStat& mStat) const noexcept
+        {
+            const auto& loc(locations[mStat.id]);
+            return loc.archetype != nullptr &&
+                   loc.archetype->typeIds[Impl::getTypeIdx<T>()];
+        }
+
+        template <typename T>
+        inline T& getComponent(const EntityStat& mStat) noexcept
+        {
+            SSVU_ASSERT(hasComponent<T>(mStat));
+
+            const auto& loc(getLocation(mStat));
+            return loc.archetype->chunks[loc.chunk]->getData<T>()[loc.row];
+        }
+
+        inline bool isAlive(const EntityStat& mStat) const noexcept
+        {
+            return entityIdPool.isAlive(mStat) &&
+                   !locations[mStat.id].mustDestroy;
+        }
+
+        // Destruction always waits for `refresh`, like with `Manager`
+        inline void destroy(const EntityStat& mStat)
+        {
+            if(!isAlive(mStat)) return;
+
+            getLocation(mStat).mustDestroy = true;
+            toDestroy.emplace_back(mStat);
+        }
+
+    public:
+        inline ArchetypeManager() = default;
+
+        inline ArchetypeManager(const ArchetypeManager&) = delete;
+        inline ArchetypeManager& operator=(const ArchetypeManager&) = delete;
+
+        // Removes destroyed entities
+        inline void refresh()
+        {
+            SSVU_ASSERT(iterationDepth == 0);
+
+            for(const auto& s : toDestroy)
+            {
+                auto& loc(getLocation(s));
+                auto& chunk(*loc.archetype->chunks[loc.chunk]);
+                ArchetypeEntity entity{*this, s};
+
+                for(auto& sys : loc.archetype->systems)
+                    sys->notifyRemoved(entity, chunk, loc.row);
+
+                eraseRow(loc);
+                loc = {};
+                entityIdPool.reclaim(s);
+            }
+
+            entityCount -= toDestroy.size();
+            toDestroy.clear();
+        }
+
+        // Creates `mCount` entities with copies of `mComponents`, written
+        // directly into the chunks of their archetype, one column at a time
+        template <typename... TComponents>
+        inline void createEntities(
+            SizeT mCount, const TComponents&... mComponents)
+        {
+            SSVU_ASSERT(iterationDepth == 0);
+
+            const auto& typeIds(Impl::getTypeIdxBitset<TComponents...>());
+            SSVU_ASSERT(typeIds.count() == sizeof...(TComponents));
+
+            auto& dst(getArchetype(typeIds, nullptr));
+            (void)std::initializer_list<int>{
+                (addPrototype<TComponents>(dst), 0)...};
+
+            for(auto left(mCount); left > 0;)
+            {
+                auto& chunk(dst.getBackChunk());
+                const auto& row(chunk.getSize());
+                const auto count(
+                    std::min(left, archetypeChunkCapacity - row));
+
+                (void)std::initializer_list<int>{
+                    (ssvu::castUp<Impl::Column<TComponents>>(
+                         *chunk.columns[Impl::getTypeIdx<TComponents>()])
+                            .fill(count, mComponents),
+                        0)...};
+
+                for(auto i(0u); i < count; ++i)
+                {
+                    const auto& stat(entityIdPool.getAvailable());
+                    if(SizeT(stat.id) >= locations.size())
+                        locations.resize(stat.id + 1);
+
+                    chunk.stats.emplace_back(stat);
+                    locations[stat.id] = {&dst, dst.chunks.size() - 1,
+                        row + i, false};
+                }
+
+                if(!dst.systems.empty())
+                {
+                    for(auto i(row); i < row + count; ++i)
+                    {
+                        ArchetypeEntity entity{*this, chunk.stats[i]};
+                        for(auto& s : dst.systems)
+                            s->notifyAdded(entity, chunk, i);
+                    }
+                }
+
+                left -= count;
+            }
+
+            entityCount += mCount;
+        }
+
+        inline ArchetypeEntity createEntity()
+        {
+            const auto& stat(entityIdPool.getAvailable());
+            if(SizeT(stat.id) >= locations.size())
+                locations.resize(stat.id + 1);
+
+            ++entityCount;
+            if(iterationDepth > 0)
+                deferred.emplace_back([this, stat]
+                    {
+                        placeEntity(stat);
+                    });
+            else
+                placeEntity(stat);
+
+            return {*this, stat};
+        }
+
+        template <typename T>
+        inline void registerSystem(T& mSystem)
+        {
+            SSVU_ASSERT_STATIC(ssvu::isBaseOf<Impl::ArchetypeSystemBase, T>(),
+                "`T` must derive from `ArchetypeSystemBase`");
+
+            Impl::ArchetypeSystemBase& s(mSystem);
+            SSVU_ASSERT(s.manager == nullptr);
+
+            s.manager = this;
+            systems.emplace_back(&s);
+
+            for(auto& a : archetypes)
+                if(s.matches(a->typeIds))
+                {
+                    s.archetypes.emplace_back(a.get());
+                    a->systems.emplace_back(&s);
+                }
+        }
+
+        inline SizeT getEntityCount() const noexcept { return entityCount; }
+        inline SizeT getArchetypeCount() const noexcept
+        {
+            return archetypes.size();
+        }
+        inline SizeT getComponentCount() const noexcept
+        {
+            SizeT result{0};
+            for(const auto& a : archetypes)
+                result += a->getEntityCount() * a->typeIdxs.size();
+            return result;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,89 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_ARCHETYPESYSTEM
+#define CESYSTEM_ARCHETYPESYSTEM
+
+namespace ssvces
+{
+    namespace Impl
+    {
+        class ArchetypeSystemBase
+        {
+            friend ssvces::ArchetypeManager;
+
+        private:
+            TypeIdxBitset typeIdsReq, typeIdsNot;
+
+        protected:
+            ArchetypeManager* manager{nullptr};
+
+            // Archetypes matching the system, in creation order
+            std::vector<Archetype*> archetypes;
+
+            inline ArchetypeSystemBase(const TypeIdxBitset& mTypeIdsReq,
+                const TypeIdxBitset& mTypeIdsNot)
+                : typeIdsReq{mTypeIdsReq}, typeIdsNot{mTypeIdsNot}
+            {
+            }
+            inline virtual ~ArchetypeSystemBase() noexcept {}
+
+            inline bool matches(const TypeIdxBitset& mTypeIds) const noexcept
+            {
+                return matchesFilters(mTypeIds, typeIdsReq, typeIdsNot);
+            }
+
+            virtual void notifyAdded(
+                ArchetypeEntity&, ArchetypeChunk&, SizeT) = 0;
+            virtual void notifyRemoved(
+                ArchetypeEntity&, ArchetypeChunk&, SizeT) = 0;
+
+        public:
+            inline ArchetypeSystemBase(const ArchetypeSystemBase&) = delete;
+            inline ArchetypeSystemBase& operator=(
+                const ArchetypeSystemBase&) = delete;
+        };
+    }
+
+    // Same interface as `System`, for entities stored by `ArchetypeManager`.
+    // `process`, `added` and `removed` take an `ArchetypeEntity&` instead of
+    // an `Entity&`.
+    template <typename TDerived, typename TReq, typename TNot = Not<>>
+    class ArchetypeSystem;
+
+    template <typename TDerived, typename... TReqs, typename TNot>
+    class ArchetypeSystem<TDerived, Req<TReqs...>, TNot>
+        : public Impl::ArchetypeSystemBase
+    {
+    private:
+        inline auto& getTD() noexcept { return ssvu::castUp<TDerived>(*this); }
+
+        inline void notifyAdded(ArchetypeEntity& mEntity,
+            Impl::ArchetypeChunk& mChunk, SizeT mRow) override
+        {
+            Impl::callAdded(
+                getTD(), mEntity, mChunk.template getData<TReqs>()[mRow]...);
+        }
+        inline void notifyRemoved(ArchetypeEntity& mEntity,
+            Impl::ArchetypeChunk& mChunk, SizeT mRow) override
+        {
+            Impl::callRemoved(
+                getTD(), mEntity, mChunk.template getData<TReqs>()[mRow]...);
+        }
+
+    public:
+        inline ArchetypeSystem() noexcept
+            : ArchetypeSystemBase{Req<TReqs...>::getTypeIds(),
+                  TNot::getTypeIds()}
+        {
+        }
+
+        // Walks every matching chunk linearly. Structural changes made by
+        // `process` are applied when the outermost `processAll` returns.
+        template <typename... TArgs>
+        inline void processAll(TArgs&&... mArgs);
+    };
+}
+
+#endif
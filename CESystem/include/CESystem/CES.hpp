@@ -5,17 +5,45 @@
 #ifndef CESYSTEM_CES
 #define CESYSTEM_CES
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
 #include <SSVUtils/Core/Core.hpp>
 #include <SSVUtils/MemoryManager/MemoryManager.hpp>
 
 #include "CESystem/Common.hpp"
+#include "CESystem/Snapshot.hpp"
 #include "CESystem/IdPool.hpp"
+#include "CESystem/SparseSet.hpp"
+#include "CESystem/ThreadPool.hpp"
+#include "CESystem/Profiler.hpp"
 #include "CESystem/SystemBase.hpp"
 #include "CESystem/Entity.hpp"
+#include "CESystem/CommandBuffer.hpp"
 #include "CESystem/System.hpp"
 #include "CESystem/EntityHandle.hpp"
 #include "CESystem/Manager.hpp"
 #include "CESystem/Entity.inl"
 #include "CESystem/EntityHandle.inl"
+#include "CESystem/Scheduler.hpp"
+#include "CESystem/Archetype.hpp"
+#include "CESystem/ArchetypeSystem.hpp"
+#include "CESystem/ArchetypeEntity.hpp"
+#include "CESystem/ArchetypeManager.hpp"
+#include "CESystem/ArchetypeEntity.inl"
 
 #endif
@@ -0,0 +1,335 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_COMMANDBUFFER
+#define CESYSTEM_COMMANDBUFFER
+
+namespace ssvces
+{
+    namespace Impl
+    {
+        // Identifies what was being processed when a command was recorded:
+        // commands are applied sorted by key, so the order does not depend
+        // on which thread recorded them. Commands recorded outside of
+        // systems share their context, and are ordered by `buffer`, the
+        // order in which their thread first asked for a command buffer.
+        struct CommandKey
+        {
+            SizeT system, run, item, buffer, seq;
+
+            inline bool operator<(const CommandKey& mRhs) const noexcept
+            {
+                return std::tie(system, run, item, buffer, seq) <
+                       std::tie(mRhs.system, mRhs.run, mRhs.item,
+                           mRhs.buffer, mRhs.seq);
+            }
+        };
+
+        // Set by `System::processAll` and `System::processAllParallel` for
+        // every processed tuple; commands recorded outside of systems are
+        // applied last
+        inline CommandKey& getCommandContext() noexcept
+        {
+            static thread_local CommandKey context{nullIdx, 0, 0, 0, 0};
+            return context;
+        }
+
+        // Distinguishes managers in per-thread caches, as addresses can be
+        // reused
+        inline SizeT getNextManagerUid() noexcept
+        {
+            static std::atomic<SizeT> next{0};
+            return next++;
+        }
+
+        // Restores the calling thread's context on scope exit
+        class CommandContextGuard
+        {
+        private:
+            CommandKey saved;
+
+        public:
+            inline CommandContextGuard(SizeT mSystem, SizeT mRun) noexcept
+                : saved(getCommandContext())
+            {
+                getCommandContext() = {mSystem, mRun, 0, 0, 0};
+            }
+            inline ~CommandContextGuard() noexcept
+            {
+                getCommandContext() = saved;
+            }
+
+            inline void setItem(SizeT mItem) noexcept
+            {
+                getCommandContext().item = mItem;
+            }
+        };
+
+        // Bump allocator for the payloads of a command buffer. `clear`
+        // keeps the chunks, so a buffer stops allocating once it has
+        // recorded its busiest frame. Objects are never moved, and their
+        // owner destroys them before `clear`.
+        class CommandArena
+        {
+        private:
+            static constexpr SizeT chunkBytes{16384};
+
+            struct Chunk
+            {
+                ssvu::UPtr<char[]> data;
+                SizeT size;
+            };
+
+            std::vector<Chunk> chunks;
+            SizeT current{0}, used{0};
+
+            inline void* allocate(SizeT mBytes, SizeT mAlign)
+            {
+                for(;; ++current, used = 0)
+                {
+                    if(current == chunks.size())
+                    {
+                        const SizeT size{
+                            std::max(SizeT(chunkBytes), mBytes + mAlign)};
+                        chunks.push_back(
+                            {std::make_unique<char[]>(size), size});
+                    }
+
+                    const auto& chunk(chunks[current]);
+                    const auto& base(
+                        reinterpret_cast<std::uintptr_t>(chunk.data.get()));
+                    const auto& start(
+                        (base + used + mAlign - 1) & ~(mAlign - 1));
+                    if(start + mBytes > base + chunk.size) continue;
+
+                    used = start + mBytes - base;
+                    return reinterpret_cast<void*>(start);
+                }
+            }
+
+        public:
+            template <typename T, typename... TArgs>
+            inline T* create(TArgs&&... mArgs)
+            {
+                return new(allocate(sizeof(T), alignof(T))) T(FWD(mArgs)...);
+            }
+
+            inline void clear() noexcept { current = used = 0; }
+        };
+
+        template <typename T>
+        inline void destroyPayload(void* mPayload) noexcept
+        {
+            static_cast<T*>(mPayload)->~T();
+        }
+    }
+
+    // Records structural changes on an entity through a `CommandBuffer`
+    template <typename TRegistry>
+    class BasicDeferredEntity
+    {
+        using Entity = BasicEntity<TRegistry>;
+        using CommandBuffer = BasicCommandBuffer<TRegistry>;
+
+        friend CommandBuffer;
+
+    private:
+        CommandBuffer& buffer;
+
+        // Either an existing entity, or the slot filled by the command
+        // creating it
+        Entity* entity;
+        Entity** pending;
+
+        inline BasicDeferredEntity(CommandBuffer& mBuffer, Entity* mEntity,
+            Entity** mPending) noexcept
+            : buffer(mBuffer),
+              entity{mEntity},
+              pending{mPending}
+        {
+        }
+
+        // Holds the component until the command is applied
+        template <typename T>
+        struct ComponentCreation
+        {
+            T component;
+
+            template <typename... TArgs>
+            inline ComponentCreation(TArgs&&... mArgs)
+                : component(FWD(mArgs)...)
+            {
+            }
+
+            inline void operator()(Entity& mEntity)
+            {
+                mEntity.template createComponent<T>(ssvu::mv(component));
+            }
+        };
+
+        // Constructs the action in the buffer's arena
+        template <typename TF, typename... TArgs>
+        inline void emplace(TArgs&&... mArgs);
+
+        template <typename TF>
+        inline void record(TF&& mAction)
+        {
+            emplace<std::decay_t<TF>>(FWD(mAction));
+        }
+
+    public:
+        template <typename T, typename... TArgs>
+        inline void createComponent(TArgs&&... mArgs)
+        {
+            SSVU_ASSERT_STATIC(ssvu::isBaseOf<Component, T>(),
+                "`T` must derive from `Component`");
+
+            emplace<ComponentCreation<T>>(FWD(mArgs)...);
+        }
+        template <typename T>
+        inline void removeComponent()
+        {
+            record([](Entity& mEntity)
+                {
+                    mEntity.template removeComponent<T>();
+                });
+        }
+        template <typename... TGroups>
+        inline void addGroups(TGroups... mGroups)
+        {
+            record([mGroups...](Entity& mEntity)
+                {
+                    mEntity.addGroups(mGroups...);
+                });
+        }
+        template <typename... TGroups>
+        inline void delGroups(TGroups... mGroups)
+        {
+            record([mGroups...](Entity& mEntity)
+                {
+                    mEntity.delGroups(mGroups...);
+                });
+        }
+        inline void destroy()
+        {
+            record([](Entity& mEntity)
+                {
+                    mEntity.destroy();
+                });
+        }
+    };
+
+    // Structural changes recorded by a single thread, for instance from a
+    // system processed in parallel. `Manager::getCommands` returns the
+    // calling thread's buffer, and `Manager::refresh` applies every buffer
+    // before anything else. Recording never locks.
+    //
+    // Commands recorded by systems are applied in the same order whatever
+    // the threads. Commands recorded outside of systems are applied after
+    // them, buffer by buffer in the order the threads first called
+    // `getCommands`, which is only deterministic if that order is.
+    template <typename TRegistry>
+    class BasicCommandBuffer
+    {
+        using Entity = BasicEntity<TRegistry>;
+        using DeferredEntity = BasicDeferredEntity<TRegistry>;
+
+        friend BasicManager<TRegistry>;
+        friend DeferredEntity;
+
+    private:
+        // The action and its arguments are stored in `arena`, as
+        // `payload`, instead of one heap-allocated closure per command
+        struct Command
+        {
+            Impl::CommandKey key;
+            Entity* entity;
+            Entity** pending;
+            void (*action)(Entity&, void*); // Null for entity creation
+            void (*destroy)(void*);         // Null if trivially destructible
+            void* payload;
+        };
+
+        std::vector<Command> commands;
+        Impl::CommandArena arena;
+        std::deque<Entity*> pendingEntities; // Stable addresses
+        SizeT ordinal{0}; // Set by the manager on creation
+        SizeT nextSeq{0};
+
+        inline Impl::CommandKey getKey() noexcept
+        {
+            auto result(Impl::getCommandContext());
+            result.buffer = ordinal;
+            result.seq = nextSeq++;
+            return result;
+        }
+
+        inline void clear() noexcept
+        {
+            for(const auto& c : commands)
+                if(c.destroy != nullptr) c.destroy(c.payload);
+
+            commands.clear();
+            arena.clear();
+            pendingEntities.clear();
+            nextSeq = 0;
+        }
+
+    public:
+        inline BasicCommandBuffer() = default;
+
+        inline ~BasicCommandBuffer() noexcept { clear(); }
+
+        inline BasicCommandBuffer(const BasicCommandBuffer&) = delete;
+        inline BasicCommandBuffer& operator=(
+            const BasicCommandBuffer&) = delete;
+
+        // Records the creation of an entity, which can be modified through
+        // the returned object
+        inline DeferredEntity createEntity()
+        {
+            pendingEntities.emplace_back(nullptr);
+            auto pending(&pendingEntities.back());
+
+            commands.push_back(
+                {getKey(), nullptr, pending, nullptr, nullptr, nullptr});
+            return {*this, nullptr, pending};
+        }
+
+        // Records changes to an existing entity
+        inline DeferredEntity get(Entity& mEntity) noexcept
+        {
+            return {*this, &mEntity, nullptr};
+        }
+
+        inline bool isEmpty() const noexcept { return commands.empty(); }
+        inline SizeT getCommandCount() const noexcept
+        {
+            return commands.size();
+        }
+    };
+
+    template <typename TRegistry>
+    template <typename TF, typename... TArgs>
+    inline void BasicDeferredEntity<TRegistry>::emplace(TArgs&&... mArgs)
+    {
+        // Growing first, the payload is recorded as soon as it exists
+        auto& commands(buffer.commands);
+        if(commands.size() == commands.capacity())
+            commands.reserve(std::max(SizeT(16), commands.capacity() * 2));
+
+        auto payload(buffer.arena.template create<TF>(FWD(mArgs)...));
+        commands.push_back({buffer.getKey(), entity, pending,
+            [](Entity& mEntity, void* mPayload)
+            {
+                (*static_cast<TF*>(mPayload))(mEntity);
+            },
+            std::is_trivially_destructible<TF>()
+                ? nullptr
+                : &Impl::destroyPayload<TF>,
+            payload});
+    }
+}
+
+#endif
@@ -8,6 +8,12 @@
 #include <SSVUtils/SSVUtils.hpp>
 #include <SSVStart/SSVStart.hpp>
 
+// Per-system and per-refresh instrumentation, recorded into the manager's
+// `Profiler` - disabled by default, in which case it adds no code or data
+#if !defined(CESYSTEM_PROFILE)
+#define CESYSTEM_PROFILE 0
+#endif
+
 namespace ssvces
 {
     using ssvu::SizeT;
@@ -20,17 +26,37 @@ namespace ssvces
         inline virtual ~Component() noexcept {}
     };
 
-    // Forward declarations
-    class Entity;
-    class Manager;
-    class EntityHandle;
+    // Forward declarations - the entity classes are parametrized by a
+    // component registry, either `DynamicComponents` or a `ComponentList`
+    struct DynamicComponents;
+    template <typename...>
+    struct ComponentList;
+    template <typename>
+    class BasicEntity;
+    template <typename>
+    class BasicManager;
+    template <typename>
+    class BasicEntityHandle;
+    template <typename>
+    class BasicEntityHandleRange;
+    template <typename>
+    class BasicCommandBuffer;
+    template <typename>
+    class BasicDeferredEntity;
+    template <typename>
+    class BasicScheduler;
+    template <typename, typename, typename, typename>
+    class BasicSystem;
+    class ArchetypeManager;
+    class ArchetypeEntity;
     template <typename, typename, typename>
-    class System;
+    class ArchetypeSystem;
 
     // Constants
     static constexpr SizeT maxEntities{1'000'000};
-    static constexpr SizeT maxComponents{32};
+    static constexpr SizeT maxComponents{32}; // For `DynamicComponents`
     static constexpr SizeT maxGroups{32};
+    static constexpr SizeT archetypeChunkCapacity{1024};
 
     // Entity typedefs
     using EntityId = int;
@@ -49,15 +75,35 @@ namespace ssvces
     using Group = SizeT;
     using GroupBitset = std::bitset<maxGroups>;
 
+    // Classes using the default, runtime component registry
+    using Entity = BasicEntity<DynamicComponents>;
+    using Manager = BasicManager<DynamicComponents>;
+    using EntityHandle = BasicEntityHandle<DynamicComponents>;
+    using EntityHandleRange = BasicEntityHandleRange<DynamicComponents>;
+    using CommandBuffer = BasicCommandBuffer<DynamicComponents>;
+    using DeferredEntity = BasicDeferredEntity<DynamicComponents>;
+    using Scheduler = BasicScheduler<DynamicComponents>;
+
     // Recycler typedefs
-    using EntityRecycler = ssvu::MonoRecycler<Entity>;
-    using EntityRecyclerPtr = EntityRecycler::PtrType;
+    template <typename TRegistry>
+    using BasicEntityRecycler = ssvu::MonoRecycler<BasicEntity<TRegistry>>;
+    template <typename TRegistry>
+    using BasicEntityRecyclerPtr =
+        typename BasicEntityRecycler<TRegistry>::PtrType;
+    using EntityRecycler = BasicEntityRecycler<DynamicComponents>;
+    using EntityRecyclerPtr = BasicEntityRecyclerPtr<DynamicComponents>;
     using ComponentRecycler = ssvu::PolyRecycler<Component>;
     using ComponentRecyclerPtr = ComponentRecycler::PtrType;
 
     namespace Impl
     {
+        // Back-index value of an element which is not in a container
+        static constexpr SizeT nullIdx{std::numeric_limits<SizeT>::max()};
+
+        template <typename>
         class SystemBase;
+        class ArchetypeSystemBase;
+        class Archetype;
 
         // Returns the next unique bit index for a type
         inline TypeIdx getLastTypeIdx() noexcept
@@ -76,13 +122,14 @@ namespace ssvces
         template <typename T>
         TypeIdx TypeIdxInfo<T>::idx{getLastTypeIdx()};
 
-        // Shortcut to get the bit index of a Component type
+        // Shortcut to get the bit index of a Component type - `const T` and
+        // `T` share the same index
         template <typename T>
         inline const TypeIdx& getTypeIdx() noexcept
         {
             SSVU_ASSERT_STATIC(ssvu::isBaseOf<Component, T>(),
                 "`T` must derive from `Component`");
-            return TypeIdxInfo<T>::idx;
+            return TypeIdxInfo<std::remove_const_t<T>>::idx;
         }
 
         // These functions use variadic template recursion to "build" a bitset
@@ -112,6 +159,19 @@ namespace ssvces
             return nullBitset;
         }
 
+        // Builds the bitset of the non-const types of a pack, which are the
+        // components a system writes to
+        template <typename... TArgs>
+        inline TypeIdxBitset getBuildWriteBitset() noexcept
+        {
+            TypeIdxBitset result;
+            (void)std::initializer_list<int>{
+                (std::is_const<TArgs>() ? 0
+                                        : (result[getTypeIdx<TArgs>()] = true,
+                                              0))...};
+            return result;
+        }
+
         SSVU_DEFINE_MEMFN_CALLER(
             callAdded, added, void(TArgs...)) // `callAdded(...)` only calls
                                               // `T::added` if it exists
@@ -129,16 +189,229 @@ namespace ssvces
 
         // Returns whether the first bitset contains all the value of the second
         // one
-        inline bool containsAll(
-            const TypeIdxBitset& mA, const TypeIdxBitset& mB) noexcept
+        template <typename TBitset>
+        inline constexpr bool containsAll(
+            const TBitset& mA, const TBitset& mB) noexcept
         {
             return (mA & mB) == mB;
         }
 
+        // Makes room for `mCount` more elements, keeping the growth
+        // geometric when called repeatedly
+        template <typename T>
+        inline void reserveMore(T& mContainer, SizeT mCount)
+        {
+            const auto& needed(mContainer.size() + mCount);
+            if(needed > mContainer.capacity())
+                mContainer.reserve(
+                    std::max(needed, mContainer.capacity() * 2));
+        }
+
+        // Returns whether a type id bitset has all the `mReq` types and none
+        // of the `mNot` ones
+        template <typename TBitset>
+        inline constexpr bool matchesFilters(const TBitset& mTypeIds,
+            const TBitset& mReq, const TBitset& mNot) noexcept
+        {
+            return (mTypeIds & mNot).none() && containsAll(mTypeIds, mReq);
+        }
+
         // Returns whether a type id bitset matches a system's type id bitset
-        inline bool matchesSystem(
-            const TypeIdxBitset& mTypeIds, const SystemBase& mSystem) noexcept;
+        template <typename TRegistry>
+        inline bool matchesSystem(const typename TRegistry::Bitset& mTypeIds,
+            const SystemBase<TRegistry>& mSystem) noexcept;
+
+        // Smallest unsigned integer holding `TBits` bits, up to 64
+        template <SizeT TBits>
+        using BitsetWord = std::conditional_t<(TBits <= 8), std::uint8_t,
+            std::conditional_t<(TBits <= 16), std::uint16_t,
+                std::conditional_t<(TBits <= 32), std::uint32_t,
+                    std::uint64_t>>>;
+
+        // Fixed-size bitset usable in constant expressions, with the subset
+        // of the `std::bitset` interface used by the library. Up to 64 bits
+        // are stored in a single integer, so masking compiles to a couple of
+        // instructions.
+        template <SizeT TBits>
+        class StaticBitset
+        {
+        private:
+            using Word = BitsetWord<TBits>;
+            static constexpr SizeT wordBits{sizeof(Word) * 8};
+            static constexpr SizeT wordCount{
+                TBits == 0 ? 1 : (TBits + wordBits - 1) / wordBits};
+
+            Word words[wordCount];
+
+            inline static constexpr Word getMask(SizeT mIdx) noexcept
+            {
+                return Word(Word(1) << (mIdx % wordBits));
+            }
+
+        public:
+            inline constexpr StaticBitset() noexcept : words{} {}
+
+            inline constexpr bool test(SizeT mIdx) const noexcept
+            {
+                return (words[mIdx / wordBits] & getMask(mIdx)) != 0;
+            }
+            inline constexpr bool operator[](SizeT mIdx) const noexcept
+            {
+                return test(mIdx);
+            }
+
+            inline constexpr StaticBitset& set(
+                SizeT mIdx, bool mValue = true) noexcept
+            {
+                auto& word(words[mIdx / wordBits]);
+                word = mValue ? Word(word | getMask(mIdx))
+                              : Word(word & ~getMask(mIdx));
+                return *this;
+            }
+            inline constexpr StaticBitset& reset(SizeT mIdx) noexcept
+            {
+                return set(mIdx, false);
+            }
+            inline constexpr StaticBitset& reset() noexcept
+            {
+                for(auto& w : words) w = 0;
+                return *this;
+            }
+
+            inline constexpr bool any() const noexcept
+            {
+                for(const auto& w : words)
+                    if(w != 0) return true;
+                return false;
+            }
+            inline constexpr bool none() const noexcept { return !any(); }
+            inline constexpr SizeT count() const noexcept
+            {
+                SizeT result{0};
+                for(auto w : words)
+                    for(; w != 0; w &= Word(w - 1)) ++result;
+                return result;
+            }
+            inline static constexpr SizeT size() noexcept { return TBits; }
+
+            inline constexpr StaticBitset& operator&=(
+                const StaticBitset& mRhs) noexcept
+            {
+                for(auto i(0u); i < wordCount; ++i) words[i] &= mRhs.words[i];
+                return *this;
+            }
+            inline constexpr StaticBitset& operator|=(
+                const StaticBitset& mRhs) noexcept
+            {
+                for(auto i(0u); i < wordCount; ++i) words[i] |= mRhs.words[i];
+                return *this;
+            }
+            inline constexpr StaticBitset operator&(
+                const StaticBitset& mRhs) const noexcept
+            {
+                auto result(*this);
+                return result &= mRhs;
+            }
+            inline constexpr StaticBitset operator|(
+                const StaticBitset& mRhs) const noexcept
+            {
+                auto result(*this);
+                return result |= mRhs;
+            }
+
+            inline constexpr bool operator==(
+                const StaticBitset& mRhs) const noexcept
+            {
+                for(auto i(0u); i < wordCount; ++i)
+                    if(words[i] != mRhs.words[i]) return false;
+                return true;
+            }
+            inline constexpr bool operator!=(
+                const StaticBitset& mRhs) const noexcept
+            {
+                return !(*this == mRhs);
+            }
+        };
+
+        // Returns the index of `T` in `TTypes`, or `nullIdx`
+        template <typename T, typename... TTypes>
+        inline constexpr SizeT getTypeListIdx() noexcept
+        {
+            const bool matches[]{std::is_same<T, TTypes>()..., false};
+            for(auto i(0u); i < sizeof...(TTypes); ++i)
+                if(matches[i]) return i;
+            return nullIdx;
+        }
     }
+
+    // Default component registry: type indices are assigned at runtime, on
+    // first use, and at most `maxComponents` types can be used
+    struct DynamicComponents
+    {
+        static constexpr SizeT count{maxComponents};
+        using Bitset = TypeIdxBitset;
+
+        template <typename T>
+        inline static const TypeIdx& getIdx() noexcept
+        {
+            return Impl::getTypeIdx<T>();
+        }
+        template <typename... TArgs>
+        inline static const Bitset& getBitset() noexcept
+        {
+            return Impl::getTypeIdxBitset<TArgs...>();
+        }
+        template <typename... TArgs>
+        inline static const Bitset& getWriteBitset() noexcept
+        {
+            static Bitset bitset{Impl::getBuildWriteBitset<TArgs...>()};
+            return bitset;
+        }
+    };
+
+    // Compile-time component registry, for `BasicManager<ComponentList<...>>`:
+    // type indices and system signatures are constant expressions, and
+    // bitsets are only as wide as the list. Using a type which is not in the
+    // list does not compile.
+    template <typename... TComponents>
+    struct ComponentList
+    {
+        static constexpr SizeT count{sizeof...(TComponents)};
+        using Bitset = Impl::StaticBitset<count>;
+
+        template <typename T>
+        inline static constexpr TypeIdx getIdx() noexcept
+        {
+            SSVU_ASSERT_STATIC(ssvu::isBaseOf<Component, T>(),
+                "`T` must derive from `Component`");
+
+            constexpr auto result(
+                Impl::getTypeListIdx<std::remove_const_t<T>, TComponents...>());
+            SSVU_ASSERT_STATIC(
+                result != Impl::nullIdx, "`T` is not in the `ComponentList`");
+            return result;
+        }
+        template <typename... TArgs>
+        inline static constexpr Bitset getBitset() noexcept
+        {
+            const TypeIdx idxs[]{getIdx<TArgs>()..., 0};
+
+            Bitset result;
+            for(auto i(0u); i < sizeof...(TArgs); ++i) result.set(idxs[i]);
+            return result;
+        }
+        template <typename... TArgs>
+        inline static constexpr Bitset getWriteBitset() noexcept
+        {
+            const TypeIdx idxs[]{getIdx<TArgs>()..., 0};
+            const bool consts[]{std::is_const<TArgs>()..., false};
+
+            Bitset result;
+            for(auto i(0u); i < sizeof...(TArgs); ++i)
+                if(!consts[i]) result.set(idxs[i]);
+            return result;
+        }
+    };
 }
 
 #endif
@@ -7,32 +7,47 @@
 
 namespace ssvces
 {
-    class Entity
+    template <typename TRegistry>
+    class BasicEntity
     {
+        using Manager = BasicManager<TRegistry>;
+
         friend Manager;
-        friend EntityHandle;
-        friend Impl::SystemBase;
-        template <typename, typename, typename>
-        friend class System;
+        friend BasicEntityHandle<TRegistry>;
+        friend Impl::SystemBase<TRegistry>;
+        template <typename, typename, typename, typename>
+        friend class BasicSystem;
 
     private:
         Manager& manager;
-        std::array<ComponentRecyclerPtr, maxComponents> components;
-        TypeIdxBitset typeIds;
+        std::array<ComponentRecyclerPtr, TRegistry::count> components;
+        typename TRegistry::Bitset typeIds;
         bool mustDestroy{false}, mustRematch{true};
+        bool dirty{false}; // Queued for the next `Manager::refresh`
         GroupBitset groups;
         EntityStat stat;
         SizeT componentCount{0};
 
+        // Back-index into `Manager::entities`, and the groups whose sparse
+        // set currently holds the entity
+        SizeT entityIdx{0};
+        GroupBitset inGroups;
+
+        template <typename T>
+        inline static decltype(auto) getIdx() noexcept
+        {
+            return TRegistry::template getIdx<T>();
+        }
+
     public:
-        inline Entity(Manager& mManager, const EntityStat& mStat) noexcept
+        inline BasicEntity(Manager& mManager, const EntityStat& mStat) noexcept
             : manager(mManager),
               stat(mStat)
         {
         }
 
-        inline Entity(const Entity&) = delete;
-        inline Entity& operator=(const Entity&) = delete;
+        inline BasicEntity(const BasicEntity&) = delete;
+        inline BasicEntity& operator=(const BasicEntity&) = delete;
 
         template <typename T, typename... TArgs>
         inline void createComponent(TArgs&&...);
@@ -43,7 +58,7 @@ namespace ssvces
         {
             SSVU_ASSERT_STATIC(ssvu::isBaseOf<Component, T>(),
                 "`T` must derive from `Component`");
-            return typeIds[Impl::getTypeIdx<T>()];
+            return typeIds[getIdx<T>()];
         }
         template <typename T>
         inline T& getComponent() noexcept
@@ -51,7 +66,7 @@ namespace ssvces
             SSVU_ASSERT_STATIC(ssvu::isBaseOf<Component, T>(),
                 "`T` must derive from `Component`");
             SSVU_ASSERT(componentCount > 0 && hasComponent<T>());
-            return ssvu::castUp<T>(*components[Impl::getTypeIdx<T>()]);
+            return ssvu::castUp<T>(*components[getIdx<T>()]);
         }
 
         inline void destroy() noexcept;
@@ -97,17 +112,10 @@ namespace ssvces
         inline const GroupBitset& getGroups() const noexcept { return groups; }
     };
 
-    template <typename T>
-    inline constexpr Tpl<T*> buildComponentsTpl(Entity& mEntity)
-    {
-        return Tpl<T*>{&mEntity.getComponent<T>()};
-    }
-    template <typename T1, typename T2, typename... TArgs>
-    inline constexpr Tpl<T1*, T2*, TArgs*...> buildComponentsTpl(
-        Entity& mEntity)
+    template <typename... TArgs, typename TEntity>
+    inline Tpl<TArgs*...> buildComponentsTpl(TEntity& mEntity)
     {
-        return ssvu::tplCat(buildComponentsTpl<T1>(mEntity),
-            buildComponentsTpl<T2, TArgs...>(mEntity));
+        return Tpl<TArgs*...>{&mEntity.template getComponent<TArgs>()...};
     }
 }
 
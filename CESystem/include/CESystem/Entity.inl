@@ -7,53 +7,72 @@
 
 namespace ssvces
 {
+    template <typename TRegistry>
     template <typename T, typename... TArgs>
-    inline void Entity::createComponent(TArgs&&... mArgs)
+    inline void BasicEntity<TRegistry>::createComponent(TArgs&&... mArgs)
     {
         SSVU_ASSERT_STATIC(
             ssvu::isBaseOf<Component, T>(), "`T` must derive from `Component`");
-        SSVU_ASSERT(!hasComponent<T>() && componentCount <= maxComponents);
+        SSVU_ASSERT(!hasComponent<T>() && componentCount <= TRegistry::count);
 
-        components[Impl::getTypeIdx<T>()] =
-            manager.componentRecycler.create<T>(FWD(mArgs)...);
-        typeIds[Impl::getTypeIdx<T>()] = true;
+        components[getIdx<T>()] =
+            manager.componentRecycler.template create<T>(FWD(mArgs)...);
+        typeIds.set(getIdx<T>());
         ++componentCount;
 
         mustRematch = true;
+        manager.markDirty(*this);
     }
+    template <typename TRegistry>
     template <typename T>
-    inline void Entity::removeComponent()
+    inline void BasicEntity<TRegistry>::removeComponent()
     {
         SSVU_ASSERT_STATIC(
             ssvu::isBaseOf<Component, T>(), "`T` must derive from `Component`");
         SSVU_ASSERT(hasComponent<T>() && componentCount > 0);
 
-        components[Impl::getTypeIdx<T>()].reset();
-        typeIds[Impl::getTypeIdx<T>()] = false;
+        components[getIdx<T>()].reset();
+        typeIds.reset(getIdx<T>());
         --componentCount;
 
         mustRematch = true;
+        manager.markDirty(*this);
     }
-    inline void Entity::destroy() noexcept
+    template <typename TRegistry>
+    inline void BasicEntity<TRegistry>::destroy() noexcept
     {
         mustDestroy = true;
         manager.entityIdPool.reclaim(stat);
+        manager.markDirty(*this);
     }
-    inline void Entity::setGroups(bool mOn, Group mGroup) noexcept
+    template <typename TRegistry>
+    inline void BasicEntity<TRegistry>::setGroups(
+        bool mOn, Group mGroup) noexcept
     {
         groups[mGroup] = mOn;
-        if(mOn) manager.addToGroup(this, mGroup);
+        if(mOn)
+            manager.addToGroup(this, mGroup);
+        else
+            manager.markDirty(*this);
     }
-    inline void Entity::addGroups(Group mGroup) noexcept
+    template <typename TRegistry>
+    inline void BasicEntity<TRegistry>::addGroups(Group mGroup) noexcept
     {
         groups[mGroup] = true;
         manager.addToGroup(this, mGroup);
     }
-    inline void Entity::delGroups(Group mGroup) noexcept
+    template <typename TRegistry>
+    inline void BasicEntity<TRegistry>::delGroups(Group mGroup) noexcept
     {
         groups[mGroup] = false;
+        manager.markDirty(*this);
+    }
+    template <typename TRegistry>
+    inline void BasicEntity<TRegistry>::clearGroups() noexcept
+    {
+        groups.reset();
+        manager.markDirty(*this);
     }
-    inline void Entity::clearGroups() noexcept { groups.reset(); }
 }
 
 #endif
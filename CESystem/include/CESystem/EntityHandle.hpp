@@ -7,15 +7,19 @@
 
 namespace ssvces
 {
-    class EntityHandle
+    template <typename TRegistry>
+    class BasicEntityHandle
     {
+        using Entity = BasicEntity<TRegistry>;
+        using Manager = BasicManager<TRegistry>;
+
     private:
         Entity& entity;
         Manager& manager;
         EntityStat stat;
 
     public:
-        inline EntityHandle(Entity& mEntity) noexcept
+        inline BasicEntityHandle(Entity& mEntity) noexcept
             : entity(mEntity),
               manager(entity.getManager()),
               stat(entity.stat)
@@ -26,19 +30,19 @@ namespace ssvces
         inline void createComponent(TArgs&&... mArgs)
         {
             SSVU_ASSERT(isAlive());
-            entity.createComponent<T>(FWD(mArgs)...);
+            entity.template createComponent<T>(FWD(mArgs)...);
         }
         template <typename T>
         inline bool hasComponent() const noexcept
         {
             SSVU_ASSERT(isAlive());
-            return entity.hasComponent<T>();
+            return entity.template hasComponent<T>();
         }
         template <typename T>
         inline T& getComponent()
         {
             SSVU_ASSERT(isAlive());
-            return entity.getComponent<T>();
+            return entity.template getComponent<T>();
         }
 
         inline void destroy() noexcept
@@ -88,6 +92,72 @@ namespace ssvces
             return entity.getGroups();
         }
     };
+
+    // Iterates over entities as handles without allocating. Entities added
+    // while iterating are not visited.
+    template <typename TRegistry>
+    class BasicEntityHandleRange
+    {
+        using Entity = BasicEntity<TRegistry>;
+        using EntityHandle = BasicEntityHandle<TRegistry>;
+
+    private:
+        const std::vector<Entity*>& entities;
+        SizeT count;
+
+    public:
+        class Iterator
+        {
+        private:
+            const std::vector<Entity*>* entities;
+            SizeT idx;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = EntityHandle;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = EntityHandle;
+
+            inline Iterator(
+                const std::vector<Entity*>& mEntities, SizeT mIdx) noexcept
+                : entities{&mEntities},
+                  idx{mIdx}
+            {
+            }
+
+            // Indexing instead of holding a pointer survives reallocations
+            inline EntityHandle operator*() const noexcept
+            {
+                return {*(*entities)[idx]};
+            }
+            inline Iterator& operator++() noexcept
+            {
+                ++idx;
+                return *this;
+            }
+            inline bool operator==(const Iterator& mRhs) const noexcept
+            {
+                return idx == mRhs.idx;
+            }
+            inline bool operator!=(const Iterator& mRhs) const noexcept
+            {
+                return idx != mRhs.idx;
+            }
+        };
+
+        inline BasicEntityHandleRange(
+            const std::vector<Entity*>& mEntities) noexcept
+            : entities(mEntities),
+              count{mEntities.size()}
+        {
+        }
+
+        inline Iterator begin() const noexcept { return {entities, 0}; }
+        inline Iterator end() const noexcept { return {entities, count}; }
+        inline SizeT size() const noexcept { return count; }
+        inline bool empty() const noexcept { return count == 0; }
+    };
 }
 
 #endif
@@ -7,7 +7,8 @@
 
 namespace ssvces
 {
-    inline bool EntityHandle::isAlive() const noexcept
+    template <typename TRegistry>
+    inline bool BasicEntityHandle<TRegistry>::isAlive() const noexcept
     {
         return manager.entityIdPool.isAlive(stat);
     }
@@ -12,43 +12,86 @@ namespace ssvces
         class IdPool
         {
             // IdPool stores available Entity ids and is used to check Entity
-            // validity
+            // validity. Ids are only created when needed, up to
+            // `maxEntities`, so an empty pool allocates nothing.
 
         private:
-            std::vector<EntityId> available;
-            std::array<EntityIdCtr, maxEntities> counters;
+            static constexpr EntityId nullId{-1};
+
+            // Counter of an id, and the next available id if it is
+            // available itself - the free list is threaded through the
+            // slots
+            struct Slot
+            {
+                EntityIdCtr ctr;
+                EntityId nextAvailable;
+            };
+
+            std::vector<Slot> slots;
+            EntityId firstAvailable{nullId};
 
         public:
-            inline IdPool() : available(maxEntities)
+            inline IdPool() = default;
+
+            // Avoids reallocations until `mCount` ids have been created
+            inline void reserve(SizeT mCount)
             {
-                // Fill the available ids vector from 0 to maxEntities
-                ssvu::iota(available, 0);
-                ssvu::fill(counters, 0);
+                SSVU_ASSERT(mCount <= maxEntities);
+                slots.reserve(mCount);
             }
 
             // Returns the first available IdCtrPair
-            inline EntityStat getAvailable() noexcept
+            inline EntityStat getAvailable()
             {
-                SSVU_ASSERT(!available.empty());
+                if(firstAvailable == nullId)
+                {
+                    SSVU_ASSERT(slots.size() < maxEntities);
+
+                    // `std::vector` grows geometrically
+                    slots.push_back({0, nullId});
+                    return {EntityId(slots.size() - 1), 0};
+                }
 
-                EntityId id(available.back());
-                available.pop_back();
-                return {id, counters[id]};
+                const auto id(firstAvailable);
+                firstAvailable = slots[id].nextAvailable;
+                return {id, slots[id].ctr};
             }
 
             // Used on Entity death, reclaims the Entity's id so that it can be
             // reused
             inline void reclaim(const EntityStat& mStat) noexcept
             {
-                if(mStat.ctr != counters[mStat.id]) return;
-                ++counters[mStat.id];
-                available.emplace_back(mStat.id);
+                auto& slot(slots[mStat.id]);
+                if(mStat.ctr != slot.ctr) return;
+
+                ++slot.ctr;
+                slot.nextAvailable = firstAvailable;
+                firstAvailable = mStat.id;
             }
 
             // Checks if an Entity is currently alive
             inline bool isAlive(const EntityStat& mStat) const noexcept
             {
-                return counters[mStat.id] == mStat.ctr;
+                return SizeT(mStat.id) < slots.size() &&
+                       slots[mStat.id].ctr == mStat.ctr;
+            }
+
+            // Number of ids created so far
+            inline SizeT getCapacity() const noexcept { return slots.size(); }
+
+            // Counters and free list, so that restored entity stats are
+            // alive and the same ids are handed out next
+            inline void snapshot(SnapshotWriter& mWriter) const
+            {
+                mWriter.write(std::uint64_t(slots.size()));
+                mWriter.write(slots.data(), slots.size() * sizeof(Slot));
+                mWriter.write(firstAvailable);
+            }
+            inline void restore(SnapshotReader& mReader)
+            {
+                slots.resize(mReader.read<std::uint64_t>());
+                mReader.read(slots.data(), slots.size() * sizeof(Slot));
+                firstAvailable = mReader.read<EntityId>();
             }
         };
     }
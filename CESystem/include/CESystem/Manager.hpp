@@ -7,8 +7,19 @@
 
 namespace ssvces
 {
-    class Manager
+    // Owns entities and their components. `TRegistry` assigns component
+    // type indices: `Manager` uses `DynamicComponents`, and
+    // `BasicManager<ComponentList<...>>` resolves them at compile time.
+    template <typename TRegistry>
+    class BasicManager
     {
+        using Entity = BasicEntity<TRegistry>;
+        using EntityHandle = BasicEntityHandle<TRegistry>;
+        using CommandBuffer = BasicCommandBuffer<TRegistry>;
+        using SystemBase = Impl::SystemBase<TRegistry>;
+        using EntityRecycler = BasicEntityRecycler<TRegistry>;
+        using EntityRecyclerPtr = BasicEntityRecyclerPtr<TRegistry>;
+
         friend Entity;
         friend EntityHandle;
 
@@ -17,69 +28,605 @@ namespace ssvces
         ComponentRecycler componentRecycler;
 
         Impl::IdPool entityIdPool;
-        std::vector<Impl::SystemBase*> systems;
+        std::vector<SystemBase*> systems;
         std::vector<EntityRecyclerPtr> entities;
-        std::array<std::vector<Entity*>, maxGroups> grouped;
+        std::array<Impl::SparseSet<Entity>, maxGroups> grouped;
+
+        // Entities destroyed, rematched or removed from a group since the
+        // last refresh, and the ones being refreshed
+        std::vector<Entity*> dirty, refreshing;
+
+        // One command buffer per thread which recorded commands
+        SizeT uid{Impl::getNextManagerUid()};
+        std::mutex commandsMutex;
+        std::unordered_map<std::thread::id, ssvu::UPtr<CommandBuffer>>
+            commandBuffers;
+        SizeT nextBufferOrdinal{0};
+        std::vector<
+            std::pair<Impl::CommandKey, typename CommandBuffer::Command*>>
+            commandQueue;
+
+#if CESYSTEM_PROFILE
+        Profiler profiler;
+        std::array<double, SizeT(RefreshPhase::Count) + 1> refreshMarks;
+#endif
+
+        inline auto& create(BasicManager& mManager, Impl::IdPool& mIdPool)
+        {
+            auto& result(entityRecycler.getCreateEmplace(
+                entities, mManager, mIdPool.getAvailable()));
+            result.entityIdx = entities.size() - 1;
+            return result;
+        }
 
-        inline auto& create(Manager& mManager, Impl::IdPool& mIdPool)
+        inline void markDirty(Entity& mEntity)
         {
-            return entityRecycler.getCreateEmplace(
-                entities, mManager, mIdPool.getAvailable());
+            if(mEntity.dirty) return;
+            mEntity.dirty = true;
+            dirty.emplace_back(&mEntity);
         }
 
+        // Groups are keyed by entity id
         inline void addToGroup(Entity* mEntity, Group mGroup)
         {
             SSVU_ASSERT(mGroup <= maxGroups);
-            grouped[mGroup].emplace_back(mEntity);
+            if(mEntity->inGroups[mGroup]) return;
+
+            // The id may be shared by a destroyed entity awaiting refresh
+            // and a new one, and only the new one can be in the group
+            auto& group(grouped[mGroup]);
+            const auto& id(SizeT(mEntity->stat.id));
+            const auto& other(group.get(id));
+            if(other != nullptr)
+            {
+                if(mEntity->mustDestroy) return;
+                delFromGroup(*other, mGroup);
+            }
+
+            group.add(id, mEntity);
+            mEntity->inGroups[mGroup] = true;
+        }
+        inline void delFromGroup(Entity& mEntity, Group mGroup) noexcept
+        {
+            grouped[mGroup].remove(mEntity.stat.id);
+            mEntity.inGroups[mGroup] = false;
+        }
+
+        // Merges every command buffer in key order, so the result does not
+        // depend on which threads recorded the commands. Keys are unique,
+        // as `seq` counts per buffer and `buffer` tells buffers apart.
+        inline void applyCommands()
+        {
+            commandQueue.clear();
+            for(auto& b : commandBuffers)
+                for(auto& c : b.second->commands)
+                    commandQueue.emplace_back(c.key, &c);
+
+            // Keys are copied to avoid an indirection per comparison
+            std::stable_sort(std::begin(commandQueue), std::end(commandQueue),
+                [](const auto& mA, const auto& mB)
+                {
+                    return mA.first < mB.first;
+                });
+
+            for(const auto& p : commandQueue)
+            {
+                const auto& c(p.second);
+                if(!c->action)
+                {
+                    auto& e(create(*this, entityIdPool));
+                    markDirty(e);
+                    *c->pending = &e;
+                    continue;
+                }
+
+                // Entities are only deleted by `refresh`, so they are still
+                // valid, but commands on destroyed ones are dropped
+                auto& e(c->entity != nullptr ? *c->entity : **c->pending);
+                if(!e.mustDestroy) c->action(e, c->payload);
+            }
+
+            for(auto& b : commandBuffers) b.second->clear();
+        }
+
+        // Instrumentation of `refresh`, empty unless `CESYSTEM_PROFILE` is
+        // set: records the start of a phase, or the end of the last one
+        inline void markRefresh(SizeT mPhase) noexcept
+        {
+#if CESYSTEM_PROFILE
+            refreshMarks[mPhase] = profiler.now();
+#else
+            (void)mPhase;
+#endif
+        }
+
+        // Ends the profiler's frame with the refresh timings and what
+        // systems recorded since the last refresh
+        inline void endProfileFrame()
+        {
+#if CESYSTEM_PROFILE
+            auto& frame(profiler.beginFrame());
+            frame.endUs = refreshMarks.back();
+
+            for(auto& s : systems) s->flushProfile(frame);
+
+            const auto& thread(Profiler::getThreadId());
+            for(auto p(0u); p < frame.refreshUs.size(); ++p)
+            {
+                frame.refreshUs[p] = refreshMarks[p + 1] - refreshMarks[p];
+                frame.events.push_back({Impl::nullIdx, p, refreshMarks[p],
+                    frame.refreshUs[p], thread});
+            }
+
+            profiler.endFrame(frame);
+#endif
+        }
+
+        using Bitset = typename TRegistry::Bitset;
+
+        // Stat, type ids and groups, followed by the components with a
+        // `TrivialComponentSerializer`, are written as one block per
+        // entity. The other components follow the block.
+        static constexpr SizeT blockHeaderBytes{
+            sizeof(EntityStat) + sizeof(Bitset) + sizeof(GroupBitset)};
+
+        template <typename T>
+        using IsTrivial = std::is_base_of<Impl::TrivialSerializerTag,
+            ComponentSerializer<T>>;
+
+        template <typename T>
+        inline static SizeT getBlockBytes(
+            const Bitset& mTypeIds, std::true_type) noexcept
+        {
+            return mTypeIds[TRegistry::template getIdx<T>()]
+                       ? ComponentSerializer<T>::size
+                       : 0;
+        }
+        template <typename T>
+        inline static SizeT getBlockBytes(
+            const Bitset&, std::false_type) noexcept
+        {
+            return 0;
+        }
+        template <typename... TComponents>
+        inline static SizeT getBlockBytes(const Bitset& mTypeIds) noexcept
+        {
+            return Impl::sumOf({blockHeaderBytes,
+                getBlockBytes<TComponents>(
+                    mTypeIds, IsTrivial<TComponents>{})...});
+        }
+
+        // Component `T` of an entity, if it has one, into the entity's
+        // block for trivial serializers, and through `mWriter` otherwise
+        template <typename T>
+        inline static void saveToBlock(
+            char*& mBlock, const Entity& mEntity, std::true_type)
+        {
+            const auto& idx(TRegistry::template getIdx<T>());
+            if(!mEntity.typeIds[idx]) return;
+
+            ComponentSerializer<T>::save(
+                mBlock, ssvu::castUp<const T>(*mEntity.components[idx]));
+            mBlock += ComponentSerializer<T>::size;
+        }
+        template <typename T>
+        inline static void saveToBlock(char*&, const Entity&, std::false_type)
+        {
+        }
+        template <typename T>
+        inline static void saveToWriter(
+            SnapshotWriter&, const Entity&, std::true_type)
+        {
+        }
+        template <typename T>
+        inline static void saveToWriter(
+            SnapshotWriter& mWriter, const Entity& mEntity, std::false_type)
+        {
+            const auto& idx(TRegistry::template getIdx<T>());
+            if(!mEntity.typeIds[idx]) return;
+
+            ComponentSerializer<T>::save(
+                mWriter, ssvu::castUp<const T>(*mEntity.components[idx]));
+        }
+
+        template <typename T>
+        inline void loadFromBlock(
+            const char*& mBlock, Entity& mEntity, std::true_type)
+        {
+            const auto& idx(TRegistry::template getIdx<T>());
+            if(!mEntity.typeIds[idx]) return;
+
+            // A reused entity may still have the component
+            auto& c(mEntity.components[idx]);
+            if(c == nullptr)
+                c = componentRecycler.template create<T>(
+                    ComponentSerializer<T>::load(mBlock));
+            else
+                ComponentSerializer<T>::load(mBlock, ssvu::castUp<T>(*c));
+            mBlock += ComponentSerializer<T>::size;
+        }
+        template <typename T>
+        inline void loadFromBlock(const char*&, Entity&, std::false_type)
+        {
+        }
+        template <typename T>
+        inline void loadFromReader(SnapshotReader&, Entity&, std::true_type)
+        {
+        }
+        template <typename T>
+        inline void loadFromReader(
+            SnapshotReader& mReader, Entity& mEntity, std::false_type)
+        {
+            const auto& idx(TRegistry::template getIdx<T>());
+            if(!mEntity.typeIds[idx]) return;
+
+            mEntity.components[idx] = componentRecycler.template create<T>(
+                ComponentSerializer<T>::load(mReader));
+        }
+
+        // Moves an entity kept by `restore` back into `entities`, as a
+        // fresh entity with the stat of the snapshot and the components of
+        // `mTypeIds` it already has
+        inline Entity& reuseEntity(EntityRecyclerPtr& mPtr,
+            const EntityStat& mStat, const Bitset& mTypeIds) noexcept
+        {
+            entities.emplace_back(ssvu::mv(mPtr));
+            auto& e(*entities.back());
+
+            const auto& stale(e.typeIds & ~mTypeIds);
+            if(stale.any())
+                for(auto idx(0u); idx < TRegistry::count; ++idx)
+                    if(stale[idx]) e.components[idx].reset();
+
+            e.stat = mStat;
+            e.mustDestroy = e.dirty = false;
+            e.inGroups.reset();
+            return e;
+        }
+
+        inline void delEntity(Entity& mEntity) noexcept
+        {
+            const auto idx(mEntity.entityIdx);
+
+            // Either assignment destroys `mEntity`
+            if(idx != entities.size() - 1)
+            {
+                entities[idx] = ssvu::mv(entities.back());
+                entities[idx]->entityIdx = idx;
+            }
+
+            entities.pop_back();
         }
 
     public:
-        inline Manager() = default;
+        inline BasicManager() = default;
 
-        inline Manager(const Manager&) = delete;
-        inline Manager& operator=(const Manager&) = delete;
+        inline BasicManager(const BasicManager&) = delete;
+        inline BasicManager& operator=(const BasicManager&) = delete;
 
+        // Applies recorded commands, then only visits the entities changed
+        // since the last refresh
         inline void refresh()
         {
-            for(auto& s : systems) s->refresh();
-
-            for(auto i(0u); i < maxGroups; ++i)
-                ssvu::eraseRemoveIf(grouped[i], [i](const Entity* mEntity)
-                    {
-                        return mEntity->mustDestroy || !mEntity->hasGroup(i);
-                    });
+            markRefresh(SizeT(RefreshPhase::Commands));
+            applyCommands();
+            markRefresh(SizeT(RefreshPhase::Leave));
 
-            // This loop below is roughly implemented like std::remove_if
-            auto itr(std::begin(entities)), last(std::end(entities)),
-                result(itr);
-            for(; itr != last; ++itr)
+            // `added` and `removed` hooks may change entities again, which
+            // queues them in `dirty`: each pass refreshes the entities
+            // queued before it, until none are left. Entities queued again
+            // during a pass are only matched by the next one.
+            auto firstPass(true);
+            do
             {
-                auto& e(**itr);
+                std::swap(dirty, refreshing);
+                for(auto& e : refreshing) e->dirty = false;
 
-                if(e.mustDestroy) continue;
-                if(e.mustRematch)
+                // Changed entities leave systems and groups first, as the
+                // ids of destroyed entities may already belong to new ones
+                for(auto& e : refreshing)
                 {
-                    for(auto& s : systems)
-                        if(Impl::matchesSystem(e.typeIds, *s))
-                            s->registerEntity(e);
-                    e.mustRematch = false;
+                    if(e->mustDestroy || e->mustRematch)
+                        for(auto& s : systems) s->unregisterEntity(*e);
+
+                    const auto& stale(e->mustDestroy
+                                          ? e->inGroups
+                                          : e->inGroups & ~e->groups);
+                    if(stale.none()) continue;
+
+                    for(auto i(0u); i < maxGroups; ++i)
+                        if(stale[i]) delFromGroup(*e, i);
                 }
 
-                *result++ = ssvu::mv(*itr);
-            }
-            entities.erase(result, last);
+                if(firstPass) markRefresh(SizeT(RefreshPhase::Match));
+                firstPass = false;
+
+                for(auto& e : refreshing)
+                {
+                    if(e->dirty) continue;
+
+                    if(e->mustDestroy)
+                    {
+                        delEntity(*e);
+                        continue;
+                    }
+
+                    if(e->mustRematch)
+                    {
+                        for(auto& s : systems)
+                            if(Impl::matchesSystem(e->typeIds, *s))
+                                s->registerEntity(*e);
+                        e->mustRematch = false;
+                    }
+                }
+
+                refreshing.clear();
+            } while(!dirty.empty());
+
+            markRefresh(SizeT(RefreshPhase::Count));
+            endProfileFrame();
         }
 
         inline EntityHandle createEntity()
         {
-            return {create(*this, entityIdPool)};
+            auto& result(create(*this, entityIdPool));
+            markDirty(result);
+            return {result};
+        }
+
+        // Creates `mCount` entities with copies of `mComponents`. The type
+        // bitset and the matching systems are computed once for the whole
+        // batch, and the entities are registered to them immediately
+        // instead of waiting for `refresh`, so this must not be called while
+        // a system is being processed. Returns the index of the first new
+        // entity in `getEntities()`; the others follow it.
+        template <typename... TComponents>
+        inline SizeT createEntities(
+            SizeT mCount, const TComponents&... mComponents)
+        {
+            const auto& typeIds(
+                TRegistry::template getBitset<TComponents...>());
+            SSVU_ASSERT(typeIds.count() == sizeof...(TComponents));
+
+            const auto first(entities.size());
+            Impl::reserveMore(entities, mCount);
+
+            for(auto i(0u); i < mCount; ++i)
+            {
+                auto& e(create(*this, entityIdPool));
+                (void)std::initializer_list<int>{
+                    (e.components[TRegistry::template getIdx<TComponents>()] =
+                            componentRecycler.template create<TComponents>(
+                                mComponents),
+                        0)...};
+
+                e.typeIds = typeIds;
+                e.componentCount = sizeof...(TComponents);
+                e.mustRematch = false;
+            }
+
+            for(auto& s : systems)
+                if(Impl::matchesSystem(typeIds, *s))
+                    s->registerEntities(&entities[first], mCount);
+
+            return first;
+        }
+
+        // Destroys every entity of `mGroup`
+        inline void destroyAll(Group mGroup) noexcept
+        {
+            for(auto& e : getEntities(mGroup)) e->destroy();
+        }
+
+        // Destroys every entity
+        inline void destroyAll() noexcept
+        {
+            for(auto& e : entities) e->destroy();
         }
         template <typename T>
         inline void registerSystem(T& mSystem)
         {
-            SSVU_ASSERT_STATIC(ssvu::isBaseOf<Impl::SystemBase, T>(),
+            SSVU_ASSERT_STATIC(ssvu::isBaseOf<SystemBase, T>(),
                 "`T` must derive from `SystemBase`");
-            systems.emplace_back(&mSystem);
+
+            SystemBase& s(mSystem);
+            s.order = systems.size();
+            systems.emplace_back(&s);
+
+#if CESYSTEM_PROFILE
+            s.profiler = &profiler;
+            profiler.addSystem(typeid(T).name());
+#endif
+        }
+
+#if CESYSTEM_PROFILE
+        // Frames recorded so far, one per `refresh`, with systems named
+        // after their type until renamed with `Profiler::setSystemName`
+        inline Profiler& getProfiler() noexcept { return profiler; }
+        inline const Profiler& getProfiler() const noexcept
+        {
+            return profiler;
+        }
+#endif
+
+        // Replaces the content of `mSnapshot` with the whole world: the id
+        // pool, entity stats, type ids, groups and components, and the
+        // order of groups and system tuples. Every component type in use
+        // must be in `TComponents` and have a `ComponentSerializer`.
+        // Changes not yet applied by `refresh`, such as recorded commands,
+        // are not captured.
+        template <typename... TComponents>
+        inline void snapshot(Snapshot& mSnapshot) const
+        {
+            SSVU_ASSERT(dirty.empty());
+
+            mSnapshot.clear();
+            SnapshotWriter writer{mSnapshot};
+            Impl::SnapshotHeader header{Impl::SnapshotHeader::magicValue,
+                std::uint32_t(TRegistry::count),
+                std::uint32_t(systems.size()), entities.size(), 0};
+            writer.write(header);
+            entityIdPool.snapshot(writer);
+
+            for(const auto& e : entities)
+            {
+                SSVU_ASSERT(Impl::containsAll(
+                    TRegistry::template getBitset<TComponents...>(),
+                    e->typeIds));
+
+                // The block is filled before the other components append
+                auto block(writer.append(
+                    getBlockBytes<TComponents...>(e->typeIds)));
+                std::memcpy(block, &e->stat, sizeof(EntityStat));
+                std::memcpy(block + sizeof(EntityStat), &e->typeIds,
+                    sizeof(Bitset));
+                std::memcpy(block + sizeof(EntityStat) + sizeof(Bitset),
+                    &e->groups, sizeof(GroupBitset));
+                block += blockHeaderBytes;
+
+                (void)std::initializer_list<int>{
+                    (saveToBlock<TComponents>(
+                         block, *e, IsTrivial<TComponents>{}),
+                        0)...};
+                (void)std::initializer_list<int>{
+                    (saveToWriter<TComponents>(
+                         writer, *e, IsTrivial<TComponents>{}),
+                        0)...};
+            }
+
+            // Entities are only referred to by id from here on
+            for(const auto& g : grouped)
+            {
+                writer.write(std::uint64_t(g.size()));
+                auto ids(writer.append(g.size() * sizeof(EntityId)));
+                for(const auto& k : g.getKeys())
+                {
+                    const EntityId id(k);
+                    std::memcpy(ids, &id, sizeof(EntityId));
+                    ids += sizeof(EntityId);
+                }
+            }
+
+            for(const auto& s : systems) s->snapshotTuples(writer);
+
+            header.byteCount = mSnapshot.getSize();
+            writer.writeAt(0, header);
+        }
+
+        // Replaces the whole world with a snapshot taken by a manager with
+        // the same systems, registered in the same order. Current entities
+        // leave systems as if destroyed, recorded commands are dropped, and
+        // restored entities join systems immediately, without a `refresh`.
+        // Entity objects and trivially serialized components whose id is
+        // in the snapshot are reused, so restoring a recent snapshot
+        // mostly copies fields. Pointers and handles to current entities
+        // become invalid. Returns false, leaving the world untouched, if
+        // `mSnapshot` was not taken by `snapshot` with the same component
+        // types and systems, or was truncated.
+        template <typename... TComponents>
+        inline bool restore(const Snapshot& mSnapshot)
+        {
+            SnapshotReader reader{mSnapshot};
+            if(!reader.canRead(sizeof(Impl::SnapshotHeader))) return false;
+
+            const auto& header(reader.read<Impl::SnapshotHeader>());
+            if(header.magic != Impl::SnapshotHeader::magicValue ||
+                header.typeCount != TRegistry::count ||
+                header.systemCount != systems.size() ||
+                header.byteCount != mSnapshot.getSize())
+                return false;
+
+            for(auto& s : systems) s->unregisterAll();
+            for(auto& g : grouped) g.clear();
+            for(auto& b : commandBuffers) b.second->clear();
+            dirty.clear();
+
+            // Current entities, by id, until reused or freed at the end
+            auto previous(ssvu::mv(entities));
+            entities.clear();
+            std::vector<SizeT> previousById(
+                entityIdPool.getCapacity(), Impl::nullIdx);
+            for(auto i(0u); i < previous.size(); ++i)
+                previousById[previous[i]->stat.id] = i;
+
+            entityIdPool.restore(reader);
+            std::vector<Entity*> entitiesById(entityIdPool.getCapacity());
+
+            entities.reserve(header.entityCount);
+            for(auto i(0u); i < header.entityCount; ++i)
+            {
+                auto block(reader.skip(blockHeaderBytes));
+                EntityStat stat;
+                Bitset typeIds;
+                std::memcpy(&stat, block, sizeof(EntityStat));
+                std::memcpy(&typeIds, block + sizeof(EntityStat),
+                    sizeof(Bitset));
+
+                const auto& id(SizeT(stat.id));
+                auto& e(id < previousById.size() &&
+                                previousById[id] != Impl::nullIdx
+                            ? reuseEntity(previous[previousById[id]], stat,
+                                  typeIds)
+                            : entityRecycler.getCreateEmplace(
+                                  entities, *this, stat));
+                e.entityIdx = i;
+                e.typeIds = typeIds;
+                std::memcpy(&e.groups, block + sizeof(EntityStat) +
+                                           sizeof(Bitset),
+                    sizeof(GroupBitset));
+                e.componentCount = typeIds.count();
+                e.mustRematch = false;
+
+                // The rest of the block follows its header
+                block = reader.skip(
+                    getBlockBytes<TComponents...>(typeIds) - blockHeaderBytes);
+                (void)std::initializer_list<int>{
+                    (loadFromBlock<TComponents>(
+                         block, e, IsTrivial<TComponents>{}),
+                        0)...};
+                (void)std::initializer_list<int>{
+                    (loadFromReader<TComponents>(
+                         reader, e, IsTrivial<TComponents>{}),
+                        0)...};
+
+                entitiesById[id] = &e;
+            }
+
+            for(auto g(0u); g < maxGroups; ++g)
+            {
+                const auto& count(SizeT(reader.read<std::uint64_t>()));
+                for(auto i(0u); i < count; ++i)
+                {
+                    const auto& id(reader.read<EntityId>());
+                    grouped[g].add(id, entitiesById[id]);
+                    entitiesById[id]->inGroups.set(g);
+                }
+            }
+
+            for(auto& s : systems)
+                s->restoreTuples(reader, entitiesById.data());
+            SSVU_ASSERT(reader.isAtEnd());
+            return true;
+        }
+
+        // Returns the calling thread's command buffer, applied by the next
+        // `refresh`. Only the first call of each thread locks.
+        inline CommandBuffer& getCommands()
+        {
+            static thread_local std::pair<SizeT, CommandBuffer*> cache{
+                Impl::nullIdx, nullptr};
+            if(cache.first == uid) return *cache.second;
+
+            std::lock_guard<std::mutex> lock{commandsMutex};
+            auto& buffer(commandBuffers[std::this_thread::get_id()]);
+            if(buffer == nullptr)
+            {
+                buffer = std::make_unique<CommandBuffer>();
+                buffer->ordinal = nextBufferOrdinal++;
+            }
+
+            cache = {uid, buffer.get()};
+            return *buffer;
         }
 
         inline const decltype(entities)& getEntities() const noexcept
@@ -87,22 +634,20 @@ namespace ssvces
             return entities;
         }
         inline decltype(entities)& getEntities() noexcept { return entities; }
+        // Entities of `mGroup`, packed in a sparse set. Removals only
+        // happen in `refresh`, and move the last entity into the hole.
         inline const std::vector<Entity*>& getEntities(Group mGroup) const
             noexcept
         {
             SSVU_ASSERT(mGroup <= maxGroups);
-            return grouped[mGroup];
+            return grouped[mGroup].getItems();
         }
-        inline std::vector<Entity*>& getEntities(Group mGroup) noexcept
-        {
-            SSVU_ASSERT(mGroup <= maxGroups);
-            return grouped[mGroup];
-        }
-        inline std::vector<EntityHandle> getEntityHandles(Group mGroup) noexcept
+
+        // Same as `getEntities(mGroup)`, creating the handles on the fly
+        inline BasicEntityHandleRange<TRegistry> getEntityHandles(
+            Group mGroup) const noexcept
         {
-            std::vector<EntityHandle> result;
-            for(const auto& e : getEntities(mGroup)) result.emplace_back(*e);
-            return result;
+            return {getEntities(mGroup)};
         }
 
         inline bool hasEntity(Group mGroup) const noexcept
@@ -126,11 +671,12 @@ namespace ssvces
 
     namespace Impl
     {
-        inline bool matchesSystem(
-            const TypeIdxBitset& mTypeIds, const SystemBase& mSystem) noexcept
+        template <typename TRegistry>
+        inline bool matchesSystem(const typename TRegistry::Bitset& mTypeIds,
+            const SystemBase<TRegistry>& mSystem) noexcept
         {
-            return (mTypeIds & mSystem.typeIdsNot).none() &&
-                   containsAll(mTypeIds, mSystem.typeIdsReq);
+            return matchesFilters(
+                mTypeIds, mSystem.typeIdsReq, mSystem.typeIdsNot);
         }
     }
 }
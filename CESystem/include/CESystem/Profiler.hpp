@@ -0,0 +1,243 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_PROFILER
+#define CESYSTEM_PROFILER
+
+namespace ssvces
+{
+    // A `processAll` call, or a refresh phase
+    struct ProfileEvent
+    {
+        SizeT system; // `Impl::nullIdx` for refresh phases
+        SizeT phase;
+        double startUs, durationUs;
+        std::size_t thread;
+    };
+
+    // What a system did during a frame
+    struct SystemProfile
+    {
+        SizeT runs, tuples, added, removed;
+        double processUs;
+    };
+
+    // Phases of `Manager::refresh`
+    enum class RefreshPhase : SizeT
+    {
+        Commands, // Applying command buffers
+        Leave,    // Leaving systems and groups
+        Match,    // Deleting destroyed entities and matching the others
+        Count
+    };
+
+    struct FrameProfile
+    {
+        SizeT frame;
+        double startUs, endUs;
+        std::array<double, SizeT(RefreshPhase::Count)> refreshUs;
+        std::vector<SystemProfile> systems; // By registration order
+        std::vector<ProfileEvent> events;
+    };
+
+    // Keeps the last frames recorded by a `Manager` built with
+    // `CESYSTEM_PROFILE`, where a frame ends with each `refresh`. Times are
+    // in microseconds since the profiler's creation.
+    class Profiler
+    {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        Clock::time_point origin{Clock::now()};
+        std::vector<std::string> systemNames;
+        std::vector<FrameProfile> frames; // Ring buffer
+        SizeT capacity, nextFrame{0};
+        double lastEndUs{0};
+
+        inline static const char* getPhaseName(SizeT mPhase) noexcept
+        {
+            static constexpr const char* names[]{"commands", "leave", "match"};
+            return names[mPhase];
+        }
+
+        // Prints times in fixed notation, with nanosecond precision, and
+        // restores the stream's format on scope exit
+        class FixedFormatGuard
+        {
+        private:
+            std::ostream& stream;
+            std::ios saved{nullptr};
+
+        public:
+            inline FixedFormatGuard(std::ostream& mStream) : stream(mStream)
+            {
+                saved.copyfmt(stream);
+                stream << std::fixed << std::setprecision(3);
+            }
+            inline ~FixedFormatGuard() { stream.copyfmt(saved); }
+        };
+
+        // System names are type names, which need no escaping other than
+        // quotes and backslashes
+        inline static void writeJSONString(
+            std::ostream& mStream, const std::string& mStr)
+        {
+            mStream << '"';
+            for(const auto& c : mStr)
+            {
+                if(c == '"' || c == '\\') mStream << '\\';
+                mStream << c;
+            }
+            mStream << '"';
+        }
+
+    public:
+        inline Profiler(SizeT mCapacity = 300) : capacity{mCapacity}
+        {
+            SSVU_ASSERT(capacity > 0);
+        }
+
+        inline double now() const noexcept
+        {
+            return std::chrono::duration<double, std::micro>(
+                Clock::now() - origin).count();
+        }
+        inline static std::size_t getThreadId() noexcept
+        {
+            return std::hash<std::thread::id>{}(std::this_thread::get_id());
+        }
+
+        // Returns the index of a new system
+        inline SizeT addSystem(std::string mName)
+        {
+            systemNames.emplace_back(ssvu::mv(mName));
+            return systemNames.size() - 1;
+        }
+        inline void setSystemName(SizeT mSystem, std::string mName)
+        {
+            systemNames[mSystem] = ssvu::mv(mName);
+        }
+        inline const std::string& getSystemName(SizeT mSystem) const noexcept
+        {
+            return systemNames[mSystem];
+        }
+
+        // Returns the slot of a new frame, reusing the oldest one's memory
+        // when the buffer is full
+        inline FrameProfile& beginFrame()
+        {
+            if(frames.size() < capacity) frames.emplace_back();
+
+            auto& result(frames[nextFrame % capacity]);
+            result.frame = nextFrame++;
+            result.startUs = lastEndUs;
+            result.systems.clear();
+            result.events.clear();
+            return result;
+        }
+        inline void endFrame(FrameProfile& mFrame) noexcept
+        {
+            lastEndUs = mFrame.endUs;
+        }
+
+        // Recorded frames, from the oldest
+        inline SizeT getFrameCount() const noexcept { return frames.size(); }
+        inline const FrameProfile& getFrame(SizeT mIdx) const noexcept
+        {
+            SSVU_ASSERT(mIdx < frames.size());
+            return frames[(nextFrame - frames.size() + mIdx) % capacity];
+        }
+
+        inline void clear() noexcept
+        {
+            frames.clear();
+            nextFrame = 0;
+        }
+
+        // Keeps the last `mCapacity` frames from now on, dropping the
+        // recorded ones
+        inline void setCapacity(SizeT mCapacity)
+        {
+            SSVU_ASSERT(mCapacity > 0);
+            clear();
+            capacity = mCapacity;
+        }
+
+        // One row per system and refresh phase per frame
+        inline void dumpCSV(std::ostream& mStream) const
+        {
+            FixedFormatGuard guard{mStream};
+            mStream << "frame,kind,name,runs,tuples,added,removed,us\n";
+            for(auto i(0u); i < getFrameCount(); ++i)
+            {
+                const auto& f(getFrame(i));
+                for(auto s(0u); s < f.systems.size(); ++s)
+                {
+                    const auto& p(f.systems[s]);
+                    mStream << f.frame << ",system," << systemNames[s] << ","
+                            << p.runs << "," << p.tuples << "," << p.added
+                            << "," << p.removed << "," << p.processUs << "\n";
+                }
+                for(auto p(0u); p < f.refreshUs.size(); ++p)
+                    mStream << f.frame << ",refresh," << getPhaseName(p)
+                            << ",1,0,0,0," << f.refreshUs[p] << "\n";
+            }
+        }
+
+        // Chrome trace event format, loadable in `chrome://tracing` or
+        // Perfetto: a slice per `processAll` call and refresh phase, and
+        // tuple count tracks
+        inline void dumpChromeTrace(std::ostream& mStream) const
+        {
+            FixedFormatGuard guard{mStream};
+
+            // Small thread ids read better than hashes
+            std::unordered_map<std::size_t, SizeT> threads;
+            const auto& getTid([&threads](std::size_t mThread)
+                {
+                    return threads.emplace(mThread, threads.size())
+                        .first->second;
+                });
+
+            const char* separator{"\n"};
+            mStream << "{\"traceEvents\":[";
+
+            for(auto i(0u); i < getFrameCount(); ++i)
+            {
+                const auto& f(getFrame(i));
+                for(const auto& e : f.events)
+                {
+                    mStream << separator << "{\"name\":";
+                    if(e.system != Impl::nullIdx)
+                        writeJSONString(mStream, systemNames[e.system]);
+                    else
+                        writeJSONString(mStream,
+                            std::string{"refresh "} + getPhaseName(e.phase));
+
+                    mStream << ",\"ph\":\"X\",\"pid\":0,\"tid\":"
+                            << getTid(e.thread) << ",\"ts\":" << e.startUs
+                            << ",\"dur\":" << e.durationUs
+                            << ",\"args\":{\"frame\":" << f.frame << "}}";
+                    separator = ",\n";
+                }
+
+                mStream << separator
+                        << "{\"name\":\"tuples\",\"ph\":\"C\",\"pid\":0,"
+                        << "\"ts\":" << f.endUs << ",\"args\":{";
+                for(auto s(0u); s < f.systems.size(); ++s)
+                {
+                    if(s != 0) mStream << ",";
+                    writeJSONString(mStream, systemNames[s]);
+                    mStream << ":" << f.systems[s].tuples;
+                }
+                mStream << "}}";
+                separator = ",\n";
+            }
+
+            mStream << "\n]}\n";
+        }
+    };
+}
+
+#endif
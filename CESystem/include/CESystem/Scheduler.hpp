@@ -0,0 +1,153 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_SCHEDULER
+#define CESYSTEM_SCHEDULER
+
+namespace ssvces
+{
+    // Runs a frame's system tasks on a `ThreadPool`. Tasks are ordered as
+    // they were added, but a task only waits for the earlier ones it
+    // conflicts with: a task writing a component waits for every earlier
+    // task accessing it, and a task reading it waits for earlier writers.
+    // `Manager::refresh` is not scheduled and must run between frames.
+    template <typename TRegistry>
+    class BasicScheduler
+    {
+    private:
+        using Bitset = typename TRegistry::Bitset;
+
+        struct Node
+        {
+            ssvu::Func<void()> task;
+            Bitset reads, writes;
+            bool exclusive;
+            std::vector<SizeT> successors;
+            SizeT dependencyCount;
+        };
+
+        ThreadPool& pool;
+        std::vector<Node> nodes;
+        ssvu::UPtr<std::atomic<SizeT>[]> pendingDependencies;
+        std::atomic<SizeT> remaining{0};
+        bool mustBuild{false};
+
+        inline static bool conflict(const Node& mA, const Node& mB) noexcept
+        {
+            return mA.exclusive || mB.exclusive ||
+                   (mA.writes & (mB.reads | mB.writes)).any() ||
+                   (mB.writes & mA.reads).any();
+        }
+
+        inline void build()
+        {
+            for(auto& n : nodes)
+            {
+                n.successors.clear();
+                n.dependencyCount = 0;
+            }
+
+            for(auto j(0u); j < nodes.size(); ++j)
+                for(auto i(0u); i < j; ++i)
+                    if(conflict(nodes[i], nodes[j]))
+                    {
+                        nodes[i].successors.emplace_back(j);
+                        ++nodes[j].dependencyCount;
+                    }
+
+            pendingDependencies.reset(new std::atomic<SizeT>[nodes.size()]);
+            mustBuild = false;
+        }
+
+        inline void schedule(SizeT mIdx)
+        {
+            pool.push([this, mIdx]
+                {
+                    const auto& node(nodes[mIdx]);
+                    node.task();
+
+                    for(const auto& s : node.successors)
+                        if(--pendingDependencies[s] == 0) schedule(s);
+
+                    --remaining;
+                });
+        }
+
+        inline void add(const Bitset& mReads, const Bitset& mWrites,
+            bool mExclusive, ssvu::Func<void()> mTask)
+        {
+            nodes.push_back({ssvu::mv(mTask), mReads, mWrites, mExclusive,
+                {}, 0});
+            mustBuild = true;
+        }
+
+    public:
+        inline BasicScheduler(ThreadPool& mPool) noexcept : pool(mPool) {}
+
+        inline BasicScheduler(const BasicScheduler&) = delete;
+        inline BasicScheduler& operator=(const BasicScheduler&) = delete;
+
+        // Adds `mTask`, which must only access `mSystem`'s required
+        // components (without writing the const ones) and must only make
+        // structural changes, such as destroying entities or adding and
+        // removing components, through `Manager::getCommands`
+        template <typename T, typename TF>
+        inline void add(T& mSystem, TF&& mTask)
+        {
+            SSVU_ASSERT_STATIC(
+                ssvu::isBaseOf<Impl::SystemBase<TRegistry>, T>(),
+                "`T` must derive from `SystemBase`");
+            add(mSystem.getReadTypeIds(), mSystem.getWriteTypeIds(), false,
+                FWD(mTask));
+        }
+
+        // Adds a task which runs alone, after every earlier task and before
+        // every later one
+        template <typename TF>
+        inline void addExclusive(TF&& mTask)
+        {
+            add({}, {}, true, FWD(mTask));
+        }
+
+        // Runs every task once and waits for them to complete
+        inline void run()
+        {
+            if(mustBuild) build();
+
+            remaining = nodes.size();
+            for(auto i(0u); i < nodes.size(); ++i)
+                pendingDependencies[i] = nodes[i].dependencyCount;
+
+            for(auto i(0u); i < nodes.size(); ++i)
+                if(nodes[i].dependencyCount == 0) schedule(i);
+
+            pool.helpUntil([this]
+                {
+                    return remaining == 0;
+                });
+        }
+
+        inline void clear()
+        {
+            nodes.clear();
+            mustBuild = true;
+        }
+
+        inline SizeT getTaskCount() const noexcept { return nodes.size(); }
+
+        // Returns the indices of the tasks `mIdx` must wait for
+        inline std::vector<SizeT> getDependencies(SizeT mIdx)
+        {
+            if(mustBuild) build();
+
+            std::vector<SizeT> result;
+            for(auto i(0u); i < mIdx; ++i)
+                if(ssvu::contains(nodes[i].successors, mIdx))
+                    result.emplace_back(i);
+            return result;
+        }
+    };
+}
+
+#endif
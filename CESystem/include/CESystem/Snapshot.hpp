@@ -0,0 +1,276 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_SNAPSHOT
+#define CESYSTEM_SNAPSHOT
+
+namespace ssvces
+{
+    // Contiguous binary image of a `Manager`, written by
+    // `Manager::snapshot` and read by `Manager::restore`. The memory is
+    // kept between snapshots, so taking one every frame does not allocate.
+    // The layout depends on the platform and on the component type
+    // indices, so a snapshot must be restored by the same build.
+    class Snapshot
+    {
+        friend class SnapshotWriter;
+
+    private:
+        std::vector<char> data; // Allocated with the default new alignment
+        SizeT size{0};
+
+    public:
+        inline Snapshot() = default;
+
+        // Copies a blob previously obtained with `getData`
+        inline Snapshot(const char* mData, SizeT mSize)
+        {
+            assign(mData, mSize);
+        }
+
+        inline void assign(const char* mData, SizeT mSize)
+        {
+            if(mSize > data.size()) data.resize(mSize);
+            std::copy(mData, mData + mSize, std::begin(data));
+            size = mSize;
+        }
+        inline void clear() noexcept { size = 0; }
+
+        inline const char* getData() const noexcept { return data.data(); }
+        inline SizeT getSize() const noexcept { return size; }
+        inline bool isEmpty() const noexcept { return size == 0; }
+    };
+
+    // Appends bytes to a `Snapshot`
+    class SnapshotWriter
+    {
+    private:
+        Snapshot& snapshot;
+
+    public:
+        inline SnapshotWriter(Snapshot& mSnapshot) noexcept
+            : snapshot(mSnapshot)
+        {
+        }
+
+        // Appends `mBytes` bytes to be filled by the caller, and returns
+        // their address, valid until the next append
+        inline char* append(SizeT mBytes)
+        {
+            auto& data(snapshot.data);
+            const auto& needed(snapshot.size + mBytes);
+            if(needed > data.size())
+                data.resize(std::max(needed, data.size() * 2));
+
+            auto result(data.data() + snapshot.size);
+            snapshot.size = needed;
+            return result;
+        }
+
+        inline void write(const void* mData, SizeT mBytes)
+        {
+            std::memcpy(append(mBytes), mData, mBytes);
+        }
+        template <typename T>
+        inline void write(const T& mValue)
+        {
+            SSVU_ASSERT_STATIC(std::is_trivially_copyable<T>(),
+                "`T` must be trivially copyable");
+            write(&mValue, sizeof(T));
+        }
+
+        // Overwrites a value already written at byte `mPos`
+        template <typename T>
+        inline void writeAt(SizeT mPos, const T& mValue) noexcept
+        {
+            SSVU_ASSERT_STATIC(std::is_trivially_copyable<T>(),
+                "`T` must be trivially copyable");
+            SSVU_ASSERT(mPos + sizeof(T) <= snapshot.size);
+            std::memcpy(snapshot.data.data() + mPos, &mValue, sizeof(T));
+        }
+    };
+
+    // Reads back what a `SnapshotWriter` wrote, in the same order
+    class SnapshotReader
+    {
+    private:
+        const char* data;
+        SizeT size, pos{0};
+
+    public:
+        inline SnapshotReader(const Snapshot& mSnapshot) noexcept
+            : data{mSnapshot.getData()},
+              size{mSnapshot.getSize()}
+        {
+        }
+
+        // Returns the address of the next `mBytes` bytes, and skips them
+        inline const char* skip(SizeT mBytes) noexcept
+        {
+            SSVU_ASSERT(pos + mBytes <= size);
+            const auto result(data + pos);
+            pos += mBytes;
+            return result;
+        }
+
+        inline void read(void* mData, SizeT mBytes) noexcept
+        {
+            std::memcpy(mData, skip(mBytes), mBytes);
+        }
+        template <typename T>
+        inline T read() noexcept
+        {
+            SSVU_ASSERT_STATIC(std::is_trivially_copyable<T>(),
+                "`T` must be trivially copyable");
+            T result;
+            read(&result, sizeof(T));
+            return result;
+        }
+
+        inline bool canRead(SizeT mBytes) const noexcept
+        {
+            return mBytes <= size - pos;
+        }
+        inline bool isAtEnd() const noexcept { return pos == size; }
+    };
+
+    // Tells snapshots how to store a component type. Components opt in by
+    // specializing it with two static functions:
+    //
+    //     static void save(SnapshotWriter&, const T&);
+    //     static T load(SnapshotReader&); // Or `const T&`
+    //
+    // where `load` reads back what `save` wrote.
+    template <typename T>
+    struct ComponentSerializer
+    {
+        SSVU_ASSERT_STATIC(sizeof(T) == 0,
+            "Specialize `ComponentSerializer` for every component type "
+            "in a snapshot");
+    };
+
+    namespace Impl
+    {
+        // Checked by `Manager::restore` before touching the world
+        struct SnapshotHeader
+        {
+            static constexpr std::uint32_t magicValue{0x53454373}; // "sCES"
+
+            std::uint32_t magic, typeCount, systemCount;
+            std::uint64_t entityCount, byteCount;
+        };
+
+        // Base of the serializers whose components `Manager::snapshot`
+        // writes together with the entity's stat, type ids and groups
+        struct TrivialSerializerTag
+        {
+        };
+
+        inline constexpr bool allOf(std::initializer_list<bool> mValues)
+        {
+            for(const auto& v : mValues)
+                if(!v) return false;
+            return true;
+        }
+        inline constexpr SizeT sumOf(std::initializer_list<SizeT> mValues)
+        {
+            SizeT result{0};
+            for(const auto& v : mValues) result += v;
+            return result;
+        }
+    }
+
+    // Fast path for components whose state is a few trivially copyable
+    // members. `TFields` are their types, and the specialization returns
+    // references to them, in the same order, from `getFields`:
+    //
+    //     template <>
+    //     struct ComponentSerializer<CPosition>
+    //         : TrivialComponentSerializer<CPosition, float, float>
+    //     {
+    //         inline static auto getFields(const CPosition& mC)
+    //         {
+    //             return std::tie(mC.x, mC.y);
+    //         }
+    //     };
+    //
+    // Each member is copied with `memcpy`, unaligned, and `load` passes
+    // them back to a constructor of `T`. The component itself is never
+    // copied as bytes: it is polymorphic, so that would copy its vptr and
+    // read an object that was never constructed. When the restored entity
+    // already has the component, `restore` writes the members into it
+    // instead, so they must be the component's whole state.
+    template <typename T, typename... TFields>
+    struct TrivialComponentSerializer : Impl::TrivialSerializerTag
+    {
+        SSVU_ASSERT_STATIC(
+            Impl::allOf({std::is_trivially_copyable<TFields>()...}),
+            "Every field must be trivially copyable");
+
+        static constexpr SizeT size{Impl::sumOf({sizeof(TFields)...})};
+
+    private:
+        template <typename TTpl, std::size_t... TIs>
+        inline static void saveImpl(
+            char* mData, const TTpl& mFields, std::index_sequence<TIs...>)
+        {
+            SSVU_ASSERT_STATIC(std::is_same<std::decay_t<TTpl>,
+                                   Tpl<const TFields&...>>(),
+                "`getFields` must return references to `TFields`");
+
+            (void)std::initializer_list<int>{
+                (std::memcpy(mData, &std::get<TIs>(mFields), sizeof(TFields)),
+                    mData += sizeof(TFields), 0)...};
+        }
+        template <std::size_t... TIs>
+        inline static T loadImpl(
+            const char* mData, std::index_sequence<TIs...>)
+        {
+            Tpl<TFields...> fields;
+            (void)std::initializer_list<int>{
+                (std::memcpy(&std::get<TIs>(fields), mData, sizeof(TFields)),
+                    mData += sizeof(TFields), 0)...};
+            return T(std::get<TIs>(fields)...);
+        }
+        template <std::size_t... TIs>
+        inline static void loadImpl(
+            const char* mData, T& mComponent, std::index_sequence<TIs...>)
+        {
+            // The references are const, but `mComponent` is not
+            const auto& fields(ComponentSerializer<T>::getFields(mComponent));
+            (void)std::initializer_list<int>{
+                (std::memcpy(const_cast<TFields*>(&std::get<TIs>(fields)),
+                     mData, sizeof(TFields)),
+                    mData += sizeof(TFields), 0)...};
+        }
+
+    public:
+        // `size` bytes at `mData`
+        inline static void save(char* mData, const T& mComponent)
+        {
+            saveImpl(mData, ComponentSerializer<T>::getFields(mComponent),
+                std::index_sequence_for<TFields...>{});
+        }
+        inline static T load(const char* mData)
+        {
+            return loadImpl(mData, std::index_sequence_for<TFields...>{});
+        }
+        inline static void load(const char* mData, T& mComponent)
+        {
+            loadImpl(
+                mData, mComponent, std::index_sequence_for<TFields...>{});
+        }
+
+        inline static void save(SnapshotWriter& mWriter, const T& mComponent)
+        {
+            save(mWriter.append(size), mComponent);
+        }
+        inline static T load(SnapshotReader& mReader)
+        {
+            return load(mReader.skip(size));
+        }
+    };
+}
+
+#endif
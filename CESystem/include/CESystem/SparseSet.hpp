@@ -0,0 +1,87 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_SPARSESET
+#define CESYSTEM_SPARSESET
+
+namespace ssvces
+{
+    namespace Impl
+    {
+        // Set of pointers keyed by small integers, such as entity ids.
+        // Elements and their keys are packed in dense arrays for linear
+        // iteration, and `sparse` maps a key back to its dense position, so
+        // adding, removing and lookups are O(1). Removing moves the last
+        // element into the hole.
+        template <typename T>
+        class SparseSet
+        {
+        private:
+            std::vector<T*> items;
+            std::vector<SizeT> keys;
+            std::vector<SizeT> sparse;
+
+        public:
+            inline bool contains(SizeT mKey) const noexcept
+            {
+                return mKey < sparse.size() && sparse[mKey] != nullIdx;
+            }
+
+            // Returns the element of `mKey`, or `nullptr`
+            inline T* get(SizeT mKey) const noexcept
+            {
+                return contains(mKey) ? items[sparse[mKey]] : nullptr;
+            }
+
+            // `mKey` must not be in the set
+            inline void add(SizeT mKey, T* mItem)
+            {
+                SSVU_ASSERT(!contains(mKey));
+                if(mKey >= sparse.size()) sparse.resize(mKey + 1, nullIdx);
+
+                sparse[mKey] = items.size();
+                items.emplace_back(mItem);
+                keys.emplace_back(mKey);
+            }
+
+            // `mKey` must be in the set
+            inline void remove(SizeT mKey) noexcept
+            {
+                SSVU_ASSERT(contains(mKey));
+                const auto idx(sparse[mKey]);
+
+                if(idx != items.size() - 1)
+                {
+                    items[idx] = items.back();
+                    keys[idx] = keys.back();
+                    sparse[keys[idx]] = idx;
+                }
+
+                items.pop_back();
+                keys.pop_back();
+                sparse[mKey] = nullIdx;
+            }
+
+            inline void clear() noexcept
+            {
+                items.clear();
+                keys.clear();
+                sparse.clear();
+            }
+
+            inline const std::vector<T*>& getItems() const noexcept
+            {
+                return items;
+            }
+            inline const std::vector<SizeT>& getKeys() const noexcept
+            {
+                return keys;
+            }
+            inline SizeT size() const noexcept { return items.size(); }
+            inline bool empty() const noexcept { return items.empty(); }
+        };
+    }
+}
+
+#endif
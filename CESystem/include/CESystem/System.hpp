@@ -12,9 +12,12 @@ namespace ssvces
         template <typename... TArgs>
         struct Filter
         {
-            static constexpr const TypeIdxBitset& getTypeIds() noexcept
+            // A reference to a static bitset for `DynamicComponents`, and a
+            // constant expression for a `ComponentList`
+            template <typename TRegistry = DynamicComponents>
+            inline static constexpr decltype(auto) getTypeIds() noexcept
             {
-                return Impl::getTypeIdxBitset<TArgs...>();
+                return TRegistry::template getBitset<TArgs...>();
             }
         };
 
@@ -45,11 +48,21 @@ namespace ssvces
         };
     }
 
+    // Required components - const-qualified ones are only read by the
+    // system, which lets `Scheduler` run it alongside other readers
     template <typename... TArgs>
     struct Req : public Impl::Filter<TArgs...>
     {
-        using TplType = Tpl<Entity*, TArgs*...>;
-        inline static TplType createTuple(Entity& mEntity)
+        template <typename TRegistry = DynamicComponents>
+        inline static constexpr decltype(auto) getWriteTypeIds() noexcept
+        {
+            return TRegistry::template getWriteBitset<TArgs...>();
+        }
+
+        template <typename TEntity>
+        using TplType = Tpl<TEntity*, TArgs*...>;
+        template <typename TEntity>
+        inline static TplType<TEntity> createTuple(TEntity& mEntity)
         {
             return ssvu::tplCat(std::make_tuple(&mEntity),
                 buildComponentsTpl<TArgs...>(mEntity));
@@ -78,51 +91,159 @@ namespace ssvces
     {
     };
 
-    template <typename TDerived, typename TReq, typename TNot = Not<>>
-    class System : public Impl::SystemBase
+    template <typename TRegistry, typename TDerived, typename TReq,
+        typename TNot = Not<>>
+    class BasicSystem : public Impl::SystemBase<TRegistry>
     {
+    protected:
+        // Lets derived systems take an `Entity&` whatever the registry
+        using Entity = BasicEntity<TRegistry>;
+
     private:
-        using Tpl = typename TReq::TplType;
+        using EntityRecyclerPtr = BasicEntityRecyclerPtr<TRegistry>;
+        using Tpl = typename TReq::template TplType<Entity>;
         std::vector<Tpl> tuples;
 
+        // Index of each entity's tuple, by entity id
+        std::vector<SizeT> indices;
+
         inline static constexpr Entity& getEntity(const Tpl& mTpl) noexcept
         {
             return *std::get<Entity*>(mTpl);
         }
         inline auto& getTD() noexcept { return ssvu::castUp<TDerived>(*this); }
 
-        inline void refresh() override
-        {
-            ssvu::eraseRemoveIf(tuples, [this](const Tpl& mTpl)
-                {
-                    if(getEntity(mTpl).mustDestroy ||
-                        getEntity(mTpl).mustRematch)
-                    {
-                        TReq::onRemoved(getTD(), mTpl);
-                        return true;
-                    }
-                    return false;
-                });
-        }
         inline void registerEntity(Entity& mEntity) override
         {
+            const auto& id(SizeT(mEntity.stat.id));
+            if(id >= indices.size()) indices.resize(id + 1, Impl::nullIdx);
+
+            // The id may still belong to a destroyed entity awaiting refresh
+            if(indices[id] != Impl::nullIdx)
+                unregisterEntity(getEntity(tuples[indices[id]]));
+
             auto tpl(TReq::createTuple(mEntity));
+            indices[id] = tuples.size();
             tuples.emplace_back(tpl);
             TReq::onAdded(getTD(), tpl);
+            this->countAdded();
+        }
+        inline void registerEntities(
+            const EntityRecyclerPtr* mEntities, SizeT mCount) override
+        {
+            Impl::reserveMore(tuples, mCount);
+            for(auto i(0u); i < mCount; ++i) registerEntity(*mEntities[i]);
+        }
+        inline void unregisterEntity(Entity& mEntity) override
+        {
+            const auto& id(SizeT(mEntity.stat.id));
+            if(id >= indices.size() || indices[id] == Impl::nullIdx) return;
+
+            const auto idx(indices[id]);
+            if(&getEntity(tuples[idx]) != &mEntity) return;
+
+            TReq::onRemoved(getTD(), tuples[idx]);
+            this->countRemoved();
+            indices[id] = Impl::nullIdx;
+
+            // Swap-and-pop, fixing the back-index of the moved tuple
+            if(idx != tuples.size() - 1)
+            {
+                tuples[idx] = tuples.back();
+                indices[getEntity(tuples[idx]).stat.id] = idx;
+            }
+            tuples.pop_back();
+        }
+        inline void unregisterAll() override
+        {
+            for(auto& t : tuples)
+            {
+                TReq::onRemoved(getTD(), t);
+                this->countRemoved();
+            }
+
+            tuples.clear();
+            indices.clear();
+        }
+
+        // The ids come from the back-indices, which avoids visiting every
+        // entity
+        inline void snapshotTuples(SnapshotWriter& mWriter) const override
+        {
+            mWriter.write(std::uint64_t(tuples.size()));
+            auto ids(mWriter.append(tuples.size() * sizeof(EntityId)));
+
+            for(auto id(0u); id < indices.size(); ++id)
+            {
+                if(indices[id] == Impl::nullIdx) continue;
+                const EntityId value(id);
+                std::memcpy(ids + indices[id] * sizeof(EntityId), &value,
+                    sizeof(EntityId));
+            }
+        }
+        inline void restoreTuples(
+            SnapshotReader& mReader, Entity* const* mEntitiesById) override
+        {
+            const auto& count(SizeT(mReader.read<std::uint64_t>()));
+            Impl::reserveMore(tuples, count);
+            for(auto i(0u); i < count; ++i)
+                registerEntity(*mEntitiesById[mReader.read<EntityId>()]);
         }
 
     public:
-        inline System() noexcept
-            : SystemBase{TReq::getTypeIds(), TNot::getTypeIds()}
+        inline BasicSystem() noexcept
+            : Impl::SystemBase<TRegistry>{
+                  TReq::template getTypeIds<TRegistry>(),
+                  TNot::template getTypeIds<TRegistry>(),
+                  TReq::template getWriteTypeIds<TRegistry>()}
         {
         }
+        inline SizeT getTupleCount() const noexcept override
+        {
+            return tuples.size();
+        }
+
         template <typename... TArgs>
         inline void processAll(TArgs&&... mArgs)
         {
-            for(auto& t : tuples)
-                TReq::onProcess(getTD(), t, std::make_tuple(FWD(mArgs)...));
+            const auto& startUs(this->beginProfile());
+            Impl::CommandContextGuard guard{this->order, this->runs++};
+            for(auto i(0u); i < tuples.size(); ++i)
+            {
+                guard.setItem(i);
+                TReq::onProcess(
+                    getTD(), tuples[i], std::make_tuple(FWD(mArgs)...));
+            }
+            this->endProfile(startUs);
+        }
+
+        // Splits the tuples into ranges of at least `mMinChunk` processed
+        // concurrently by `mPool`. `process` must then be safe to call from
+        // several threads, and must only make structural changes through
+        // `Manager::getCommands`.
+        template <typename... TArgs>
+        inline void processAllParallel(
+            ThreadPool& mPool, SizeT mMinChunk, TArgs&&... mArgs)
+        {
+            const auto& startUs(this->beginProfile());
+            const auto run(this->runs++);
+            mPool.parallelFor(tuples.size(), mMinChunk,
+                [&](SizeT mBegin, SizeT mEnd)
+                {
+                    Impl::CommandContextGuard guard{this->order, run};
+                    for(auto i(mBegin); i < mEnd; ++i)
+                    {
+                        guard.setItem(i);
+                        TReq::onProcess(
+                            getTD(), tuples[i], std::make_tuple(mArgs...));
+                    }
+                });
+            this->endProfile(startUs);
         }
     };
+
+    template <typename TDerived, typename TReq, typename TNot = Not<>>
+    using System = BasicSystem<DynamicComponents, TDerived, TReq, TNot>;
 }
 
 #endif
@@ -9,33 +9,127 @@ namespace ssvces
 {
     namespace Impl
     {
+        template <typename TRegistry>
         class SystemBase
         {
-            friend bool matchesSystem(
-                const TypeIdxBitset&, const SystemBase&) noexcept;
-            friend ssvces::Manager;
+            template <typename TR>
+            friend bool matchesSystem(const typename TR::Bitset&,
+                const SystemBase<TR>&) noexcept;
+            friend ssvces::BasicManager<TRegistry>;
+
+        protected:
+            using Bitset = typename TRegistry::Bitset;
+            using Entity = BasicEntity<TRegistry>;
+            using EntityRecyclerPtr = BasicEntityRecyclerPtr<TRegistry>;
 
         private:
-            TypeIdxBitset typeIdsReq, typeIdsNot;
+            Bitset typeIdsReq, typeIdsNot, typeIdsWrite;
+
+#if CESYSTEM_PROFILE
+            // Counters since the last refresh, only written by the thread
+            // processing the system
+            Profiler* profiler{nullptr};
+            SizeT profileRuns{0}, profileAdded{0}, profileRemoved{0};
+            double profileUs{0};
+            std::vector<ProfileEvent> profileEvents;
+
+            inline void flushProfile(FrameProfile& mFrame)
+            {
+                mFrame.systems.push_back({profileRuns, getTupleCount(),
+                    profileAdded, profileRemoved, profileUs});
+                mFrame.events.insert(std::end(mFrame.events),
+                    std::begin(profileEvents), std::end(profileEvents));
+
+                profileRuns = profileAdded = profileRemoved = 0;
+                profileUs = 0;
+                profileEvents.clear();
+            }
+#endif
 
         protected:
-            inline SystemBase(const TypeIdxBitset& mTypeIdsReq)
-                : typeIdsReq{mTypeIdsReq}
+            // Registration index and number of processing runs, which
+            // order the commands recorded while processing
+            SizeT order{nullIdx}, runs{0};
+
+            // Instrumentation hooks, empty unless `CESYSTEM_PROFILE` is set
+            inline double beginProfile() const noexcept
+            {
+#if CESYSTEM_PROFILE
+                if(profiler != nullptr) return profiler->now();
+#endif
+                return 0;
+            }
+            inline void endProfile(double mStartUs)
+            {
+#if CESYSTEM_PROFILE
+                if(profiler == nullptr) return;
+
+                const auto& durationUs(profiler->now() - mStartUs);
+                ++profileRuns;
+                profileUs += durationUs;
+                profileEvents.push_back({order, 0, mStartUs, durationUs,
+                    Profiler::getThreadId()});
+#else
+                (void)mStartUs;
+#endif
+            }
+            inline void countAdded() noexcept
+            {
+#if CESYSTEM_PROFILE
+                ++profileAdded;
+#endif
+            }
+            inline void countRemoved() noexcept
+            {
+#if CESYSTEM_PROFILE
+                ++profileRemoved;
+#endif
+            }
+
+            inline SystemBase(const Bitset& mTypeIdsReq)
+                : typeIdsReq{mTypeIdsReq}, typeIdsWrite{mTypeIdsReq}
+            {
+            }
+            inline SystemBase(const Bitset& mTypeIdsReq,
+                const Bitset& mTypeIdsNot)
+                : typeIdsReq{mTypeIdsReq}, typeIdsNot{mTypeIdsNot},
+                  typeIdsWrite{mTypeIdsReq}
             {
             }
-            inline SystemBase(const TypeIdxBitset& mTypeIdsReq,
-                const TypeIdxBitset& mTypeIdsNot)
-                : typeIdsReq{mTypeIdsReq}, typeIdsNot{mTypeIdsNot}
+            inline SystemBase(const Bitset& mTypeIdsReq,
+                const Bitset& mTypeIdsNot, const Bitset& mTypeIdsWrite)
+                : typeIdsReq{mTypeIdsReq}, typeIdsNot{mTypeIdsNot},
+                  typeIdsWrite{mTypeIdsWrite}
             {
             }
             inline virtual ~SystemBase() noexcept {}
 
             virtual void registerEntity(Entity&) = 0;
-            virtual void refresh() = 0;
+            virtual void registerEntities(const EntityRecyclerPtr*, SizeT) = 0;
+            virtual void unregisterEntity(Entity&) = 0;
+            virtual void unregisterAll() = 0;
+
+            // Tuple order, as entity ids, so that restored systems process
+            // entities in the same order
+            virtual void snapshotTuples(SnapshotWriter&) const = 0;
+            virtual void restoreTuples(SnapshotReader&, Entity* const*) = 0;
 
         public:
             inline SystemBase(const SystemBase&) = delete;
             inline SystemBase& operator=(const SystemBase&) = delete;
+
+            virtual SizeT getTupleCount() const noexcept = 0;
+
+            // Components accessed by `process` - required components are
+            // read, and the non-const ones are also written
+            inline const Bitset& getReadTypeIds() const noexcept
+            {
+                return typeIdsReq;
+            }
+            inline const Bitset& getWriteTypeIds() const noexcept
+            {
+                return typeIdsWrite;
+            }
         };
     }
 }
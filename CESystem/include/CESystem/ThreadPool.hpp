@@ -0,0 +1,142 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef CESYSTEM_THREADPOOL
+#define CESYSTEM_THREADPOOL
+
+namespace ssvces
+{
+    // Fixed set of worker threads consuming a shared job queue. Threads
+    // waiting for jobs to complete run queued jobs themselves, so jobs can
+    // wait for other jobs without deadlocking the pool.
+    class ThreadPool
+    {
+    private:
+        std::vector<std::thread> workers;
+        std::deque<ssvu::Func<void()>> jobs;
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool stopping{false};
+
+        inline void runWorker()
+        {
+            while(true)
+            {
+                ssvu::Func<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock{mtx};
+                    cv.wait(lock, [this]
+                        {
+                            return stopping || !jobs.empty();
+                        });
+
+                    if(jobs.empty()) return;
+                    job = ssvu::mv(jobs.front());
+                    jobs.pop_front();
+                }
+                job();
+            }
+        }
+
+    public:
+        // The calling thread also runs jobs while waiting, so by default one
+        // hardware thread is left to it
+        inline static SizeT getDefaultWorkerCount() noexcept
+        {
+            const auto hardware(std::thread::hardware_concurrency());
+            return hardware > 1 ? hardware - 1 : 0;
+        }
+
+        inline ThreadPool(SizeT mWorkerCount = getDefaultWorkerCount())
+        {
+            for(auto i(0u); i < mWorkerCount; ++i)
+                workers.emplace_back([this]
+                    {
+                        runWorker();
+                    });
+        }
+
+        inline ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock{mtx};
+                stopping = true;
+            }
+            cv.notify_all();
+            for(auto& w : workers) w.join();
+        }
+
+        inline ThreadPool(const ThreadPool&) = delete;
+        inline ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename TF>
+        inline void push(TF&& mJob)
+        {
+            {
+                std::lock_guard<std::mutex> lock{mtx};
+                jobs.emplace_back(FWD(mJob));
+            }
+            cv.notify_one();
+        }
+
+        // Runs a queued job on the calling thread, if there is one
+        inline bool runPending()
+        {
+            ssvu::Func<void()> job;
+            {
+                std::lock_guard<std::mutex> lock{mtx};
+                if(jobs.empty()) return false;
+                job = ssvu::mv(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+            return true;
+        }
+
+        // Runs queued jobs until `mDone` returns true
+        template <typename TF>
+        inline void helpUntil(const TF& mDone)
+        {
+            while(!mDone())
+                if(!runPending()) std::this_thread::yield();
+        }
+
+        // Calls `mFn(begin, end)` over ranges of [0, `mCount`) of at least
+        // `mMinChunk` elements, one per thread at most, and waits for them
+        template <typename TF>
+        inline void parallelFor(SizeT mCount, SizeT mMinChunk, const TF& mFn)
+        {
+            const auto minChunk(std::max(mMinChunk, SizeT(1)));
+            const auto chunks(std::min(
+                workers.size() + 1, (mCount + minChunk - 1) / minChunk));
+
+            if(chunks <= 1)
+            {
+                mFn(SizeT(0), mCount);
+                return;
+            }
+
+            const auto& chunkSize((mCount + chunks - 1) / chunks);
+            std::atomic<SizeT> remaining{chunks - 1};
+
+            for(auto i(SizeT(1)); i < chunks; ++i)
+                push([&, i]
+                    {
+                        const auto end(std::min(mCount, (i + 1) * chunkSize));
+                        mFn(std::min(end, i * chunkSize), end);
+                        --remaining;
+                    });
+
+            mFn(SizeT(0), chunkSize);
+            helpUntil([&remaining]
+                {
+                    return remaining == 0;
+                });
+        }
+
+        inline SizeT getWorkerCount() const noexcept { return workers.size(); }
+    };
+}
+
+#endif
@@ -16,6 +16,48 @@ namespace impl
         using storage_type = TStoragePolicy;
         using signature = typename storage_type::signature;
 
+        storage_type _storage;
+
     public:
+        template <typename TF>
+        void emplace(TF&& f)
+        {
+            _storage.emplace(FWD(f));
+        }
+
+        template <typename... Ts>
+        void call_all(Ts&&... xs)
+        {
+            _storage.call_all(FWD(xs)...);
+        }
+
+        void clear() noexcept
+        {
+            _storage.clear();
+        }
+
+        void reserve(std::size_t bytes)
+        {
+            _storage.reserve(bytes);
+        }
+
+        auto size() const noexcept
+        {
+            return _storage.size();
+        }
+
+        auto empty() const noexcept
+        {
+            return _storage.empty();
+        }
     };
-}
\ No newline at end of file
+}
+
+/// @brief Function queue growing as needed, see
+/// `impl::storage::dynamic_storage`.
+/// @details It can hold move-only callables, but copying a queue holding
+/// one throws `std::logic_error`.
+template <typename TSignature, typename TAllocator = std::allocator<char>>
+using dynamic_function_queue =
+    impl::base_function_queue<impl::storage::dynamic_storage<TSignature,
+        complete_vtable_type<TSignature>, TAllocator>>;
\ No newline at end of file
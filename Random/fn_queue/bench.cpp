@@ -0,0 +1,105 @@
+#include <chrono>
+#include "./base_fn_queue.cpp"
+
+// Queues deferred callbacks every frame, calls them and clears the queue,
+// with a `dynamic_function_queue` and with a `std::vector` of
+// `std::function`. Both keep their memory between frames, but
+// `std::function` allocates every callable larger than its small buffer.
+
+constexpr std::size_t frames = 200;
+constexpr std::size_t callables_per_frame = 10000;
+
+using hr_clock = std::chrono::high_resolution_clock;
+
+template <std::size_t TPayload>
+struct callback
+{
+    long& _acc;
+    std::array<char, TPayload> _payload;
+
+    callback(long& acc, char x) : _acc(acc)
+    {
+        _payload.fill(x);
+    }
+
+    void operator()()
+    {
+        _acc += _payload[TPayload - 1];
+    }
+};
+
+template <typename TQueue, typename TEmplace, typename TCall>
+auto run(TQueue& q, TEmplace&& emplace, TCall&& call)
+{
+    auto start = hr_clock::now();
+
+    for(std::size_t f = 0; f < frames; ++f)
+    {
+        for(std::size_t i = 0; i < callables_per_frame; ++i)
+        {
+            emplace(q, static_cast<char>(i % 7));
+        }
+
+        call(q);
+        q.clear();
+    }
+
+    return std::chrono::duration<double, std::milli>(hr_clock::now() - start)
+        .count();
+}
+
+template <std::size_t TPayload>
+bool bench()
+{
+    long vector_acc = 0;
+    long queue_acc = 0;
+
+    std::vector<std::function<void()>> v;
+    auto vector_ms = run(v,
+        [&vector_acc](auto& x, char c)
+        {
+            x.emplace_back(callback<TPayload>{vector_acc, c});
+        },
+        [](auto& x)
+        {
+            for(auto& f : x)
+            {
+                f();
+            }
+        });
+
+    dynamic_function_queue<void()> q;
+    auto queue_ms = run(q,
+        [&queue_acc](auto& x, char c)
+        {
+            x.emplace(callback<TPayload>{queue_acc, c});
+        },
+        [](auto& x)
+        {
+            x.call_all();
+        });
+
+    auto per_callable = [](double ms)
+    {
+        return ms * 1e6 / (frames * callables_per_frame);
+    };
+
+    std::cout << "payload " << TPayload << " bytes:\n"
+              << "    std::vector<std::function>: " << vector_ms << " ms ("
+              << per_callable(vector_ms) << " ns/callable)\n"
+              << "    dynamic_function_queue:     " << queue_ms << " ms ("
+              << per_callable(queue_ms) << " ns/callable)\n";
+
+    return vector_acc == queue_acc;
+}
+
+int main()
+{
+    auto ok = bench<8>() && bench<48>() && bench<200>();
+    if(!ok)
+    {
+        std::cout << "error: results differ\n";
+    }
+
+    return ok ? 0 : 1;
+}
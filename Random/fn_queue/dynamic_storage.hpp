@@ -1,31 +1,418 @@
 #pragma once
 
 #include "./dependencies.hpp"
+#include "./utils.hpp"
 #include "./aliases.hpp"
 #include "./vtable.hpp"
 
-// TODO:
 namespace impl
 {
     namespace storage
     {
+        /// @brief Storage policy for an unbounded number of callables.
+        /// @details Every callable is emplaced right after its vtable, in a
+        /// chain of chunks allocated through `TAllocator`. Chunks grow
+        /// geometrically and are never reallocated, so existing callables
+        /// are never moved. `clear` keeps the chunks for reuse.
         template <typename TSignature, typename TVTable, typename TAllocator>
         class dynamic_storage
         {
-        private:
+        public:
             using signature = TSignature;
             using vtable_type = TVTable;
+            using allocator_type = typename std::allocator_traits<
+                TAllocator>::template rebind_alloc<char>;
 
+        private:
+            using allocator_traits = std::allocator_traits<allocator_type>;
 
             static constexpr auto alignment = alignof(std::max_align_t);
 
             template <typename T>
-            constexpr auto round_up_to_alignment(T x) const noexcept
+            static constexpr auto round_up_to_alignment(T x) noexcept
             {
                 return multiple_round_up(x, alignment);
             }
 
+            /// @brief Size of the first chunk's data.
+            static constexpr std::size_t initial_chunk_capacity = 1024;
+
+            /// @brief Distance between a vtable and its callable object.
+            static constexpr auto fn_offset =
+                round_up_to_alignment(sizeof(vtable_type));
+
+            /// @brief Header of a chunk, followed by its data.
+            struct chunk
+            {
+                chunk* _next;
+                std::size_t _capacity;
+
+                // Bytes in use, only up to date for chunks before the
+                // current one.
+                std::size_t _size;
+
+                auto data() noexcept
+                {
+                    return reinterpret_cast<char*>(this) + header_size;
+                }
+            };
+
+            static constexpr auto header_size =
+                round_up_to_alignment(sizeof(chunk));
+
+            allocator_type _allocator;
+            std::vector<vtable_type*> _vtable_ptrs;
+
+            // Chunks are allocated on the first emplacement or reservation.
+            chunk* _first{nullptr};
+            chunk* _current{nullptr};
+
+            // Next emplacement position, and end of the current chunk.
+            char* _next{nullptr};
+            char* _end{nullptr};
+
+            auto fn_ptr_from_vtable(vtable_type* vt_ptr) const noexcept
+            {
+                return reinterpret_cast<char*>(vt_ptr) + fn_offset;
+            }
+
+            auto allocate_chunk(std::size_t capacity)
+            {
+                auto ptr = allocator_traits::allocate(
+                    _allocator, header_size + capacity);
+
+                // The allocator must provide the default alignment, as
+                // `std::allocator` does.
+                VRM_CORE_ASSERT_OP(
+                    reinterpret_cast<std::uintptr_t>(ptr) % alignment, ==, 0);
+
+                return new(ptr) chunk{nullptr, capacity, 0};
+            }
+
+            void deallocate_chunk(chunk* c) noexcept
+            {
+                allocator_traits::deallocate(_allocator,
+                    reinterpret_cast<char*>(c), header_size + c->_capacity);
+            }
+
+            void set_current_chunk(chunk* c) noexcept
+            {
+                _current = c;
+                _next = c->data();
+                _end = _next + c->_capacity;
+            }
+
+            auto remaining() const noexcept
+            {
+                return static_cast<std::size_t>(_end - _next);
+            }
+
+            /// @brief Makes the chunk after the current one have at least
+            /// `size` bytes, reusing the next chunk if it is large enough,
+            /// or inserting a new one.
+            auto next_chunk_with(std::size_t size)
+            {
+                if(_current == nullptr)
+                {
+                    _first = allocate_chunk(
+                        std::max(size, std::size_t{initial_chunk_capacity}));
+
+                    return _first;
+                }
+
+                auto next = _current->_next;
+                if(next != nullptr && next->_capacity >= size)
+                {
+                    return next;
+                }
+
+                // Geometric growth, and large callables get a chunk of
+                // their own size.
+                auto result = allocate_chunk(
+                    std::max(size, _current->_capacity * 2));
+
+                result->_next = next;
+                _current->_next = result;
+                return result;
+            }
+
+            /// @brief Returns the position of an entry of `size` bytes, and
+            /// moves the emplacement position past it.
+            auto allocate_entry(std::size_t size)
+            {
+                if(remaining() < size)
+                {
+                    if(_current != nullptr)
+                    {
+                        _current->_size = _next - _current->data();
+                    }
+
+                    set_current_chunk(next_chunk_with(size));
+                }
+
+                auto result = _next;
+                _next += size;
+                return result;
+            }
+
+            template <typename TF>
+            void for_fns(TF&& f)
+            {
+                for(auto vt_ptr : _vtable_ptrs)
+                {
+                    f(*vt_ptr, fn_ptr_from_vtable(vt_ptr));
+                }
+            }
+
+            void destroy_all() noexcept
+            {
+                for(auto itr = std::rbegin(_vtable_ptrs);
+                    itr != std::rend(_vtable_ptrs); ++itr)
+                {
+                    vtable::exec_fp(
+                        vtable::option::dtor, **itr, fn_ptr_from_vtable(*itr));
+                }
+            }
+
+            void deallocate_all() noexcept
+            {
+                for(auto c = _first; c != nullptr;)
+                {
+                    auto next = c->_next;
+                    deallocate_chunk(c);
+                    c = next;
+                }
+            }
+
+            /// @brief Copies every callable of `rhs`, at the same offsets in
+            /// chunks sized after the used part of `rhs`'s chunks.
+            /// @details Throws `std::logic_error`, before copying anything,
+            /// if a callable of `rhs` is not copy constructible.
+            void copy_all(const dynamic_storage& rhs)
+            {
+                VRM_CORE_STATIC_ASSERT_NM(
+                    vtable::has_option(vtable_type{}, vtable::option::copy));
+
+                for(auto vt_ptr : rhs._vtable_ptrs)
+                {
+                    if(!vtable::has_fp(vtable::option::copy, *vt_ptr))
+                    {
+                        throw std::logic_error{
+                            "dynamic_storage: cannot copy a callable that "
+                            "is not copy constructible"};
+                    }
+                }
+
+                _vtable_ptrs.reserve(rhs._vtable_ptrs.size());
+
+                auto itr = std::begin(rhs._vtable_ptrs);
+                for(auto c = rhs._first; itr != std::end(rhs._vtable_ptrs);
+                    c = c->_next)
+                {
+                    auto src_data = c->data();
+                    auto used = c == rhs._current
+                                    ? static_cast<std::size_t>(
+                                          rhs._next - src_data)
+                                    : c->_size;
+
+                    if(used == 0)
+                    {
+                        continue;
+                    }
+
+                    set_current_chunk(next_chunk_with(used));
+                    _current->_size = used;
+                    _next += used;
+
+                    for(; itr != std::end(rhs._vtable_ptrs) &&
+                          reinterpret_cast<char*>(*itr) < src_data + used;
+                        ++itr)
+                    {
+                        auto src_vt = reinterpret_cast<char*>(*itr);
+                        auto dst_vt = _current->data() + (src_vt - src_data);
+
+                        std::memcpy(dst_vt, src_vt, sizeof(vtable_type));
+                        vtable::exec_fp(vtable::option::copy, **itr,
+                            src_vt + fn_offset, dst_vt + fn_offset);
+
+                        _vtable_ptrs.emplace_back(
+                            reinterpret_cast<vtable_type*>(dst_vt));
+                    }
+                }
+            }
+
+            void steal(dynamic_storage& rhs) noexcept
+            {
+                _vtable_ptrs = std::move(rhs._vtable_ptrs);
+                _first = rhs._first;
+                _current = rhs._current;
+                _next = rhs._next;
+                _end = rhs._end;
+
+                rhs._vtable_ptrs.clear();
+                rhs._first = rhs._current = nullptr;
+                rhs._next = rhs._end = nullptr;
+            }
+
         public:
+            /// @brief Returns the storage taken by a callable of type `TF`
+            /// and its vtable.
+            template <typename TF>
+            static constexpr auto entry_size() noexcept
+            {
+                return fn_offset + round_up_to_alignment(sizeof(TF));
+            }
+
+            dynamic_storage() = default;
+
+            explicit dynamic_storage(const allocator_type& allocator)
+                : _allocator{allocator}
+            {
+            }
+
+            ~dynamic_storage()
+            {
+                destroy_all();
+                deallocate_all();
+            }
+
+            dynamic_storage(const dynamic_storage& rhs)
+                : _allocator{allocator_traits::
+                          select_on_container_copy_construction(
+                              rhs._allocator)}
+            {
+                // The destructor does not run if copying throws.
+                try
+                {
+                    copy_all(rhs);
+                }
+                catch(...)
+                {
+                    destroy_all();
+                    deallocate_all();
+                    throw;
+                }
+            }
+
+            dynamic_storage& operator=(const dynamic_storage& rhs)
+            {
+                if(this != &rhs)
+                {
+                    *this = dynamic_storage{rhs};
+                }
+
+                return *this;
+            }
+
+            // Moving only transfers the chunks: callables are not moved.
+            dynamic_storage(dynamic_storage&& rhs) noexcept
+                : _allocator{std::move(rhs._allocator)}
+            {
+                steal(rhs);
+            }
+
+            dynamic_storage& operator=(dynamic_storage&& rhs) noexcept
+            {
+                if(this != &rhs)
+                {
+                    destroy_all();
+                    deallocate_all();
+
+                    _allocator = std::move(rhs._allocator);
+                    steal(rhs);
+                }
+
+                return *this;
+            }
+
+            template <typename TF>
+            void emplace(TF&& f)
+            {
+                using fn_type = std::decay_t<TF>;
+
+                VRM_CORE_STATIC_ASSERT_NM(alignof(fn_type) <= alignment);
+
+                // Emplace the vtable and the callable object right after
+                // it.
+                auto ptr = allocate_entry(entry_size<fn_type>());
+                auto& vt = *(new(ptr) vtable_type{});
+                new(ptr + fn_offset) fn_type(FWD(f));
+
+                vtable::template setup<fn_type, signature>(vt);
+                _vtable_ptrs.emplace_back(&vt);
+            }
+
+            template <typename... Ts>
+            void call_all(Ts&&... xs)
+            {
+                for_fns([&xs...](auto& vt, auto fn_ptr)
+                    {
+                        vtable::exec_fp(
+                            vtable::option::call, vt, fn_ptr, xs...);
+                    });
+            }
+
+            /// @brief Destroys every callable, keeping the chunks.
+            void clear() noexcept
+            {
+                destroy_all();
+                _vtable_ptrs.clear();
+
+                if(_first != nullptr)
+                {
+                    set_current_chunk(_first);
+                }
+            }
+
+            /// @brief Makes room for callables taking up to `bytes` bytes
+            /// along with their vtables, so that emplacing them does not
+            /// allocate.
+            /// @details Each callable of type `TF` takes
+            /// `entry_size<TF>()` bytes.
+            void reserve(std::size_t bytes)
+            {
+                // Upper bound of the callable count, from the smallest entry.
+                _vtable_ptrs.reserve(
+                    _vtable_ptrs.size() + bytes / entry_size<char>());
+
+                if(remaining() >= bytes)
+                {
+                    return;
+                }
+
+                auto c = next_chunk_with(bytes);
+                if(_current == nullptr)
+                {
+                    set_current_chunk(c);
+                }
+            }
+
+            auto size() const noexcept
+            {
+                return _vtable_ptrs.size();
+            }
+
+            auto empty() const noexcept
+            {
+                return _vtable_ptrs.empty();
+            }
+
+            /// @brief Bytes allocated for callables and vtables.
+            auto capacity() const noexcept
+            {
+                std::size_t result = 0;
+                for(auto c = _first; c != nullptr; c = c->_next)
+                {
+                    result += c->_capacity;
+                }
+
+                return result;
+            }
+
+            auto get_allocator() const noexcept
+            {
+                return _allocator;
+            }
         };
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,336 @@
+#include "./test_utils.hpp"
+#include "../base_fn_queue.cpp"
+
+static int allocations;
+static int deallocations;
+
+template <typename T>
+struct counting_allocator
+{
+    using value_type = T;
+
+    counting_allocator() = default;
+
+    template <typename TOther>
+    counting_allocator(const counting_allocator<TOther>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        ++allocations;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept
+    {
+        ++deallocations;
+        std::allocator<T>{}.deallocate(ptr, n);
+    }
+
+    template <typename TOther>
+    bool operator==(const counting_allocator<TOther>&) const noexcept
+    {
+        return true;
+    }
+
+    template <typename TOther>
+    bool operator!=(const counting_allocator<TOther>&) const noexcept
+    {
+        return false;
+    }
+};
+
+using counted_queue =
+    dynamic_function_queue<void(int), counting_allocator<char>>;
+
+using counted_storage = impl::storage::dynamic_storage<void(int),
+    complete_vtable_type<void(int)>, counting_allocator<char>>;
+
+static int ctors;
+static int copy_ctors;
+static int move_ctors;
+static int dtors;
+
+void counters_reset()
+{
+    ctors = dtors = copy_ctors = move_ctors = 0;
+}
+
+#define counters_test(xctors, xcopy_ctors, xmove_ctors, xdtors) \
+    {                                                           \
+        TEST_ASSERT_OP(ctors, ==, xctors);                      \
+        TEST_ASSERT_OP(copy_ctors, ==, xcopy_ctors);            \
+        TEST_ASSERT_OP(move_ctors, ==, xmove_ctors);            \
+        TEST_ASSERT_OP(dtors, ==, xdtors);                      \
+    }
+
+// Adds its payload to `acc`, and records its address when called.
+template <std::size_t TSize>
+struct counted_fn
+{
+    int& _acc;
+    std::vector<const void*>* _addresses;
+    std::array<char, TSize> _payload;
+
+    counted_fn(int& acc, std::vector<const void*>* addresses)
+        : _acc(acc), _addresses{addresses}
+    {
+        _payload.fill(1);
+        ++ctors;
+    }
+
+    counted_fn(const counted_fn& rhs)
+        : _acc(rhs._acc), _addresses{rhs._addresses}, _payload(rhs._payload)
+    {
+        ++copy_ctors;
+    }
+
+    counted_fn(counted_fn&& rhs)
+        : _acc(rhs._acc), _addresses{rhs._addresses}, _payload(rhs._payload)
+    {
+        ++move_ctors;
+    }
+
+    ~counted_fn()
+    {
+        ++dtors;
+    }
+
+    void operator()(int x)
+    {
+        _acc += _payload[TSize - 1] * x;
+        if(_addresses != nullptr)
+        {
+            _addresses->emplace_back(this);
+        }
+    }
+};
+
+void growth_tests()
+{
+    allocations = deallocations = 0;
+    counters_reset();
+
+    {
+        int acc = 0;
+        std::vector<const void*> addresses;
+        counted_queue q;
+
+        // Many chunks, with callables of different sizes.
+        for(int i = 0; i < 300; ++i)
+        {
+            q.emplace(counted_fn<8>{acc, &addresses});
+            q.emplace(counted_fn<100>{acc, &addresses});
+        }
+
+        counters_test(600, 0, 600, 600);
+        TEST_ASSERT_OP(q.size(), ==, 600);
+        TEST_ASSERT_OP(allocations, >, 3);
+
+        q.call_all(2);
+        TEST_ASSERT_OP(acc, ==, 1200);
+
+        // Growing the storage does not move existing callables.
+        for(int i = 0; i < 1000; ++i)
+        {
+            q.emplace(counted_fn<40>{acc, nullptr});
+        }
+
+        counters_test(1600, 0, 1600, 1600);
+
+        q.call_all(1);
+        TEST_ASSERT_OP(acc, ==, 2800);
+
+        TEST_ASSERT_OP(addresses.size(), ==, 1200);
+        TEST_ASSERT(std::equal(std::begin(addresses),
+            std::begin(addresses) + 600, std::begin(addresses) + 600));
+    }
+
+    counters_test(1600, 0, 1600, 3200);
+    TEST_ASSERT_OP(allocations, ==, deallocations);
+}
+
+void order_tests()
+{
+    std::vector<int> order;
+    dynamic_function_queue<void()> q;
+
+    // Larger than a chunk.
+    std::array<char, 5000> big{};
+
+    for(int i = 0; i < 100; ++i)
+    {
+        q.emplace([&order, i]
+            {
+                order.emplace_back(i);
+            });
+
+        if(i % 10 == 0)
+        {
+            q.emplace([&order, i, big]
+                {
+                    order.emplace_back(-i - big[0]);
+                });
+        }
+    }
+
+    q.call_all();
+    TEST_ASSERT_OP(order.size(), ==, 110);
+    TEST_ASSERT_OP(order[0], ==, 0);
+    TEST_ASSERT_OP(order[1], ==, 0);
+    TEST_ASSERT_OP(order[2], ==, 1);
+    TEST_ASSERT_OP(order[109], ==, 99);
+}
+
+void reuse_tests()
+{
+    allocations = deallocations = 0;
+    counters_reset();
+
+    {
+        int acc = 0;
+        counted_queue q;
+
+        for(int i = 0; i < 500; ++i)
+        {
+            q.emplace(counted_fn<24>{acc, nullptr});
+        }
+
+        auto allocations_after_fill = allocations;
+
+        // Clearing destroys the callables and keeps the memory.
+        q.clear();
+        TEST_ASSERT(q.empty());
+        counters_test(500, 0, 500, 1000);
+
+        for(int i = 0; i < 500; ++i)
+        {
+            q.emplace(counted_fn<24>{acc, nullptr});
+        }
+
+        q.call_all(1);
+        TEST_ASSERT_OP(acc, ==, 500);
+        TEST_ASSERT_OP(allocations, ==, allocations_after_fill);
+        TEST_ASSERT_OP(deallocations, ==, 0);
+    }
+
+    TEST_ASSERT_OP(allocations, ==, deallocations);
+}
+
+void reserve_tests()
+{
+    allocations = deallocations = 0;
+
+    {
+        int acc = 0;
+        counted_queue q;
+
+        constexpr auto count = 2000;
+        q.reserve(count * counted_storage::entry_size<counted_fn<24>>());
+
+        auto allocations_after_reserve = allocations;
+        for(int i = 0; i < count; ++i)
+        {
+            q.emplace(counted_fn<24>{acc, nullptr});
+        }
+
+        TEST_ASSERT_OP(allocations, ==, allocations_after_reserve);
+    }
+
+    TEST_ASSERT_OP(allocations, ==, deallocations);
+}
+
+void copy_move_tests()
+{
+    counters_reset();
+
+    {
+        int acc = 0;
+        counted_storage s;
+
+        for(int i = 0; i < 200; ++i)
+        {
+            s.emplace(counted_fn<16>{acc, nullptr});
+            s.emplace(counted_fn<200>{acc, nullptr});
+        }
+
+        counters_test(400, 0, 400, 400);
+
+        auto s2 = s;
+        counters_test(400, 400, 400, 400);
+
+        s2.call_all(1);
+        TEST_ASSERT_OP(acc, ==, 400);
+
+        // Moving transfers the chunks without touching the callables.
+        auto s3 = std::move(s);
+        counters_test(400, 400, 400, 400);
+        TEST_ASSERT(s.empty());
+        TEST_ASSERT_OP(s3.size(), ==, 400);
+
+        s3.call_all(1);
+        TEST_ASSERT_OP(acc, ==, 800);
+
+        s = s3;
+        counters_test(400, 800, 400, 400);
+
+        s2 = std::move(s3);
+        counters_test(400, 800, 400, 800);
+
+        s.call_all(1);
+        s2.call_all(1);
+        TEST_ASSERT_OP(acc, ==, 1600);
+    }
+
+    counters_test(400, 800, 400, 1600);
+}
+
+void move_only_tests()
+{
+    allocations = deallocations = 0;
+
+    {
+        int acc = 0;
+        counted_queue q;
+        q.emplace([&acc](int x)
+            {
+                acc += x;
+            });
+        q.emplace([&acc, p = std::make_unique<int>(4)](int x)
+            {
+                acc += x * *p;
+            });
+
+        auto threw = false;
+        try
+        {
+            auto q2 = q;
+        }
+        catch(const std::logic_error&)
+        {
+            threw = true;
+        }
+
+        TEST_ASSERT(threw);
+
+        // The source is untouched, and moving does not copy.
+        auto q3 = std::move(q);
+        q3.call_all(1);
+        TEST_ASSERT_OP(acc, ==, 5);
+    }
+
+    TEST_ASSERT_OP(allocations, ==, deallocations);
+}
+
+TEST_MAIN()
+{
+    growth_tests();
+    order_tests();
+    reuse_tests();
+    reserve_tests();
+    copy_move_tests();
+    move_only_tests();
+
+    return 0;
+}
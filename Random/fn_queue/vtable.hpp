@@ -148,6 +148,15 @@ namespace vtable
         (*fp)(FWD(xs)...);
     }
 
+    /// @brief Returns whether `setup` stored the function pointer of `o`.
+    /// @details The copy and move pointers are left null for callables
+    /// that are not copy or move constructible.
+    template <typename TOption, typename TVTable>
+    bool has_fp(TOption o, TVTable& vt) noexcept
+    {
+        return bh::at_key(vt, o) != nullptr;
+    }
+
     template <typename TVTable, typename TOption>
     constexpr auto has_option(const TVTable& vt, TOption o) noexcept
     {
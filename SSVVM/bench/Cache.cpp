@@ -0,0 +1,94 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Loads a set of scripts through `ProgramCache`, first with an empty cache
+// (lex, preprocess, assemble, verify and write) and then with a warm one
+// (map the cached files), checking that both give the same results.
+
+#include <chrono>
+#include <sys/stat.h>
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+#include "../src/SSVVM/Samples.hpp"
+
+static constexpr int scriptCount{200};
+static const std::string cacheDir{"SSVVMBenchCache"};
+
+using VM = ssvvm::Impl::VMImpl<6, false, ssvvm::VMDispatch::Threaded,
+    ssvvm::VMStorage::Untagged>;
+using Clock = std::chrono::high_resolution_clock;
+
+inline ssvvm::Program compile(ssvvm::SourceVeeAsm& mSource)
+{
+    auto result(ssvvm::getAssembledProgram<false>(
+        ssvvm::preprocessSource<false>(mSource)));
+    ssvvm::verifyProgram<false>(result);
+    return result;
+}
+
+inline int run(ssvvm::Program mProgram)
+{
+    VM vm;
+    vm.setProgram(std::move(mProgram));
+    vm.run();
+    return vm.stack.getTop().get<int>();
+}
+
+// Loads every script, returning the time taken and the programs
+inline Clock::duration loadAll(ssvvm::ProgramCache& mCache,
+    const std::vector<ssvvm::SourceVeeAsm>& mSources,
+    std::vector<ssvvm::Program>& mPrograms)
+{
+    mPrograms.clear();
+
+    auto start(Clock::now());
+    for(const auto& s : mSources)
+        mPrograms.emplace_back(mCache.get<false>(s, &compile));
+
+    return Clock::now() - start;
+}
+
+inline int toUs(Clock::duration mDuration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(mDuration)
+        .count();
+}
+
+int main()
+{
+    mkdir(cacheDir.c_str(), 0755);
+
+    std::vector<ssvvm::SourceVeeAsm> sources;
+    for(int i{0}; i < scriptCount; ++i)
+    {
+        // Distinct sources, so that every script gets its own cache entry
+        const auto& source(samples::getFibSource(i % 20) + "// Script " +
+                           ssvu::toStr(i) + "\n");
+        sources.emplace_back(ssvvm::SourceVeeAsm::fromStrRaw(source));
+    }
+
+    ssvvm::ProgramCache cache{cacheDir};
+    for(const auto& s : sources)
+        std::remove(cache.getPath(cache.getSourceHash(s)).c_str());
+
+    std::vector<ssvvm::Program> cold, warm;
+    const auto& coldTime(loadAll(cache, sources, cold));
+    const auto& warmTime(loadAll(cache, sources, warm));
+
+    ssvu::lo("Cache") << scriptCount << " scripts | cold: " << toUs(coldTime)
+                      << " us (" << cache.getMisses() << " misses), warm: "
+                      << toUs(warmTime) << " us (" << cache.getHits()
+                      << " hits)\n";
+
+    for(auto i(0u); i < sources.size(); ++i)
+        if(!warm[i].isVerified() || run(cold[i]) != run(warm[i]))
+        {
+            ssvu::lo("Cache") << "ERROR: cached program " << i
+                              << " differs\n";
+            return 1;
+        }
+
+    ssvu::lo().flush();
+    return 0;
+}
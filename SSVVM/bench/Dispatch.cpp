@@ -0,0 +1,88 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Compares `VMDispatch::FnPtr` and `VMDispatch::Threaded` on the recursive
+// fibonacci sample program, with tagged and (verified) untagged values,
+// before and after the peephole optimizer.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+#include "../src/SSVVM/Samples.hpp"
+
+static constexpr int fibN{27};
+static constexpr int runs{5};
+
+template <ssvvm::VMDispatch TDispatch,
+    ssvvm::VMStorage TStorage = ssvvm::VMStorage::Tagged>
+inline void bench(const std::string& mTitle, const ssvvm::Program& mProgram)
+{
+    using VM = ssvvm::Impl::VMImpl<6, false, TDispatch, TStorage>;
+    using Clock = std::chrono::high_resolution_clock;
+
+    Clock::duration best{Clock::duration::max()};
+    int result{0};
+
+    for(int i{0}; i < runs; ++i)
+    {
+        VM vm;
+        vm.setProgram(mProgram);
+
+        auto start(Clock::now());
+        vm.run();
+        best = std::min(best, Clock::now() - start);
+
+        result = vm.stack.getTop().template get<int>();
+    }
+
+    ssvu::lo(mTitle)
+        << "fib(" << fibN << ") = " << result << " | best of " << runs << ": "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(best).count()
+        << " ms\n";
+}
+
+inline void printProgramInfo(
+    const std::string& mTitle, const ssvvm::Program& mProgram)
+{
+    ssvu::lo(mTitle) << mProgram.getInstructionCount() << " instructions, "
+                     << mProgram.getByteSize() << " bytes packed ("
+                     << mProgram.getInstructionCount() *
+                            sizeof(ssvvm::Instruction)
+                     << " bytes unpacked)\n";
+}
+
+inline bool benchAll(const std::string& mTitle, ssvvm::Program& mProgram)
+{
+    printProgramInfo(mTitle, mProgram);
+
+    bench<ssvvm::VMDispatch::FnPtr>(mTitle + " FnPtr", mProgram);
+    bench<ssvvm::VMDispatch::Threaded>(mTitle + " Threaded", mProgram);
+
+    if(!ssvvm::verifyProgram<false>(mProgram))
+    {
+        ssvu::lo(mTitle) << "verification failed\n";
+        return false;
+    }
+
+    bench<ssvvm::VMDispatch::FnPtr, ssvvm::VMStorage::Untagged>(
+        mTitle + " FnPtr untagged", mProgram);
+    bench<ssvvm::VMDispatch::Threaded, ssvvm::VMStorage::Untagged>(
+        mTitle + " Threaded untagged", mProgram);
+
+    return true;
+}
+
+int main()
+{
+    auto src(ssvvm::SourceVeeAsm::fromStrRaw(samples::getFibSource(fibN)));
+    ssvvm::preprocessSourceRaw<false>(src);
+    auto program(ssvvm::getAssembledProgram<false>(src));
+    auto optimized(ssvvm::getOptimizedProgram<false>(program));
+
+    if(!benchAll("Program", program) || !benchAll("Optimized", optimized))
+        return 1;
+
+    ssvu::lo().flush();
+    return 0;
+}
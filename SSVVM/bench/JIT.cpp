@@ -0,0 +1,88 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Runs the sample programs both interpreted and with the JIT enabled,
+// checking that the results are identical, and compares their run times.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+#include "../src/SSVVM/Samples.hpp"
+
+static constexpr int fibN{27};
+static constexpr int runs{5};
+static constexpr std::size_t jitThreshold{16};
+
+using VM = ssvvm::Impl::VMImpl<6, false, ssvvm::VMDispatch::Threaded,
+    ssvvm::VMStorage::Untagged>;
+using Clock = std::chrono::high_resolution_clock;
+
+struct Result
+{
+    int value;
+    Clock::duration time;
+};
+
+inline Result run(const ssvvm::Program& mProgram, std::size_t mThreshold)
+{
+    Result result{0, Clock::duration::max()};
+
+    for(int i{0}; i < runs; ++i)
+    {
+        VM vm;
+        vm.setProgram(mProgram);
+        vm.enableJIT(mThreshold);
+
+        auto start(Clock::now());
+        vm.run();
+        result.time = std::min(result.time, Clock::now() - start);
+        result.value = vm.stack.getTop().template get<int>();
+    }
+
+    return result;
+}
+
+inline ssvvm::Program getProgram(int mN, bool mOptimize)
+{
+    auto src(ssvvm::SourceVeeAsm::fromStrRaw(samples::getFibSource(mN)));
+    ssvvm::preprocessSourceRaw<false>(src);
+
+    auto program(ssvvm::getAssembledProgram<false>(src));
+    if(mOptimize) program = ssvvm::getOptimizedProgram<false>(program);
+
+    ssvvm::verifyProgram<false>(program);
+    return program;
+}
+
+inline int toMs(Clock::duration mDuration)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(mDuration)
+        .count();
+}
+
+int main()
+{
+    for(bool optimize : {false, true})
+        for(int n : {0, 1, 2, 10, 20, fibN})
+        {
+            const auto& program(getProgram(n, optimize));
+            const auto& interpreted(run(program, 0));
+            const auto& compiled(run(program, jitThreshold));
+
+            ssvu::lo(optimize ? "Optimized" : "Program")
+                << "fib(" << n << ") = " << interpreted.value << " | "
+                << "interpreted: " << toMs(interpreted.time) << " ms, "
+                << "JIT: " << toMs(compiled.time) << " ms\n";
+
+            if(interpreted.value != compiled.value)
+            {
+                ssvu::lo("JIT") << "ERROR: result mismatch ("
+                                << compiled.value << ")\n";
+                return 1;
+            }
+        }
+
+    ssvu::lo().flush();
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Tokenizes a large assembly source with the table-driven DFA and with the
+// reference FSM walk, checking that both produce the same tokens.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+#include "../src/SSVVM/Samples.hpp"
+
+static constexpr int copies{400};
+static constexpr int runs{5};
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Returns the best throughput in MB/s
+template <typename TFn>
+inline double bench(const std::string& mSource, const TFn& mTokenize)
+{
+    Clock::duration best{Clock::duration::max()};
+
+    for(int i{0}; i < runs; ++i)
+    {
+        auto start(Clock::now());
+        mTokenize();
+        best = std::min(best, Clock::now() - start);
+    }
+
+    const auto& seconds(std::chrono::duration<double>(best).count());
+    return mSource.size() / seconds / (1024.0 * 1024.0);
+}
+
+int main()
+{
+    std::string source;
+    for(int i{0}; i < copies; ++i) source += samples::getFibSource(i % 30);
+
+    auto& la(ssvvm::getASMLA());
+    la.setSource(source);
+
+    const auto& dfa(la.getDFA());
+    ssvu::lo("DFA") << dfa.getStateCount() << " states, "
+                    << dfa.getClassCount() << " byte classes\n";
+
+    const auto& fsmSpeed(bench(source, [&la]
+        {
+            la.tokenizeWithFSMs();
+        }));
+    const auto fsmTokens(la.getTokens());
+
+    const auto& dfaSpeed(bench(source, [&la]
+        {
+            la.tokenize();
+        }));
+    const auto& dfaTokens(la.getTokens());
+
+    ssvu::lo("Lexer") << source.size() / 1024 << " KB, " << dfaTokens.size()
+                      << " tokens | FSMs: " << fsmSpeed
+                      << " MB/s, DFA: " << dfaSpeed << " MB/s\n";
+
+    bool ok{fsmTokens.size() == dfaTokens.size()};
+    for(auto i(0u); ok && i < dfaTokens.size(); ++i)
+        ok = fsmTokens[i].type == dfaTokens[i].type &&
+             fsmTokens[i].getContents() == dfaTokens[i].getContents();
+
+    if(!ok) ssvu::lo("Lexer") << "ERROR: token streams differ\n";
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
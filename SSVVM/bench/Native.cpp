@@ -0,0 +1,149 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Runs a loop calling a bound C function through `callNative` on every
+// iteration, interpreted (tagged and untagged) and JIT-compiled, and checks
+// the results against the same loop written in C++.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+
+static constexpr int iterations{10000000};
+static constexpr int runs{5};
+
+using Clock = std::chrono::high_resolution_clock;
+
+int mix(int mAcc, int mCounter) { return (mAcc * 31 + mCounter) & 0xFFFFF; }
+float half(float mValue) { return mValue * 0.5f; }
+
+static int sunk{0};
+void sink(int mValue) { sunk += mValue; }
+
+// Same order as `bindAll`
+static const std::vector<ssvvm::BoundFunction> natives{&mix, &half, &sink};
+
+template <typename TVM>
+inline void bindAll(TVM& mVM)
+{
+    mVM.bindNative(&mix);
+    mVM.bindNative(&half);
+    mVM.bindNative(&sink);
+}
+
+inline std::string getLoopSource()
+{
+    return R"(
+    //!ssvasm
+
+    $require_registers(4);
+
+    $define(RCounter,	0);
+    $define(RAcc,		1);
+    $define(RCmp,		2);
+    $define(RFloat,		3);
+
+    $label(FN_MAIN);
+        loadIntCVToR(RCounter, )" +
+           ssvu::toStr(iterations) + R"();
+        loadIntCVToR(RAcc, 0);
+        callPI(FN_LOOP);
+
+        // sink(8), then push half(4.f) and the accumulator
+        pushIntCVToS(8);
+        callNative(2);
+        pushFloatCVToS(4.f);
+        callNative(1);
+        popSVToR(RFloat);
+        pushRVToS(RAcc);
+        halt();
+
+    // RAcc = mix(RAcc, RCounter) for RCounter in (iterations, 0]
+    $label(FN_LOOP);
+    $label(LOOP);
+        pushRVToS(RAcc);
+        pushRVToS(RCounter);
+        callNative(0);
+        popSVToR(RAcc);
+        decrementIntRV(RCounter);
+        compareIntRVIntCVToR(RCmp, RCounter, 0);
+        goToPIIfCompareRVGreater(LOOP, RCmp);
+        returnPI();
+    )";
+}
+
+inline int getExpected()
+{
+    int acc{0};
+    for(int i{iterations}; i > 0; --i) acc = mix(acc, i);
+    return acc;
+}
+
+template <ssvvm::VMStorage TStorage>
+inline bool bench(const std::string& mTitle, const ssvvm::Program& mProgram,
+    std::size_t mJITThreshold = 0)
+{
+    using VM = ssvvm::Impl::VMImpl<6, false, ssvvm::VMDispatch::Threaded,
+        TStorage>;
+
+    Clock::duration best{Clock::duration::max()};
+    bool ok{true};
+
+    for(int i{0}; i < runs; ++i)
+    {
+        VM vm;
+        bindAll(vm);
+        vm.setProgram(mProgram);
+        vm.enableJIT(mJITThreshold);
+        sunk = 0;
+
+        auto start(Clock::now());
+        vm.run();
+        best = std::min(best, Clock::now() - start);
+
+        ok = ok && vm.stack.getTop().template get<int>() == getExpected() &&
+             vm.registry.getValue(3).template get<float>() == 2.f &&
+             sunk == 8;
+    }
+
+    ssvu::lo(mTitle)
+        << (ok ? "OK" : "ERROR: wrong result") << " | best of " << runs
+        << ": "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(best).count()
+        << " ms\n";
+
+    return ok;
+}
+
+int main()
+{
+    auto src(ssvvm::SourceVeeAsm::fromStrRaw(getLoopSource()));
+    ssvvm::preprocessSourceRaw<false>(src);
+    auto program(ssvvm::getAssembledProgram<false>(src));
+
+    auto start(Clock::now());
+    const auto& expected(getExpected());
+    ssvu::lo("C++") << expected << " | "
+                    << std::chrono::duration_cast<std::chrono::milliseconds>(
+                           Clock::now() - start)
+                           .count()
+                    << " ms\n";
+
+    bool ok{bench<ssvvm::VMStorage::Tagged>("Tagged", program)};
+
+    if(!ssvvm::verifyProgram<false>(program, {}, natives))
+    {
+        ssvu::lo("Native") << "verification failed\n";
+        return 1;
+    }
+
+    ok = bench<ssvvm::VMStorage::Untagged>("Untagged", program) && ok;
+    ok = bench<ssvvm::VMStorage::Untagged>("JIT", program, 1) && ok;
+
+    // Calls from C++, through `Params`
+    ok = natives[0].call(ssvvm::Params{2, 3}).get<int>() == mix(2, 3) && ok;
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
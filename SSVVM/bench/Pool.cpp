@@ -0,0 +1,97 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Runs a batch of small fibonacci scripts with `VMPool`, from one thread up
+// to one thread per core, checking the outputs against the single-threaded
+// run. The maximum thread count can be passed as the first argument.
+
+#include <chrono>
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+#include "../src/SSVVM/Samples.hpp"
+
+static constexpr std::size_t batchSize{20000};
+static constexpr int runs{5};
+
+using VM = ssvvm::Impl::VMImpl<6, false, ssvvm::VMDispatch::Threaded,
+    ssvvm::VMStorage::Untagged>;
+using Pool = ssvvm::VMPool<VM>;
+using Clock = std::chrono::high_resolution_clock;
+
+inline ssvvm::Program getProgram()
+{
+    auto src(ssvvm::SourceVeeAsm::fromStrRaw(samples::getFibInputSource()));
+    ssvvm::preprocessSourceRaw<false>(src);
+
+    auto program(ssvvm::getOptimizedProgram<false>(
+        ssvvm::getAssembledProgram<false>(src)));
+
+    // R0 is set from the inputs
+    ssvvm::verifyProgram<false>(program, {ssvvm::VMVal::Int});
+    return program;
+}
+
+// Scripts of uneven length, so that workers run out of chunks at different
+// times and have to steal
+inline std::vector<Pool::Input> getInputs()
+{
+    std::vector<Pool::Input> result;
+    for(auto i(0u); i < batchSize; ++i)
+        result.push_back({ssvvm::RawValue::create<int>(
+            i % 1000 < 50 ? 18 + i % 3 : 5 + i % 8)});
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    const auto& program(std::make_shared<const ssvvm::Program>(getProgram()));
+    const auto& inputs(getInputs());
+    auto maxThreads(std::max(std::thread::hardware_concurrency(), 1u));
+    if(argc > 1) maxThreads = std::max(std::atoi(argv[1]), 1);
+
+    std::vector<Pool::Output> expected;
+    Clock::duration singleTime{};
+
+    // 1, 2, 4, ... threads, ending with `maxThreads`
+    for(auto threads(1u);; threads = std::min(threads * 2, maxThreads))
+    {
+        Pool pool{program, threads};
+        auto best(Clock::duration::max());
+
+        for(int i{0}; i < runs; ++i)
+        {
+            auto start(Clock::now());
+            const auto& outputs(pool.runAll(inputs));
+            best = std::min(best, Clock::now() - start);
+
+            if(expected.empty()) expected = outputs;
+
+            for(auto k(0u); k < outputs.size(); ++k)
+                if(outputs[k].get<int>() != expected[k].get<int>())
+                {
+                    ssvu::lo("Pool") << "ERROR: output mismatch at " << k
+                                     << "\n";
+                    return 1;
+                }
+        }
+
+        if(threads == 1) singleTime = best;
+
+        const auto& us(
+            std::chrono::duration_cast<std::chrono::microseconds>(best)
+                .count());
+
+        ssvu::lo("Pool") << threads << " thread(s): " << us << " us, "
+                         << (batchSize * 1000000.0 / us) << " scripts/s, "
+                         << "speedup x" << (double(singleTime.count()) /
+                                               best.count())
+                         << "\n";
+
+        if(threads == maxThreads) break;
+    }
+
+    ssvu::lo().flush();
+    return 0;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Runs the fibonacci sample with the profiling dispatch, printing the
+// hot-spot report and writing the folded call stacks to `fib.folded`.
+
+#include <fstream>
+#include <iostream>
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+#include "../src/SSVVM/Samples.hpp"
+
+static constexpr int fibN{25};
+
+using VM = ssvvm::Impl::VMImpl<6, false, ssvvm::VMDispatch::Profiled>;
+
+inline void profile(const std::string& mTitle, const ssvvm::Program& mProgram)
+{
+    VM vm;
+    vm.setProgram(mProgram);
+    vm.run();
+
+    std::cout << "\n=== " << mTitle << ": fib(" << fibN << ") = "
+              << vm.stack.getTop().get<int>() << " ===\n\n";
+    vm.profiler.printReport(std::cout, mProgram);
+
+    std::ofstream folded{mTitle + ".folded"};
+    vm.profiler.printFoldedStacks(folded);
+}
+
+int main()
+{
+    auto src(ssvvm::SourceVeeAsm::fromStrRaw(samples::getFibSource(fibN)));
+    ssvvm::preprocessSourceRaw<false>(src);
+
+    const auto& program(ssvvm::getAssembledProgram<false>(src));
+    profile("fib", program);
+    profile("fib-optimized", ssvvm::getOptimizedProgram<false>(program));
+
+    return 0;
+}
@@ -7,6 +7,7 @@
 
 #include "SSVVM/Other/Graph.hpp"
 #include "SSVVM/Other/FSM.hpp"
+#include "SSVVM/Other/LexicalDFA.hpp"
 #include "SSVVM/Other/LexicalFSM.hpp"
 #include "SSVVM/Other/LexicalAnalyzer.hpp"
 
@@ -70,7 +71,7 @@ namespace ssvvm
             la.createMatchFSM(VMToken::Comment)
                 .once("//", FSMNT::Terminal)
                 .matchAnythingUntilOnce(
-                    FSMNT::NonTerminal, "\n", FSMNT::Terminal);
+                    FSMNT::Terminal, "\n", FSMNT::Terminal);
             la.createMatchFSM(VMToken::WhiteSpace)
                 .matchRepeat(&ssvu::isSpace, FSMNT::Terminal);
 
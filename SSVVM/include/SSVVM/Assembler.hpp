@@ -13,23 +13,44 @@ namespace ssvvm
         {
             std::size_t requiredArgs{0u};
             OpCode opCode;
-            VMVal argTypes[3];
+            OperandLayout layout;
 
             inline InstructionTemplate() = default;
-            inline InstructionTemplate(OpCode mOpCode, VMVal mT0 = VMVal::Void,
-                VMVal mT1 = VMVal::Void, VMVal mT2 = VMVal::Void)
-                : opCode{mOpCode}
+            inline InstructionTemplate(OpCode mOpCode)
+                : opCode{mOpCode}, layout(getOperandLayout(mOpCode))
             {
-                argTypes[0] = mT0;
-                if(argTypes[0] != VMVal::Void) ++requiredArgs;
-                argTypes[1] = mT1;
-                if(argTypes[1] != VMVal::Void) ++requiredArgs;
-                argTypes[2] = mT2;
-                if(argTypes[2] != VMVal::Void) ++requiredArgs;
+                requiredArgs = layout.getCount();
             }
 
-            inline void addToProgram(
-                Program& mProgram, std::vector<Value>& mArgs) const
+            inline bool acceptsArg(std::size_t mIdx, const Value& mArg) const
+                noexcept
+            {
+                const auto& expected(layout.operands[mIdx] == Operand::Float
+                                         ? VMVal::Float
+                                         : VMVal::Int);
+                return mArg.getType() == expected;
+            }
+
+            // Registers are stored in a `RegByte`, and targets are
+            // instruction indices, up to the end of the program. Only
+            // called on arguments of the right type.
+            inline bool acceptsArgValue(std::size_t mIdx, const Value& mArg,
+                std::size_t mInstructionCount) const noexcept
+            {
+                switch(layout.operands[mIdx])
+                {
+                    case Operand::Reg:
+                        return mArg.get<int>() >= 0 && mArg.get<int>() < 256;
+                    case Operand::Target:
+                        return mArg.get<int>() >= 0 &&
+                               std::size_t(mArg.get<int>()) <=
+                                   mInstructionCount;
+                    default: return true;
+                }
+            }
+
+            inline void addToInstructions(std::vector<Instruction>& mResult,
+                std::vector<Value>& mArgs) const
             {
                 Params params;
                 for(auto i(0u); i < requiredArgs; ++i) params[i] = mArgs[i];
@@ -38,21 +59,13 @@ namespace ssvvm
                 instruction.opCode = opCode;
                 instruction.params = params;
 
-                mProgram += instruction;
+                mResult.emplace_back(instruction);
             }
         };
 
         using InstructionTemplateMap =
             std::unordered_map<std::string, InstructionTemplate>;
 
-        inline void addInstructionTemplate(InstructionTemplateMap& mMap,
-            OpCode mOpCode, VMVal mArgType0 = VMVal::Void,
-            VMVal mArgType1 = VMVal::Void, VMVal mArgType2 = VMVal::Void)
-        {
-            mMap[getOpCodeStr(mOpCode)] = {
-                mOpCode, mArgType0, mArgType1, mArgType2};
-        }
-
         inline const InstructionTemplateMap& getInstructionTemplates()
         {
             static bool initialized{false};
@@ -60,70 +73,8 @@ namespace ssvvm
 
             if(!initialized)
             {
-                addInstructionTemplate(instructionTemplates, OpCode::halt);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::loadIntCVToR, VMVal::Int, VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::loadFloatCVToR, VMVal::Int, VMVal::Float);
-                addInstructionTemplate(instructionTemplates, OpCode::moveRVToR,
-                    VMVal::Int, VMVal::Int);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::pushRVToS, VMVal::Int);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::popSVToR, VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::moveSBOVToR, VMVal::Int, VMVal::Int);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::pushIntCVToS, VMVal::Int);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::pushFloatCVToS, VMVal::Float);
-                addInstructionTemplate(instructionTemplates, OpCode::pushSVToS);
-                addInstructionTemplate(instructionTemplates, OpCode::popSV);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::callPI, VMVal::Int);
-                addInstructionTemplate(instructionTemplates, OpCode::returnPI);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::goToPI, VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::goToPIIfIntRV, VMVal::Int, VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::goToPIIfCompareRVGreater, VMVal::Int, VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::goToPIIfCompareRVSmaller, VMVal::Int, VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::goToPIIfCompareRVEqual, VMVal::Int, VMVal::Int);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::incrementIntRV, VMVal::Int);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::decrementIntRV, VMVal::Int);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::addInt2SVs);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::addFloat2SVs);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::subtractInt2SVs);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::subtractFloat2SVs);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::multiplyInt2SVs);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::multiplyFloat2SVs);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::divideInt2SVs);
-                addInstructionTemplate(
-                    instructionTemplates, OpCode::divideFloat2SVs);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::compareIntRVIntRVToR, VMVal::Int, VMVal::Int,
-                    VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::compareIntRVIntSVToR, VMVal::Int, VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::compareIntSVIntSVToR, VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::compareIntRVIntCVToR, VMVal::Int, VMVal::Int,
-                    VMVal::Int);
-                addInstructionTemplate(instructionTemplates,
-                    OpCode::compareIntSVIntCVToR, VMVal::Int, VMVal::Int);
+                for(auto i(0u); i < opCodeCount; ++i)
+                    instructionTemplates[getOpCodeStr(OpCode(i))] = {OpCode(i)};
 
                 initialized = true;
             }
@@ -143,18 +94,11 @@ namespace ssvvm
     }
 
     template <bool TDebug>
-    inline Program getAssembledProgram(SourceVeeAsm& mSource)
+    inline Program getAssembledProgram(const PreprocessedSource& mSource)
     {
-        if(!mSource.isPreprocessed()) throw;
-
-        getASMLA().setSource(mSource.getSourceString());
-        getASMLA().tokenize();
-
-        auto tokens(getASMLA().getTokens());
-
-        // for(auto& t : tokens) ssvu::lo() << t.contents;
+        const auto& tokens(mSource.tokens);
 
-        Program result;
+        std::vector<Instruction> instructions;
 
         // Phase 4: separating instructions using semicolons
         struct SrcInstruction
@@ -257,7 +201,9 @@ namespace ssvvm
         std::size_t instructionIdx{0};
         for(auto& i : srcInstructions)
         {
-            ssvu::lo(instructionIdx++) << i.identifier << " " << i.args << "\n";
+            if(TDebug)
+                ssvu::lo(instructionIdx++) << i.identifier << " " << i.args
+                                           << "\n";
 
             if(!Impl::hasInstructionTemplate(i.identifier))
             {
@@ -276,13 +222,48 @@ namespace ssvvm
                 throw;
             }
 
-            it.addToProgram(result, i.args);
+            for(auto k(0u); k < i.args.size(); ++k)
+                if(!it.acceptsArg(k, i.args[k]))
+                {
+                    ssvu::lo("ASSEMBLER ERROR") << "OpCode '" << i.identifier
+                                                << "' argument '" << k
+                                                << "' has the wrong type\n";
+                    throw;
+                }
+
+            for(auto k(0u); k < i.args.size(); ++k)
+                if(!it.acceptsArgValue(k, i.args[k], srcInstructions.size()))
+                {
+                    ssvu::lo("ASSEMBLER ERROR") << "OpCode '" << i.identifier
+                                                << "' argument '" << k
+                                                << "' is out of range\n";
+                    throw;
+                }
+
+            it.addToInstructions(instructions, i.args);
         }
 
-        ssvu::lo().flush();
+        if(TDebug) ssvu::lo().flush();
 
+        auto result(Program::fromInstructions(instructions));
+        result.setStackFrameSize(mSource.stackFrameSize);
         return result;
     }
+
+    // Assembles preprocessed text
+    template <bool TDebug>
+    inline Program getAssembledProgram(SourceVeeAsm& mSource)
+    {
+        if(!mSource.isPreprocessed()) throw;
+
+        getASMLA().setSource(mSource.getSourceString());
+        getASMLA().tokenize();
+
+        PreprocessedSource preprocessed;
+        preprocessed.tokens = getASMLA().getTokens();
+        preprocessed.stackFrameSize = mSource.getStackFrameSize();
+        return getAssembledProgram<TDebug>(preprocessed);
+    }
 }
 
 #endif
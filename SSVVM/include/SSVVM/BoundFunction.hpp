@@ -9,92 +9,123 @@ namespace ssvvm
 {
     namespace Impl
     {
-        template <std::size_t TIdx, typename TArg, typename T>
-        inline static void makeParamsTuple(T& mTpl, const Params& mParams)
-        {
-            std::get<TIdx>(mTpl) = mParams[TIdx].template get<TArg>();
-        }
-        template <std::size_t TIdx, typename TArg1, typename TArg2,
-            typename... TArgs, typename T>
-        inline static void makeParamsTuple(T& mTpl, const Params& mParams)
-        {
-            makeParamsTuple<TIdx, TArg1>(mTpl, mParams);
-            makeParamsTuple<TIdx + 1, TArg2, TArgs...>(mTpl, mParams);
-        }
-
-        template <std::size_t TIdx, typename TArg, typename T>
-        inline static void bfArrayFillHelper(T& mArray)
-        {
-            mArray[TIdx] = getVMVal<TArg>();
-        }
-        template <std::size_t TIdx, typename TArg1, typename TArg2,
-            typename... TArgs, typename T>
-        inline static void bfArrayFillHelper(T& mArray)
-        {
-            bfArrayFillHelper<TIdx, TArg1>(mArray);
-            bfArrayFillHelper<TIdx + 1, TArg2, TArgs...>(mArray);
-        }
+        // Type-erased C function pointer, cast back by its trampoline
+        using NativeFnPtr = void (*)();
 
+        // Calls a native function with arguments taken from the stack, then
+        // returns the new stack top
+        template <typename TValue>
+        using NativeTrampoline = TValue* (*)(NativeFnPtr, TValue*);
 
-        struct CFunctionBase
+        // The arguments are the `sizeof...(TArgs)` values below `mTop`, the
+        // first one being the deepest. They are replaced by the result.
+        template <typename TValue, typename TReturn, typename... TArgs>
+        struct NativeCaller
         {
-            inline virtual Value call(const Params&) { throw; }
-            inline virtual ~CFunctionBase() {}
-        };
-
-        template <typename TReturn, typename... TArgs>
-        struct CFunction;
-        template <typename TReturn, typename... TArgs>
-        struct CFunction<TReturn(TArgs...)> : public CFunctionBase
-        {
-            using Ptr = TReturn (*)(TArgs...);
-
-            Ptr ptr;
-            inline CFunction(Ptr mPtr) noexcept : ptr{mPtr} {}
-            inline Value call(const Params& mParams) override
+            template <std::size_t... TIs>
+            inline static TValue* call(NativeFnPtr mFn, TValue* mTop,
+                std::index_sequence<TIs...>) noexcept
             {
-                ssvu::Tpl<TArgs...> paramsTuple;
-                makeParamsTuple<0, TArgs...>(paramsTuple, mParams);
-                return ssvu::explode(*ptr, paramsTuple);
+                const auto& fn(reinterpret_cast<TReturn (*)(TArgs...)>(mFn));
+                const auto& args(mTop - sizeof...(TArgs));
+
+                *args = TValue::template create<TReturn>(
+                    fn(args[TIs].template get<TArgs>()...));
+                return args + 1;
             }
         };
-        template <typename... TArgs>
-        struct CFunction<void(TArgs...)> : public CFunctionBase
+        template <typename TValue, typename... TArgs>
+        struct NativeCaller<TValue, void, TArgs...>
         {
-            using Ptr = void (*)(TArgs...);
-
-            Ptr ptr;
-            inline CFunction(Ptr mPtr) noexcept : ptr{mPtr} {}
-            inline Value call(const Params& mParams) override
+            template <std::size_t... TIs>
+            inline static TValue* call(NativeFnPtr mFn, TValue* mTop,
+                std::index_sequence<TIs...>) noexcept
             {
-                ssvu::Tpl<TArgs...> paramsTuple;
-                makeParamsTuple<0, TArgs...>(paramsTuple, mParams);
-                ssvu::explode(*ptr, paramsTuple);
-                return {};
+                const auto& fn(reinterpret_cast<void (*)(TArgs...)>(mFn));
+                const auto& args(mTop - sizeof...(TArgs));
+
+                fn(args[TIs].template get<TArgs>()...);
+                return args;
             }
         };
+
+        // One instantiation per bound signature and value type
+        template <typename TValue, typename TReturn, typename... TArgs>
+        inline TValue* nativeTrampoline(NativeFnPtr mFn, TValue* mTop) noexcept
+        {
+            return NativeCaller<TValue, TReturn, TArgs...>::call(
+                mFn, mTop, std::index_sequence_for<TArgs...>{});
+        }
     }
 
+    // C function callable from bytecode through `callNative`. Binding a
+    // function instantiates trampolines for its signature, which read the
+    // arguments straight from the VM stack and push the result, so a call
+    // costs one indirect call on top of the function itself. Bound functions
+    // must not throw.
     class BoundFunction
     {
     private:
+        Impl::NativeFnPtr fnPtr;
+        Impl::NativeTrampoline<Value> taggedTrampoline;
+        Impl::NativeTrampoline<RawValue> untaggedTrampoline;
+
         VMVal returnType;
         std::array<VMVal, Params::valueCount> paramTypes;
-        ssvu::UPtr<Impl::CFunctionBase> cFunction;
+        std::size_t paramCount;
 
     public:
         template <typename TReturn, typename... TArgs>
-        inline BoundFunction(TReturn (*mFnPtr)(TArgs...))
-            : returnType{getVMVal<TReturn>()},
-              cFunction{ssvu::UPtr<Impl::CFunctionBase>(
-                  new Impl::CFunction<TReturn(TArgs...)>(mFnPtr))}
+        inline BoundFunction(TReturn (*mFnPtr)(TArgs...)) noexcept
+            : fnPtr{reinterpret_cast<Impl::NativeFnPtr>(mFnPtr)},
+              taggedTrampoline{
+                  &Impl::nativeTrampoline<Value, TReturn, TArgs...>},
+              untaggedTrampoline{
+                  &Impl::nativeTrampoline<RawValue, TReturn, TArgs...>},
+              returnType{getVMVal<TReturn>()},
+              paramTypes{{getVMVal<TArgs>()...}},
+              paramCount{sizeof...(TArgs)}
+        {
+            SSVU_ASSERT_STATIC(sizeof...(TArgs) <= Params::valueCount,
+                "Too many parameters for a bound function");
+        }
+
+        // Stack calls: consume the arguments below `mTop`, push the result
+        // and return the new top
+        inline Value* call(Value* mTop) const noexcept
+        {
+            return taggedTrampoline(fnPtr, mTop);
+        }
+        inline RawValue* call(RawValue* mTop) const noexcept
         {
-            Impl::bfArrayFillHelper<0, TArgs...>(paramTypes);
+            return untaggedTrampoline(fnPtr, mTop);
         }
 
-        inline Value call(const Params& mParams)
+        inline Value call(const Params& mParams) const noexcept
+        {
+            std::array<Value, Params::valueCount + 1> values;
+            for(auto i(0u); i < paramCount; ++i) values[i] = mParams[i];
+
+            call(values.data() + paramCount);
+            return returnType == VMVal::Void ? Value{} : values[0];
+        }
+
+        inline Impl::NativeFnPtr getFnPtr() const noexcept { return fnPtr; }
+        inline Impl::NativeTrampoline<RawValue>
+        getUntaggedTrampoline() const noexcept
+        {
+            return untaggedTrampoline;
+        }
+
+        inline VMVal getReturnType() const noexcept { return returnType; }
+        inline VMVal getParamType(std::size_t mIdx) const noexcept
+        {
+            SSVU_ASSERT(mIdx < paramCount);
+            return paramTypes[mIdx];
+        }
+        inline std::size_t getParamCount() const noexcept
         {
-            return cFunction->call(mParams);
+            return paramCount;
         }
     };
 }
@@ -0,0 +1,188 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVVM_BYTECODE
+#define SSVVM_BYTECODE
+
+namespace ssvvm
+{
+    // Byte used to store an opcode in a packed program
+    using OpByte = std::uint8_t;
+    // Byte used to store a register index in a packed program
+    using RegByte = std::uint8_t;
+
+    SSVU_ASSERT_STATIC(opCodeCount <= 256, "Opcodes must fit in one byte");
+
+    // Kinds of immediate operands that can follow an opcode
+    enum class Operand : std::uint8_t
+    {
+        None,
+        Reg,    // Register index - 1 byte
+        Int,    // Constant int - 4 bytes
+        Float,  // Constant float - 4 bytes
+        Target  // Instruction offset in the packed program - 4 bytes
+    };
+
+    template <Operand TOperand>
+    struct OperandInfo;
+    template <>
+    struct OperandInfo<Operand::Reg>
+    {
+        using Type = Register::Idx;
+        using Storage = RegByte;
+    };
+    template <>
+    struct OperandInfo<Operand::Int>
+    {
+        using Type = int;
+        using Storage = std::int32_t;
+    };
+    template <>
+    struct OperandInfo<Operand::Float>
+    {
+        using Type = float;
+        using Storage = float;
+    };
+    template <>
+    struct OperandInfo<Operand::Target>
+    {
+        using Type = Instruction::Idx;
+        using Storage = std::int32_t;
+    };
+
+    inline constexpr std::size_t getOperandSize(Operand mOperand) noexcept
+    {
+        return mOperand == Operand::None
+                   ? 0
+                   : mOperand == Operand::Reg ? sizeof(RegByte) : 4;
+    }
+
+    // Immediate operands of an opcode, in order - every opcode has a fixed
+    // layout, so the VM can decode operands in place
+    struct OperandLayout
+    {
+        Operand operands[Params::valueCount];
+
+        inline constexpr std::size_t getCount() const noexcept
+        {
+            std::size_t result{0};
+            while(result < Params::valueCount &&
+                  operands[result] != Operand::None)
+                ++result;
+            return result;
+        }
+
+        // Byte offset of an operand, relative to the first operand byte
+        inline constexpr std::size_t getOffset(std::size_t mIdx) const
+            noexcept
+        {
+            std::size_t result{0};
+            for(std::size_t i{0}; i < mIdx; ++i)
+                result += getOperandSize(operands[i]);
+            return result;
+        }
+    };
+
+    inline constexpr OperandLayout getOperandLayout(OpCode mOpCode) noexcept
+    {
+        using O = Operand;
+
+        switch(mOpCode)
+        {
+            case OpCode::loadIntCVToR: return {{O::Reg, O::Int}};
+            case OpCode::loadFloatCVToR: return {{O::Reg, O::Float}};
+            case OpCode::moveRVToR: return {{O::Reg, O::Reg}};
+
+            case OpCode::pushRVToS: return {{O::Reg}};
+            case OpCode::popSVToR: return {{O::Reg}};
+            case OpCode::moveSBOVToR: return {{O::Reg, O::Int}};
+
+            case OpCode::pushIntCVToS: return {{O::Int}};
+            case OpCode::pushFloatCVToS: return {{O::Float}};
+
+            case OpCode::goToPI: return {{O::Target}};
+            case OpCode::goToPIIfIntRV:
+            case OpCode::goToPIIfCompareRVGreater:
+            case OpCode::goToPIIfCompareRVSmaller:
+            case OpCode::goToPIIfCompareRVEqual: return {{O::Target, O::Reg}};
+            case OpCode::callPI: return {{O::Target}};
+            case OpCode::callNative: return {{O::Int}};
+
+            case OpCode::incrementIntRV: return {{O::Reg}};
+            case OpCode::decrementIntRV: return {{O::Reg}};
+            case OpCode::multiplyIntRVRVToR:
+            case OpCode::divideIntRVRVToR:
+            case OpCode::moduloIntRVRVToR: return {{O::Reg, O::Reg, O::Reg}};
+
+            case OpCode::compareIntRVIntRVToR:
+                return {{O::Reg, O::Reg, O::Reg}};
+            case OpCode::compareIntRVIntSVToR: return {{O::Reg, O::Reg}};
+            case OpCode::compareIntSVIntSVToR: return {{O::Reg}};
+            case OpCode::compareIntRVIntCVToR:
+                return {{O::Reg, O::Reg, O::Int}};
+            case OpCode::compareIntSVIntCVToR: return {{O::Reg, O::Int}};
+
+            case OpCode::addIntRVRVToR:
+            case OpCode::subtractIntRVRVToR: return {{O::Reg, O::Reg, O::Reg}};
+            case OpCode::addIntRVCVToS:
+            case OpCode::subtractIntRVCVToS: return {{O::Reg, O::Int}};
+            case OpCode::addIntRVSVToR: return {{O::Reg, O::Reg}};
+            case OpCode::goToPIIfCompareIntRVIntCVGreater:
+            case OpCode::goToPIIfCompareIntRVIntCVSmaller:
+            case OpCode::goToPIIfCompareIntRVIntCVEqual:
+                return {{O::Target, O::Reg, O::Reg, O::Int}};
+
+            default: return {{O::None}};
+        }
+    }
+
+    // Total size of an instruction in the packed program, opcode included
+    inline constexpr std::size_t getInstructionSize(OpCode mOpCode) noexcept
+    {
+        return sizeof(OpByte) +
+               getOperandLayout(mOpCode).getOffset(Params::valueCount);
+    }
+
+    namespace Impl
+    {
+        // Instruction sizes indexed by opcode, for runtime lookups
+        struct InstructionSizeTable
+        {
+            std::uint8_t sizes[opCodeCount];
+
+            inline constexpr InstructionSizeTable() noexcept : sizes{}
+            {
+                for(std::size_t i{0}; i < opCodeCount; ++i)
+                    sizes[i] = getInstructionSize(OpCode(i));
+            }
+        };
+
+        static constexpr InstructionSizeTable instructionSizeTable{};
+    }
+
+    inline std::size_t lookupInstructionSize(OpCode mOpCode) noexcept
+    {
+        return Impl::instructionSizeTable.sizes[std::size_t(mOpCode)];
+    }
+
+    template <OpCode TOpCode, std::size_t TIdx>
+    using OperandInfoOf =
+        OperandInfo<getOperandLayout(TOpCode).operands[TIdx]>;
+
+    // Reads the `TIdx`-th operand of a `TOpCode` instruction, given a pointer
+    // to its first operand byte
+    template <OpCode TOpCode, std::size_t TIdx>
+    inline auto readOperand(const OpByte* mOperands) noexcept
+    {
+        using Info = OperandInfoOf<TOpCode, TIdx>;
+        typename Info::Storage result;
+
+        std::memcpy(&result,
+            mOperands + getOperandLayout(TOpCode).getOffset(TIdx),
+            sizeof(result));
+        return typename Info::Type(result);
+    }
+}
+
+#endif
@@ -5,11 +5,56 @@
 #ifndef SSVVM_COMMON
 #define SSVVM_COMMON
 
+// Computed goto ("labels as values") is a GCC/Clang extension - other
+// compilers fall back to a `switch`-based threaded loop
+#if !defined(SSVVM_COMPUTED_GOTO)
+#if defined(__GNUC__) || defined(__clang__)
+#define SSVVM_COMPUTED_GOTO 1
+#else
+#define SSVVM_COMPUTED_GOTO 0
+#endif
+#endif
+
+// The JIT emits x86-64 code into `mmap`-ed buffers, so it is only available
+// on x86-64 POSIX systems - elsewhere, programs are always interpreted
+#if !defined(SSVVM_JIT)
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define SSVVM_JIT 1
+#else
+#define SSVVM_JIT 0
+#endif
+#endif
+
+// Program files are memory-mapped on POSIX systems, and read into memory
+// elsewhere
+#if !defined(SSVVM_MMAP)
+#if defined(__unix__) || defined(__APPLE__)
+#define SSVVM_MMAP 1
+#else
+#define SSVVM_MMAP 0
+#endif
+#endif
+
 namespace ssvvm
 {
     template <typename T>
     using VMFnPtr = void (T::*)();
 
+    // Instruction dispatch strategies
+    enum class VMDispatch
+    {
+        FnPtr,    // Fetch, decode and call through a member function pointer
+        Threaded, // Threaded dispatch straight from the packed bytecode
+        Profiled  // `FnPtr`, collecting per-instruction data in `Profiler`
+    };
+
+    // Storage of stack and register values
+    enum class VMStorage
+    {
+        Tagged,  // `Value` - type-checked at runtime in debug builds
+        Untagged // `RawValue` - requires a program accepted by the verifier
+    };
+
     // Built-in value types and conversions
     enum class VMVal
     {
@@ -36,23 +81,36 @@ namespace ssvvm
         return VMVal::Float;
     }
 
+    namespace Impl
+    {
+        // 64-bit FNV-1a
+        inline std::uint64_t getFNV1a(const void* mData, std::size_t mSize,
+            std::uint64_t mHash = 14695981039346656037ull) noexcept
+        {
+            const auto& bytes(static_cast<const std::uint8_t*>(mData));
+            for(auto i(0u); i < mSize; ++i)
+                mHash = (mHash ^ bytes[i]) * 1099511628211ull;
+
+            return mHash;
+        }
+    }
+
     template <typename T>
     inline int getTokenAsInt(T& mTokens, std::size_t mIdx)
     {
-        return ssvu::sToInt(mTokens[mIdx].contents.c_str());
+        return ssvu::sToInt(mTokens[mIdx].getContents().c_str());
     }
     template <typename T>
     inline float getTokenAsFloat(T& mTokens, std::size_t mIdx)
     {
-        return ssvu::sToFloat(
-            mTokens[mIdx]
-                .contents.substr(0, mTokens[mIdx].contents.size() - 2)
-                .c_str());
+        // Drop the ".f" suffix
+        const auto& t(mTokens[mIdx]);
+        return ssvu::sToFloat(std::string(t.begin, t.size - 2).c_str());
     }
     template <typename T>
-    inline const std::string& getTokenContents(T& mTokens, std::size_t mIdx)
+    inline std::string getTokenContents(T& mTokens, std::size_t mIdx)
     {
-        return mTokens[mIdx].contents;
+        return mTokens[mIdx].getContents();
     }
 }
 
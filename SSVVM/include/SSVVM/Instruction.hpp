@@ -7,6 +7,8 @@
 
 namespace ssvvm
 {
+    // Unpacked instruction, as produced by the assembler - see `Program` for
+    // the packed representation executed by the VM
     struct Instruction
     {
         using Idx = int;
@@ -0,0 +1,888 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVVM_JIT_COMPILER
+#define SSVVM_JIT_COMPILER
+
+#if SSVVM_JIT
+#include <sys/mman.h>
+#endif
+
+namespace ssvvm
+{
+    // Disabled JIT: tagged values are always interpreted
+    template <typename TValue>
+    class JIT
+    {
+    public:
+        inline void reset(const Program&) {}
+        inline void enable(std::size_t) noexcept {}
+        inline bool isEnabled() const noexcept { return false; }
+        inline void countCall(const Program&,
+            const std::vector<BoundFunction>&, Instruction::Idx)
+        {
+        }
+        inline const void* getEntry(Instruction::Idx) const noexcept
+        {
+            return nullptr;
+        }
+
+        template <typename TRegistry, typename TStack>
+        inline Instruction::Idx run(const void*, TRegistry&, TStack&) noexcept
+        {
+            return 0;
+        }
+    };
+
+#if SSVVM_JIT
+    namespace Impl
+    {
+        namespace X64
+        {
+            using Reg = std::uint8_t;
+
+            static constexpr Reg rax{0}, rcx{1}, rdx{2}, rbx{3}, rsp{4},
+                rbp{5}, rsi{6}, rdi{7}, r12{12}, r13{13}, r14{14};
+            static constexpr Reg xmm0{0}, xmm1{1};
+
+            // `jcc rel32` second opcode bytes
+            static constexpr std::uint8_t ccE{0x84}, ccNE{0x85}, ccL{0x8C},
+                ccG{0x8F};
+        }
+
+        // Minimal x86-64 encoder, covering only what the JIT emits. Memory
+        // operands are always `[base + disp32]`.
+        class X64Emitter
+        {
+        private:
+            std::vector<std::uint8_t> code;
+
+            inline void rex(bool mW, X64::Reg mReg, X64::Reg mBase)
+            {
+                const std::uint8_t value(0x40 | (mW << 3) |
+                                         ((mReg >> 3) << 2) | (mBase >> 3));
+                if(value != 0x40) byte(value);
+            }
+            inline void mem(X64::Reg mReg, X64::Reg mBase, std::int32_t mDisp)
+            {
+                byte(0x80 | ((mReg & 7) << 3) | (mBase & 7));
+                if((mBase & 7) == X64::rsp) byte(0x24); // SIB for rsp/r12
+                imm32(mDisp);
+            }
+
+        public:
+            inline std::size_t getPos() const noexcept { return code.size(); }
+            inline const std::vector<std::uint8_t>& getCode() const noexcept
+            {
+                return code;
+            }
+
+            inline void byte(std::uint8_t mValue) { code.emplace_back(mValue); }
+            inline void imm32(std::int32_t mValue)
+            {
+                const auto& idx(code.size());
+                code.resize(idx + sizeof(mValue));
+                std::memcpy(&code[idx], &mValue, sizeof(mValue));
+            }
+
+            // `op reg, [base + disp]` (or `op [base + disp], reg`)
+            inline void opMem(std::initializer_list<std::uint8_t> mOpCode,
+                X64::Reg mReg, X64::Reg mBase, std::int32_t mDisp,
+                bool mW = false)
+            {
+                rex(mW, mReg, mBase);
+                for(const auto& b : mOpCode) byte(b);
+                mem(mReg, mBase, mDisp);
+            }
+            // SSE scalar single: `F3 0F op xmm, [base + disp]`
+            inline void sseMem(std::uint8_t mOpCode, X64::Reg mXmm,
+                X64::Reg mBase, std::int32_t mDisp)
+            {
+                byte(0xF3);
+                opMem({0x0F, mOpCode}, mXmm, mBase, mDisp);
+            }
+
+            inline void movLoad(X64::Reg mReg, X64::Reg mBase,
+                std::int32_t mDisp, bool mW = false)
+            {
+                opMem({0x8B}, mReg, mBase, mDisp, mW);
+            }
+            inline void movStore(X64::Reg mBase, std::int32_t mDisp,
+                X64::Reg mReg, bool mW = false)
+            {
+                opMem({0x89}, mReg, mBase, mDisp, mW);
+            }
+            inline void movStoreImm(
+                X64::Reg mBase, std::int32_t mDisp, std::int32_t mImm)
+            {
+                opMem({0xC7}, 0, mBase, mDisp);
+                imm32(mImm);
+            }
+            inline void movImm(X64::Reg mReg, std::int32_t mImm)
+            {
+                rex(false, 0, mReg);
+                byte(0xB8 | (mReg & 7));
+                imm32(mImm);
+            }
+            inline void movImm64(X64::Reg mReg, const void* mImm)
+            {
+                rex(true, 0, mReg);
+                byte(0xB8 | (mReg & 7));
+
+                const auto& idx(code.size());
+                code.resize(idx + sizeof(mImm));
+                std::memcpy(&code[idx], &mImm, sizeof(mImm));
+            }
+
+            // `add/sub r32, imm32`
+            inline void addImm(X64::Reg mReg, std::int32_t mImm)
+            {
+                rex(false, 0, mReg);
+                byte(0x81);
+                byte(0xC0 | (mReg & 7));
+                imm32(mImm);
+            }
+            inline void subImm(X64::Reg mReg, std::int32_t mImm)
+            {
+                rex(false, 0, mReg);
+                byte(0x81);
+                byte(0xE8 | (mReg & 7));
+                imm32(mImm);
+            }
+
+            // `add/sub r64, imm8`
+            inline void addImm64(X64::Reg mReg, std::int8_t mImm)
+            {
+                rex(true, 0, mReg);
+                byte(0x83);
+                byte(0xC0 | (mReg & 7));
+                byte(mImm);
+            }
+            inline void subImm64(X64::Reg mReg, std::int8_t mImm)
+            {
+                rex(true, 0, mReg);
+                byte(0x83);
+                byte(0xE8 | (mReg & 7));
+                byte(mImm);
+            }
+
+            // `op dword [base + disp], imm8`, with `mExt` the ModRM extension
+            inline void opMemImm8(std::uint8_t mExt, X64::Reg mBase,
+                std::int32_t mDisp, std::int8_t mImm)
+            {
+                opMem({0x83}, mExt, mBase, mDisp);
+                byte(mImm);
+            }
+
+            inline void test(X64::Reg mReg)
+            {
+                rex(false, mReg, mReg);
+                byte(0x85);
+                byte(0xC0 | ((mReg & 7) << 3) | (mReg & 7));
+            }
+            inline void cdq() { byte(0x99); }
+
+            inline void movReg64(X64::Reg mDst, X64::Reg mSrc)
+            {
+                rex(true, mSrc, mDst);
+                byte(0x89);
+                byte(0xC0 | ((mSrc & 7) << 3) | (mDst & 7));
+            }
+            inline void push(X64::Reg mReg)
+            {
+                rex(false, 0, mReg);
+                byte(0x50 | (mReg & 7));
+            }
+            inline void pop(X64::Reg mReg)
+            {
+                rex(false, 0, mReg);
+                byte(0x58 | (mReg & 7));
+            }
+            inline void jmpReg(X64::Reg mReg)
+            {
+                rex(false, 0, mReg);
+                byte(0xFF);
+                byte(0xE0 | (mReg & 7));
+            }
+            inline void callReg(X64::Reg mReg)
+            {
+                rex(false, 0, mReg);
+                byte(0xFF);
+                byte(0xD0 | (mReg & 7));
+            }
+            inline void ret() { byte(0xC3); }
+
+            // Relative jumps - return the position of the rel32 to patch
+            inline std::size_t jmp()
+            {
+                byte(0xE9);
+                imm32(0);
+                return getPos() - 4;
+            }
+            inline std::size_t jcc(std::uint8_t mCondition)
+            {
+                byte(0x0F);
+                byte(mCondition);
+                imm32(0);
+                return getPos() - 4;
+            }
+            inline void patch(std::size_t mPos, std::size_t mTarget)
+            {
+                const std::int32_t rel(std::int64_t(mTarget) - (mPos + 4));
+                std::memcpy(&code[mPos], &rel, sizeof(rel));
+            }
+        };
+
+        // Executable memory holding one compiled function
+        class JITCode
+        {
+        private:
+            void* memory{nullptr};
+            std::size_t size{0};
+
+        public:
+            inline JITCode() = default;
+            inline JITCode(const JITCode&) = delete;
+            inline JITCode(JITCode&& mOther) noexcept
+                : memory{mOther.memory}, size{mOther.size}
+            {
+                mOther.memory = nullptr;
+            }
+            inline ~JITCode()
+            {
+                if(memory != nullptr) munmap(memory, size);
+            }
+
+            // Copies `mCode` into a new mapping, then makes it executable
+            inline bool load(const std::vector<std::uint8_t>& mCode)
+            {
+                size = mCode.size();
+                memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+                if(memory == MAP_FAILED)
+                {
+                    memory = nullptr;
+                    return false;
+                }
+
+                std::memcpy(memory, mCode.data(), size);
+                return mprotect(memory, size, PROT_READ | PROT_EXEC) == 0;
+            }
+
+            inline const std::uint8_t* getData() const noexcept
+            {
+                return static_cast<const std::uint8_t*>(memory);
+            }
+        };
+
+        // State shared between the VM and compiled code
+        struct JITState
+        {
+            RawValue* registers;
+            RawValue* top;
+            RawValue* base;
+        };
+
+        // Compiled code is entered through its prologue, which jumps to the
+        // native address of the requested instruction. It returns the offset
+        // of the instruction the interpreter has to resume from.
+        using JITFnPtr = Instruction::Idx (*)(JITState*, const void*);
+
+        struct JITEntry
+        {
+            JITFnPtr fn{nullptr};
+            const void* target{nullptr};
+        };
+
+        // Template JIT: translates every instruction of a function (the code
+        // reachable from its entry without following calls) on its own.
+        // `callPI`, `returnPI` and `halt` exit to the interpreter, which
+        // re-enters compiled code after calls and returns.
+        class JITCompiler
+        {
+        private:
+            using E = X64Emitter;
+
+            // Register allocation of the compiled code
+            static constexpr X64::Reg state{X64::rbx}, regs{X64::r12},
+                top{X64::r13}, base{X64::r14};
+
+            SSVU_ASSERT_STATIC(sizeof(RawValue) == 4, "");
+            static constexpr std::int32_t slot{sizeof(RawValue)};
+
+            const Program& program;
+            const std::vector<BoundFunction>& natives;
+            std::vector<bool> inFunction;
+            std::vector<Instruction::Idx> offsets;
+
+            E e;
+            std::size_t epiloguePos{0};
+            std::unordered_map<Instruction::Idx, std::size_t> labels;
+            std::vector<std::pair<std::size_t, Instruction::Idx>> jumps, exits;
+
+            inline static std::int32_t getRegDisp(int mIdx) noexcept
+            {
+                return mIdx * slot;
+            }
+
+            inline void findFunction(Instruction::Idx mEntry)
+            {
+                inFunction.assign(program.getByteSize(), false);
+                std::vector<Instruction::Idx> worklist{mEntry};
+
+                auto add([this, &worklist](Instruction::Idx mOffset)
+                    {
+                        if(mOffset < 0 ||
+                            std::size_t(mOffset) >= program.getByteSize() ||
+                            inFunction[mOffset])
+                            return;
+
+                        inFunction[mOffset] = true;
+                        worklist.emplace_back(mOffset);
+                    });
+
+                inFunction[mEntry] = true;
+                while(!worklist.empty())
+                {
+                    const auto offset(worklist.back());
+                    worklist.pop_back();
+
+                    const auto& opCode(program.getOpCode(offset));
+                    const auto& layout(getOperandLayout(opCode));
+                    const auto& operands(program.getData() + offset + 1);
+
+                    if(opCode == OpCode::halt || opCode == OpCode::returnPI)
+                        continue;
+
+                    for(auto k(0u); k < layout.getCount(); ++k)
+                    {
+                        if(layout.operands[k] != Operand::Target ||
+                            opCode == OpCode::callPI)
+                            continue;
+
+                        std::int32_t target;
+                        std::memcpy(&target, operands + layout.getOffset(k),
+                            sizeof(target));
+                        add(target);
+                    }
+
+                    if(opCode != OpCode::goToPI)
+                        add(offset + lookupInstructionSize(opCode));
+                }
+
+                for(std::size_t i{0}; i < inFunction.size(); ++i)
+                    if(inFunction[i]) offsets.emplace_back(i);
+            }
+
+            inline void emitExit(Instruction::Idx mOffset)
+            {
+                e.movImm(X64::rax, mOffset);
+                e.patch(e.jmp(), epiloguePos);
+            }
+            inline bool isInFunction(Instruction::Idx mOffset) const noexcept
+            {
+                return std::size_t(mOffset) < inFunction.size() &&
+                       inFunction[mOffset];
+            }
+
+            inline void emitJump(Instruction::Idx mTarget)
+            {
+                if(isInFunction(mTarget))
+                    jumps.emplace_back(e.jmp(), mTarget);
+                else
+                    exits.emplace_back(e.jmp(), mTarget);
+            }
+            inline void emitJcc(
+                std::uint8_t mCondition, Instruction::Idx mTarget)
+            {
+                if(isInFunction(mTarget))
+                    jumps.emplace_back(e.jcc(mCondition), mTarget);
+                else
+                    exits.emplace_back(e.jcc(mCondition), mTarget);
+            }
+
+            // Stack helpers: `[top - slot]` is the top value
+            inline void pushReg(X64::Reg mReg)
+            {
+                e.movStore(top, 0, mReg);
+                e.addImm64(top, slot);
+            }
+            inline void pushImm(std::int32_t mImm)
+            {
+                e.movStoreImm(top, 0, mImm);
+                e.addImm64(top, slot);
+            }
+            inline void loadRV(X64::Reg mReg, int mIdx)
+            {
+                e.movLoad(mReg, regs, getRegDisp(mIdx));
+            }
+            inline void storeRV(int mIdx, X64::Reg mReg)
+            {
+                e.movStore(regs, getRegDisp(mIdx), mReg);
+            }
+
+            // `a = pop(); b = pop(); push(a op b)`
+            inline void intStackOp(std::initializer_list<std::uint8_t> mOp)
+            {
+                e.movLoad(X64::rax, top, -slot);
+                e.opMem(mOp, X64::rax, top, -2 * slot);
+                e.movStore(top, -2 * slot, X64::rax);
+                e.subImm64(top, slot);
+            }
+            inline void floatStackOp(std::uint8_t mOp)
+            {
+                e.sseMem(0x10, X64::xmm0, top, -slot);
+                e.sseMem(mOp, X64::xmm0, top, -2 * slot);
+                e.sseMem(0x11, X64::xmm0, top, -2 * slot);
+                e.subImm64(top, slot);
+            }
+
+            inline static std::int32_t getBits(float mValue) noexcept
+            {
+                std::int32_t result;
+                std::memcpy(&result, &mValue, sizeof(result));
+                return result;
+            }
+
+            // Condition under which a branch instruction jumps, given flags
+            // set by comparing its value with 0
+            inline static std::uint8_t getCondition(OpCode mOpCode) noexcept
+            {
+                switch(mOpCode)
+                {
+                    case OpCode::goToPIIfCompareRVGreater:
+                    case OpCode::goToPIIfCompareIntRVIntCVGreater:
+                        return X64::ccG;
+                    case OpCode::goToPIIfCompareRVSmaller:
+                    case OpCode::goToPIIfCompareIntRVIntCVSmaller:
+                        return X64::ccL;
+                    case OpCode::goToPIIfCompareRVEqual:
+                    case OpCode::goToPIIfCompareIntRVIntCVEqual:
+                        return X64::ccE;
+                    default: return X64::ccNE; // goToPIIfIntRV
+                }
+            }
+
+            inline void condJump(std::uint8_t mCondition,
+                Instruction::Idx mTarget, Instruction::Idx mNext)
+            {
+                emitJcc(mCondition, mTarget);
+                emitJump(mNext);
+            }
+
+            // Returns false if the instruction cannot continue to `mNext`
+            inline bool emitInstruction(Instruction::Idx mOffset)
+            {
+                using O = OpCode;
+
+                const auto& opCode(program.getOpCode(mOffset));
+                const auto& operands(program.getData() + mOffset + 1);
+                const auto& next(
+                    Instruction::Idx(mOffset + lookupInstructionSize(opCode)));
+
+#define SSVVM_OPERAND(mIdx) readOperand<op, mIdx>(operands)
+
+                switch(opCode)
+                {
+                    case O::halt:
+                    case O::callPI:
+                    case O::returnPI: emitExit(mOffset); return false;
+
+                    case O::loadIntCVToR:
+                    {
+                        constexpr auto op(O::loadIntCVToR);
+                        e.movStoreImm(regs, getRegDisp(SSVVM_OPERAND(0)),
+                            SSVVM_OPERAND(1));
+                        break;
+                    }
+                    case O::loadFloatCVToR:
+                    {
+                        constexpr auto op(O::loadFloatCVToR);
+                        e.movStoreImm(regs, getRegDisp(SSVVM_OPERAND(0)),
+                            getBits(SSVVM_OPERAND(1)));
+                        break;
+                    }
+                    case O::moveRVToR:
+                    {
+                        constexpr auto op(O::moveRVToR);
+                        loadRV(X64::rax, SSVVM_OPERAND(1));
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+
+                    case O::pushRVToS:
+                    {
+                        constexpr auto op(O::pushRVToS);
+                        loadRV(X64::rax, SSVVM_OPERAND(0));
+                        pushReg(X64::rax);
+                        break;
+                    }
+                    case O::popSVToR:
+                    {
+                        constexpr auto op(O::popSVToR);
+                        e.subImm64(top, slot);
+                        e.movLoad(X64::rax, top, 0);
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+                    case O::moveSBOVToR:
+                    {
+                        constexpr auto op(O::moveSBOVToR);
+                        e.movLoad(
+                            X64::rax, base, (-SSVVM_OPERAND(1) - 1) * slot);
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+
+                    case O::pushIntCVToS:
+                    {
+                        constexpr auto op(O::pushIntCVToS);
+                        pushImm(SSVVM_OPERAND(0));
+                        break;
+                    }
+                    case O::pushFloatCVToS:
+                    {
+                        constexpr auto op(O::pushFloatCVToS);
+                        pushImm(getBits(SSVVM_OPERAND(0)));
+                        break;
+                    }
+                    case O::pushSVToS:
+                        e.movLoad(X64::rax, top, -slot);
+                        pushReg(X64::rax);
+                        break;
+                    case O::popSV: e.subImm64(top, slot); break;
+
+                    case O::goToPI:
+                    {
+                        constexpr auto op(O::goToPI);
+                        emitJump(SSVVM_OPERAND(0));
+                        return false;
+                    }
+                    case O::goToPIIfIntRV:
+                    case O::goToPIIfCompareRVGreater:
+                    case O::goToPIIfCompareRVSmaller:
+                    case O::goToPIIfCompareRVEqual:
+                    {
+                        // Same layout for the four opcodes
+                        constexpr auto op(O::goToPIIfIntRV);
+                        e.opMemImm8(7, regs, getRegDisp(SSVVM_OPERAND(1)), 0);
+                        condJump(getCondition(opCode), SSVVM_OPERAND(0), next);
+                        return false;
+                    }
+
+                    case O::callNative:
+                    {
+                        // The untagged trampoline takes and returns the stack
+                        // top. Only the callee-saved registers hold state,
+                        // and `rsp` is 8 bytes off 16-byte alignment after
+                        // the four pushes of the prologue.
+                        constexpr auto op(O::callNative);
+                        const auto& fn(natives[SSVVM_OPERAND(0)]);
+
+                        e.movImm64(X64::rdi,
+                            reinterpret_cast<const void*>(fn.getFnPtr()));
+                        e.movReg64(X64::rsi, top);
+                        e.movImm64(X64::rax, reinterpret_cast<const void*>(
+                                                 fn.getUntaggedTrampoline()));
+                        e.subImm64(X64::rsp, 8);
+                        e.callReg(X64::rax);
+                        e.addImm64(X64::rsp, 8);
+                        e.movReg64(top, X64::rax);
+                        break;
+                    }
+
+                    case O::incrementIntRV:
+                    {
+                        constexpr auto op(O::incrementIntRV);
+                        e.opMemImm8(0, regs, getRegDisp(SSVVM_OPERAND(0)), 1);
+                        break;
+                    }
+                    case O::decrementIntRV:
+                    {
+                        constexpr auto op(O::decrementIntRV);
+                        e.opMemImm8(5, regs, getRegDisp(SSVVM_OPERAND(0)), 1);
+                        break;
+                    }
+                    case O::multiplyIntRVRVToR:
+                    {
+                        constexpr auto op(O::multiplyIntRVRVToR);
+                        loadRV(X64::rax, SSVVM_OPERAND(1));
+                        e.opMem({0x0F, 0xAF}, X64::rax, regs,
+                            getRegDisp(SSVVM_OPERAND(2)));
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+                    case O::divideIntRVRVToR:
+                    case O::moduloIntRVRVToR:
+                    {
+                        // Same layout for both opcodes - `idiv` leaves the
+                        // quotient in `eax` and the remainder in `edx`
+                        constexpr auto op(O::divideIntRVRVToR);
+                        loadRV(X64::rax, SSVVM_OPERAND(1));
+                        e.cdq();
+                        e.opMem(
+                            {0xF7}, 7, regs, getRegDisp(SSVVM_OPERAND(2)));
+                        storeRV(SSVVM_OPERAND(0),
+                            opCode == O::divideIntRVRVToR ? X64::rax
+                                                          : X64::rdx);
+                        break;
+                    }
+
+                    case O::addInt2SVs: intStackOp({0x03}); break;
+                    case O::subtractInt2SVs: intStackOp({0x2B}); break;
+                    case O::multiplyInt2SVs: intStackOp({0x0F, 0xAF}); break;
+                    case O::divideInt2SVs:
+                        e.movLoad(X64::rax, top, -slot);
+                        e.cdq();
+                        e.opMem({0xF7}, 7, top, -2 * slot); // idiv
+                        e.movStore(top, -2 * slot, X64::rax);
+                        e.subImm64(top, slot);
+                        break;
+
+                    case O::addFloat2SVs: floatStackOp(0x58); break;
+                    case O::subtractFloat2SVs: floatStackOp(0x5C); break;
+                    case O::multiplyFloat2SVs: floatStackOp(0x59); break;
+                    case O::divideFloat2SVs: floatStackOp(0x5E); break;
+
+                    case O::compareIntRVIntRVToR:
+                    {
+                        constexpr auto op(O::compareIntRVIntRVToR);
+                        loadRV(X64::rax, SSVVM_OPERAND(1));
+                        e.opMem({0x2B}, X64::rax, regs,
+                            getRegDisp(SSVVM_OPERAND(2)));
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+                    case O::compareIntRVIntSVToR:
+                    {
+                        constexpr auto op(O::compareIntRVIntSVToR);
+                        loadRV(X64::rax, SSVVM_OPERAND(1));
+                        e.opMem({0x2B}, X64::rax, top, -slot);
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+                    case O::compareIntSVIntSVToR:
+                    {
+                        constexpr auto op(O::compareIntSVIntSVToR);
+                        e.movLoad(X64::rax, top, -slot);
+                        e.opMem({0x2B}, X64::rax, top, -2 * slot);
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+                    case O::compareIntRVIntCVToR:
+                    {
+                        constexpr auto op(O::compareIntRVIntCVToR);
+                        loadRV(X64::rax, SSVVM_OPERAND(1));
+                        e.subImm(X64::rax, SSVVM_OPERAND(2));
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+                    case O::compareIntSVIntCVToR:
+                    {
+                        constexpr auto op(O::compareIntSVIntCVToR);
+                        e.movLoad(X64::rax, top, -slot);
+                        e.subImm(X64::rax, SSVVM_OPERAND(1));
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+
+                    case O::addIntRVRVToR:
+                    case O::subtractIntRVRVToR:
+                    {
+                        // Same layout for both opcodes
+                        constexpr auto op(O::addIntRVRVToR);
+                        const std::uint8_t aluOp(
+                            opCode == O::addIntRVRVToR ? 0x03 : 0x2B);
+
+                        loadRV(X64::rax, SSVVM_OPERAND(1));
+                        e.opMem({aluOp}, X64::rax, regs,
+                            getRegDisp(SSVVM_OPERAND(2)));
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+                    case O::addIntRVCVToS:
+                    {
+                        constexpr auto op(O::addIntRVCVToS);
+                        loadRV(X64::rax, SSVVM_OPERAND(0));
+                        e.addImm(X64::rax, SSVVM_OPERAND(1));
+                        pushReg(X64::rax);
+                        break;
+                    }
+                    case O::subtractIntRVCVToS:
+                    {
+                        constexpr auto op(O::subtractIntRVCVToS);
+                        loadRV(X64::rax, SSVVM_OPERAND(0));
+                        e.subImm(X64::rax, SSVVM_OPERAND(1));
+                        pushReg(X64::rax);
+                        break;
+                    }
+                    case O::addIntRVSVToR:
+                    {
+                        constexpr auto op(O::addIntRVSVToR);
+                        e.subImm64(top, slot);
+                        loadRV(X64::rax, SSVVM_OPERAND(1));
+                        e.opMem({0x03}, X64::rax, top, 0);
+                        storeRV(SSVVM_OPERAND(0), X64::rax);
+                        break;
+                    }
+                    case O::goToPIIfCompareIntRVIntCVGreater:
+                    case O::goToPIIfCompareIntRVIntCVSmaller:
+                    case O::goToPIIfCompareIntRVIntCVEqual:
+                    {
+                        // Same layout for the three opcodes
+                        constexpr auto op(O::goToPIIfCompareIntRVIntCVEqual);
+                        loadRV(X64::rax, SSVVM_OPERAND(2));
+                        e.subImm(X64::rax, SSVVM_OPERAND(3));
+                        storeRV(SSVVM_OPERAND(1), X64::rax);
+                        e.test(X64::rax);
+                        condJump(getCondition(opCode), SSVVM_OPERAND(0), next);
+                        return false;
+                    }
+                }
+
+#undef SSVVM_OPERAND
+
+                return true;
+            }
+
+            inline void emitPrologue()
+            {
+                for(const auto& r : {state, regs, top, base}) e.push(r);
+
+                e.movReg64(state, X64::rdi);
+                e.movLoad(regs, state, offsetof(JITState, registers), true);
+                e.movLoad(top, state, offsetof(JITState, top), true);
+                e.movLoad(base, state, offsetof(JITState, base), true);
+                e.jmpReg(X64::rsi);
+
+                epiloguePos = e.getPos();
+                e.movStore(state, offsetof(JITState, top), top, true);
+                for(const auto& r : {base, top, regs, state}) e.pop(r);
+                e.ret();
+            }
+
+        public:
+            inline JITCompiler(const Program& mProgram,
+                const std::vector<BoundFunction>& mNatives)
+                : program(mProgram), natives(mNatives)
+            {
+            }
+
+            // Compiles the function starting at `mEntry`, registering the
+            // native address of each of its instructions in `mEntries`
+            inline bool compile(Instruction::Idx mEntry,
+                std::vector<JITEntry>& mEntries, std::vector<JITCode>& mCodes)
+            {
+                findFunction(mEntry);
+                emitPrologue();
+
+                for(auto i(0u); i < offsets.size(); ++i)
+                {
+                    const auto& offset(offsets[i]);
+                    labels[offset] = e.getPos();
+
+                    if(!emitInstruction(offset)) continue;
+
+                    // Fall through, unless the next instruction is emitted
+                    // right after this one
+                    const auto& next(Instruction::Idx(offset +
+                        lookupInstructionSize(program.getOpCode(offset))));
+                    if(i + 1 == offsets.size() || offsets[i + 1] != next)
+                        emitJump(next);
+                }
+
+                for(const auto& j : jumps) e.patch(j.first, labels[j.second]);
+
+                std::unordered_map<Instruction::Idx, std::size_t> stubs;
+                for(const auto& x : exits)
+                {
+                    if(stubs.count(x.second) == 0)
+                    {
+                        stubs[x.second] = e.getPos();
+                        emitExit(x.second);
+                    }
+
+                    e.patch(x.first, stubs[x.second]);
+                }
+
+                JITCode code;
+                if(!code.load(e.getCode())) return false;
+
+                const auto& data(code.getData());
+                const auto& fn(reinterpret_cast<JITFnPtr>(data));
+
+                for(const auto& l : labels)
+                    mEntries[l.first] = {fn, data + l.second};
+
+                mCodes.emplace_back(std::move(code));
+                return true;
+            }
+        };
+    }
+
+    // Baseline template JIT for verified, untagged programs. Functions
+    // (`callPI` targets) are compiled once they have been called
+    // `threshold` times; the interpreter enters compiled code on calls and
+    // returns, and handles `callPI`, `returnPI` and `halt` itself.
+    template <>
+    class JIT<RawValue>
+    {
+    private:
+        std::vector<Impl::JITEntry> entries;
+        std::vector<std::uint32_t> callCounts;
+        std::vector<Impl::JITCode> codes;
+        std::size_t threshold{0};
+
+    public:
+        inline void reset(const Program& mProgram)
+        {
+            entries.assign(mProgram.getByteSize(), {});
+            callCounts.assign(mProgram.getByteSize(), 0);
+            codes.clear();
+        }
+
+        // A threshold of 0 disables the JIT
+        inline void enable(std::size_t mThreshold) noexcept
+        {
+            threshold = mThreshold;
+        }
+        inline bool isEnabled() const noexcept { return threshold > 0; }
+
+        inline void countCall(const Program& mProgram,
+            const std::vector<BoundFunction>& mNatives,
+            Instruction::Idx mTarget)
+        {
+            if(++callCounts[mTarget] != threshold) return;
+
+            SSVU_ASSERT(mProgram.isVerified());
+            Impl::JITCompiler{mProgram, mNatives}.compile(
+                mTarget, entries, codes);
+        }
+
+        inline const void* getEntry(Instruction::Idx mOffset) const noexcept
+        {
+            return entries[mOffset].fn != nullptr ? &entries[mOffset]
+                                                  : nullptr;
+        }
+
+        // Runs compiled code from `mEntry` (returned by `getEntry`) and
+        // returns the offset the interpreter has to resume from
+        template <typename TRegistry, typename TStack>
+        inline Instruction::Idx run(
+            const void* mEntry, TRegistry& mRegistry, TStack& mStack) noexcept
+        {
+            const auto& entry(*static_cast<const Impl::JITEntry*>(mEntry));
+            Impl::JITState state{
+                mRegistry.getData(), mStack.getTopPtr(), mStack.getBasePtr()};
+
+            const auto& result(entry.fn(&state, entry.target));
+            mStack.setTopPtr(state.top);
+            return result;
+        }
+    };
+#endif
+}
+
+#endif
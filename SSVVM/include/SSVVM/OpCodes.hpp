@@ -20,35 +20,48 @@ namespace ssvvm
         static VMFnPtr<T> fnPtrs[]{VRM_PP_FOREACH_REVERSE(             \
             SSVVM_CREATE_MFPTR, VRM_PP_EMPTY(), __VA_ARGS__)};         \
         return fnPtrs[std::size_t(mOpCode)];                           \
-    }
-
-    SSVVM_CREATE_OPCODE_DATABASE(
-        // Virtual machine control
-        halt,
-
-        // Register instructions
-        loadIntCVToR, loadFloatCVToR, moveRVToR,
-
-        // Register-stack instructions
-        pushRVToS, popSVToR, moveSBOVToR,
-
-        // Stack instructions
-        pushIntCVToS, pushFloatCVToS, pushSVToS, popSV,
-
-        // Program logic
-        goToPI, goToPIIfIntRV, goToPIIfCompareRVGreater,
-        goToPIIfCompareRVSmaller, goToPIIfCompareRVEqual, callPI, returnPI,
-
-        // Register basic arithmetic
-        incrementIntRV, decrementIntRV,
+    }                                                                  \
+    static constexpr std::size_t opCodeCount{                          \
+        VRM_PP_ARGCOUNT(__VA_ARGS__)};
 
-        // Stack basic arithmetic
-        addInt2SVs, addFloat2SVs, subtractInt2SVs, subtractFloat2SVs,
-        multiplyInt2SVs, multiplyFloat2SVs, divideInt2SVs, divideFloat2SVs,
+// Every opcode, in order. Kept as a list macro so that the dispatch tables
+// of the different execution modes can be generated from the same source.
+#define SSVVM_OPCODE_LIST                                                   \
+    /* Virtual machine control */                                           \
+    halt,                                                                   \
+                                                                            \
+    /* Register instructions */                                             \
+    loadIntCVToR, loadFloatCVToR, moveRVToR,                                \
+                                                                            \
+    /* Register-stack instructions */                                       \
+    pushRVToS, popSVToR, moveSBOVToR,                                       \
+                                                                            \
+    /* Stack instructions */                                                \
+    pushIntCVToS, pushFloatCVToS, pushSVToS, popSV,                         \
+                                                                            \
+    /* Program logic */                                                     \
+    goToPI, goToPIIfIntRV, goToPIIfCompareRVGreater,                        \
+    goToPIIfCompareRVSmaller, goToPIIfCompareRVEqual, callPI, returnPI,     \
+    callNative,                                                             \
+                                                                            \
+    /* Register basic arithmetic */                                         \
+    incrementIntRV, decrementIntRV, multiplyIntRVRVToR, divideIntRVRVToR,   \
+    moduloIntRVRVToR,                                                       \
+                                                                            \
+    /* Stack basic arithmetic */                                            \
+    addInt2SVs, addFloat2SVs, subtractInt2SVs, subtractFloat2SVs,           \
+    multiplyInt2SVs, multiplyFloat2SVs, divideInt2SVs, divideFloat2SVs,     \
+                                                                            \
+    /* Comparisons */                                                       \
+    compareIntRVIntRVToR, compareIntRVIntSVToR, compareIntSVIntSVToR,       \
+    compareIntRVIntCVToR, compareIntSVIntCVToR,                             \
+                                                                            \
+    /* Superinstructions (emitted by `getOptimizedProgram`) */              \
+    addIntRVRVToR, subtractIntRVRVToR, addIntRVCVToS, subtractIntRVCVToS,   \
+    addIntRVSVToR, goToPIIfCompareIntRVIntCVGreater,                        \
+    goToPIIfCompareIntRVIntCVSmaller, goToPIIfCompareIntRVIntCVEqual
 
-        // Comparisons
-        compareIntRVIntRVToR, compareIntRVIntSVToR, compareIntSVIntSVToR,
-        compareIntRVIntCVToR, compareIntSVIntCVToR)
+    SSVVM_CREATE_OPCODE_DATABASE(SSVVM_OPCODE_LIST)
 
     inline const std::string& getOpCodeStr(OpCode mOpCode) noexcept
     {
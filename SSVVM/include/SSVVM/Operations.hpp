@@ -17,40 +17,55 @@ namespace ssvvm
                    mB.getType() == getVMVal<T>();
         }
 
-    public:
+        // Untagged values can only come from verified programs
         template <typename T>
-        inline static Value getAddition(
-            const Value& mA, const Value& mB) noexcept
+        inline static bool isValid(const RawValue&, const RawValue&) noexcept
+        {
+            return true;
+        }
+
+    public:
+        template <typename T, typename TValue = Value>
+        inline static TValue getAddition(
+            const TValue& mA, const TValue& mB) noexcept
         {
             SSVU_ASSERT(isValid<T>(mA, mB));
-            return {mA.get<T>() + mB.get<T>()};
+            return {mA.template get<T>() + mB.template get<T>()};
         }
-        template <typename T>
-        inline static Value getSubtraction(
-            const Value& mA, const Value& mB) noexcept
+        template <typename T, typename TValue = Value>
+        inline static TValue getSubtraction(
+            const TValue& mA, const TValue& mB) noexcept
         {
             SSVU_ASSERT(isValid<T>(mA, mB));
-            return {mA.get<T>() - mB.get<T>()};
+            return {mA.template get<T>() - mB.template get<T>()};
         }
-        template <typename T>
-        inline static Value getMultiplication(
-            const Value& mA, const Value& mB) noexcept
+        template <typename T, typename TValue = Value>
+        inline static TValue getMultiplication(
+            const TValue& mA, const TValue& mB) noexcept
         {
             SSVU_ASSERT(isValid<T>(mA, mB));
-            return {mA.get<T>() * mB.get<T>()};
+            return {mA.template get<T>() * mB.template get<T>()};
         }
-        template <typename T>
-        inline static Value getDivision(
-            const Value& mA, const Value& mB) noexcept
+        template <typename T, typename TValue = Value>
+        inline static TValue getDivision(
+            const TValue& mA, const TValue& mB) noexcept
+        {
+            SSVU_ASSERT(isValid<T>(mA, mB) && mB.template get<T>() != T(0));
+            return {mA.template get<T>() / mB.template get<T>()};
+        }
+        template <typename T, typename TValue = Value>
+        inline static TValue getModulo(
+            const TValue& mA, const TValue& mB) noexcept
         {
-            SSVU_ASSERT(isValid<T>(mA, mB) && mB.get<T>() != T(0));
-            return {mA.get<T>() / mB.get<T>()};
+            SSVU_ASSERT(isValid<T>(mA, mB) && mB.template get<T>() != T(0));
+            return {mA.template get<T>() % mB.template get<T>()};
         }
 
-        inline static Value getIntComparison(
-            const Value& mA, const Value& mB) noexcept
+        template <typename TValue = Value>
+        inline static TValue getIntComparison(
+            const TValue& mA, const TValue& mB) noexcept
         {
-            return getSubtraction<int>(mA, mB);
+            return getSubtraction<int, TValue>(mA, mB);
         }
     };
 }
@@ -0,0 +1,205 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVVM_OPTIMIZER
+#define SSVVM_OPTIMIZER
+
+namespace ssvvm
+{
+    namespace Impl
+    {
+        // Peephole pass that fuses common instruction sequences into
+        // superinstructions. Sequences are never fused across a jump target,
+        // so every target still lands on the first instruction of a group.
+        class Peephole
+        {
+        private:
+            const std::vector<Instruction>& source;
+            std::vector<bool> targets;
+
+            inline int getParam(std::size_t mIdx, std::size_t mParam) const
+            {
+                return source[mIdx].params[mParam].template get<int>();
+            }
+
+            inline bool matches(
+                std::size_t mIdx, std::initializer_list<OpCode> mOpCodes) const
+            {
+                if(mIdx + mOpCodes.size() > source.size()) return false;
+
+                std::size_t i{mIdx};
+                for(const auto& o : mOpCodes)
+                {
+                    if(source[i].opCode != o) return false;
+                    if(i != mIdx && targets[i]) return false;
+                    ++i;
+                }
+
+                return true;
+            }
+
+            // `pushRVToS(b); pushRVToS(a); op; popSVToR(d)` -> `d = a op b`
+            inline bool fuseIntRVRVToR(std::size_t mIdx, OpCode mStackOp,
+                OpCode mFused, Instruction& mOut) const
+            {
+                if(!matches(mIdx, {OpCode::pushRVToS, OpCode::pushRVToS,
+                                      mStackOp, OpCode::popSVToR}))
+                    return false;
+
+                mOut = {mFused, {getParam(mIdx + 3, 0), getParam(mIdx + 1, 0),
+                                    getParam(mIdx, 0)}};
+                return true;
+            }
+
+            // `pushIntCVToS(c); pushRVToS(a); op` -> push `a op c`
+            inline bool fuseIntRVCVToS(std::size_t mIdx, OpCode mStackOp,
+                OpCode mFused, Instruction& mOut) const
+            {
+                if(!matches(mIdx,
+                       {OpCode::pushIntCVToS, OpCode::pushRVToS, mStackOp}))
+                    return false;
+
+                mOut = {mFused, {getParam(mIdx + 1, 0), getParam(mIdx, 0)}};
+                return true;
+            }
+
+            // `compareIntRVIntCVToR(d, a, c); goToPIIfCompareRVX(t, d)` ->
+            // compare into `d` and branch
+            inline bool fuseCompareBranch(std::size_t mIdx, OpCode mBranch,
+                OpCode mFused, Instruction& mOut) const
+            {
+                if(!matches(mIdx, {OpCode::compareIntRVIntCVToR, mBranch}) ||
+                    getParam(mIdx, 0) != getParam(mIdx + 1, 1))
+                    return false;
+
+                mOut = {mFused, {getParam(mIdx + 1, 0), getParam(mIdx, 0),
+                                    getParam(mIdx, 1), getParam(mIdx, 2)}};
+                return true;
+            }
+
+            // Returns the number of source instructions replaced by `mOut`,
+            // or 0 if no sequence starts at `mIdx`
+            inline std::size_t fuse(std::size_t mIdx, Instruction& mOut) const
+            {
+                using O = OpCode;
+
+                if(fuseIntRVRVToR(mIdx, O::addInt2SVs, O::addIntRVRVToR, mOut))
+                    return 4;
+                if(fuseIntRVRVToR(
+                       mIdx, O::subtractInt2SVs, O::subtractIntRVRVToR, mOut))
+                    return 4;
+
+                if(fuseIntRVCVToS(mIdx, O::addInt2SVs, O::addIntRVCVToS, mOut))
+                    return 3;
+                if(fuseIntRVCVToS(
+                       mIdx, O::subtractInt2SVs, O::subtractIntRVCVToS, mOut))
+                    return 3;
+
+                // `pushRVToS(a); addInt2SVs; popSVToR(d)` -> `d = a + pop`
+                if(matches(mIdx, {O::pushRVToS, O::addInt2SVs, O::popSVToR}))
+                {
+                    mOut = {O::addIntRVSVToR,
+                        {getParam(mIdx + 2, 0), getParam(mIdx, 0)}};
+                    return 3;
+                }
+
+                if(fuseCompareBranch(mIdx, O::goToPIIfCompareRVGreater,
+                       O::goToPIIfCompareIntRVIntCVGreater, mOut) ||
+                    fuseCompareBranch(mIdx, O::goToPIIfCompareRVSmaller,
+                        O::goToPIIfCompareIntRVIntCVSmaller, mOut) ||
+                    fuseCompareBranch(mIdx, O::goToPIIfCompareRVEqual,
+                        O::goToPIIfCompareIntRVIntCVEqual, mOut))
+                    return 2;
+
+                return 0;
+            }
+
+            inline static bool isTargetOperand(
+                const OperandLayout& mLayout, std::size_t mIdx) noexcept
+            {
+                return mLayout.operands[mIdx] == Operand::Target;
+            }
+
+        public:
+            inline Peephole(const std::vector<Instruction>& mSource)
+                : source(mSource), targets(mSource.size() + 1, false)
+            {
+                for(auto i(0u); i < source.size(); ++i)
+                {
+                    const auto& layout(getOperandLayout(source[i].opCode));
+                    for(auto k(0u); k < layout.getCount(); ++k)
+                        if(isTargetOperand(layout, k))
+                            targets[getParam(i, k)] = true;
+
+                    // Return address
+                    if(source[i].opCode == OpCode::callPI)
+                        targets[i + 1] = true;
+                }
+            }
+
+            inline std::vector<Instruction> run() const
+            {
+                std::vector<Instruction> result;
+                std::vector<Instruction::Idx> remap(source.size() + 1);
+
+                std::size_t idx{0};
+                while(idx < source.size())
+                {
+                    Instruction fused;
+                    const auto& count(fuse(idx, fused));
+
+                    remap[idx] = result.size();
+
+                    if(count == 0)
+                    {
+                        result.emplace_back(source[idx]);
+                        ++idx;
+                        continue;
+                    }
+
+                    result.emplace_back(fused);
+                    idx += count;
+                }
+
+                remap[source.size()] = result.size();
+
+                for(auto& i : result)
+                {
+                    const auto& layout(getOperandLayout(i.opCode));
+                    for(auto k(0u); k < layout.getCount(); ++k)
+                        if(isTargetOperand(layout, k))
+                            i.params[k] = Value::create<int>(
+                                remap[i.params[k].template get<int>()]);
+                }
+
+                return result;
+            }
+        };
+    }
+
+    // Returns a copy of `mProgram` with common instruction sequences fused
+    // into superinstructions. The result is not verified, even if
+    // `mProgram` was.
+    template <bool TDebug>
+    inline Program getOptimizedProgram(const Program& mProgram)
+    {
+        const auto& instructions(mProgram.toInstructions());
+        auto result(Program::fromInstructions(
+            Impl::Peephole{instructions}.run()));
+
+        if(mProgram.hasStackFrameSize())
+            result.setStackFrameSize(mProgram.getStackFrameSize());
+
+        if(TDebug)
+            ssvu::lo("optimizer") << "Instructions: "
+                                  << mProgram.getInstructionCount() << " -> "
+                                  << result.getInstructionCount()
+                                  << " | bytes: " << mProgram.getByteSize()
+                                  << " -> " << result.getByteSize() << "\n";
+
+        return result;
+    }
+}
+
+#endif
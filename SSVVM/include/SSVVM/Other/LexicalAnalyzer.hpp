@@ -13,31 +13,50 @@ namespace ssvut
     public:
         using LAFSM = LexicalFSM<LexicalAnalyzer<TTType, TTData>>;
 
+        // Span of the source - valid until the source is replaced. The
+        // contents are only copied on request.
         struct Token : public TTData
         {
             TTType type;
-            std::string contents;
+            const char* begin;
+            std::size_t size;
 
-            inline Token(TTType mType, std::string mContents)
-                : type{mType}, contents{std::move(mContents)}
+            inline Token(TTType mType, const char* mBegin,
+                std::size_t mSize) noexcept : type{mType},
+                                              begin{mBegin},
+                                              size{mSize}
             {
             }
+
+            inline std::string getContents() const
+            {
+                return {begin, size};
+            }
+            inline bool is(const std::string& mStr) const noexcept
+            {
+                return size == mStr.size() &&
+                       std::memcmp(begin, mStr.data(), size) == 0;
+            }
         };
 
     private:
         std::map<TTType, LAFSM> matches;
         std::vector<Token> tokens;
-        std::string source;
+        std::string ownedSource;
+        const char* source{nullptr};
+        std::size_t sourceSize{0};
         std::size_t markerBegin, markerEnd, nextEnd;
 
+        // All the FSMs compiled together, rebuilt by `tokenize` after
+        // `createMatchFSM` is called
+        LexicalDFA<TTType> dfa;
+        bool dfaDirty{true};
+
         inline void advance() noexcept { markerEnd = nextEnd; }
         inline void consume(TTType mType)
         {
-            const auto& tokenContents(
-                source.substr(markerBegin, markerEnd - markerBegin));
-            // ssvu::lo() << tokenContents << "\n";
-
-            tokens.emplace_back(mType, tokenContents);
+            tokens.emplace_back(
+                mType, source + markerBegin, markerEnd - markerBegin);
             markerBegin = markerEnd;
         }
 
@@ -45,26 +64,38 @@ namespace ssvut
         inline LAFSM& createMatchFSM(TTType mVMToken)
         {
             SSVU_ASSERT(matches.count(mVMToken) == 0);
+            dfaDirty = true;
             matches.insert(std::make_pair(mVMToken, LAFSM{*this}));
             return matches.at(mVMToken);
         }
 
         inline void setSource(std::string mSource)
         {
-            source = std::move(mSource);
+            ownedSource = std::move(mSource);
+            source = ownedSource.data();
+            sourceSize = ownedSource.size();
+        }
+
+        // Tokenizes `mSize` bytes at `mData` in place - e.g. a mapped file -
+        // which must outlive the tokens
+        inline void setSource(const char* mData, std::size_t mSize)
+        {
+            ownedSource.clear();
+            source = mData;
+            sourceSize = mSize;
         }
 
         inline char getMatchChar()
         {
             nextEnd = markerEnd + 1;
-            return source[markerEnd];
+            return markerEnd < sourceSize ? source[markerEnd] : '\0';
         }
         inline bool match(const std::string& mMatch /*, bool mConsume = true*/)
         {
             for(auto i(0u); i < mMatch.size(); ++i)
             {
                 auto idxToCheck(markerEnd + i);
-                if(idxToCheck >= source.size() ||
+                if(idxToCheck >= sourceSize ||
                     source[idxToCheck] != mMatch[i])
                     return false;
             }
@@ -74,16 +105,60 @@ namespace ssvut
         }
         inline bool matchAnything()
         {
+            if(markerEnd >= sourceSize) return false;
             nextEnd = markerEnd + 1;
             return true;
         }
 
+        inline void buildDFA()
+        {
+            std::vector<std::pair<TTType, const LexicalPattern*>> patterns;
+            for(const auto& p : matches)
+                patterns.emplace_back(p.first, &p.second.getPattern());
+
+            dfa.build(patterns);
+            dfaDirty = false;
+        }
+
+        // Splits the source into the longest tokens matched by the DFA. On
+        // equal lengths, the token type that compares lower wins.
         inline void tokenize()
         {
+            if(dfaDirty) buildDFA();
+
             tokens.clear();
             markerBegin = markerEnd = nextEnd = 0;
 
-            while(markerEnd < source.size())
+            const auto& end(source + sourceSize);
+            while(markerBegin < sourceSize)
+            {
+                TTType foundType{};
+                const auto& length(
+                    dfa.match(source + markerBegin, end, foundType));
+
+                if(length == 0)
+                {
+                    const auto& lineEnd(std::find(source + markerBegin, end,
+                        '\n'));
+                    ssvu::lo() << "didn't find any match\n"
+                               << std::string(source + markerBegin, lineEnd)
+                               << std::endl;
+                    throw;
+                }
+
+                markerEnd = markerBegin + length;
+                consume(foundType);
+            }
+        }
+
+        // Reference implementation running every FSM in turn - much slower
+        // than `tokenize`, kept to check the DFA against
+        inline void tokenizeWithFSMs()
+        {
+            tokens.clear();
+            markerBegin = markerEnd = nextEnd = 0;
+
+            while(markerEnd < sourceSize)
             {
                 bool canConsume{false};
                 TTType foundType{};
@@ -102,9 +177,6 @@ namespace ssvut
                           LAFSM::getNodeNull())
                     {
                         advance();
-                        // ssvu::lo() << source.substr(markerBegin, nextEnd -
-                        // markerBegin) << "\n";
-
                         fsm.setCurrentState(nextNode);
                         if(fsm.getCurrentState()->isTerminal())
                         {
@@ -123,7 +195,8 @@ namespace ssvut
                 if(canConsume) continue;
 
                 ssvu::lo() << "didn't find any match\n"
-                           << source.substr(markerBegin, nextEnd - markerBegin)
+                           << std::string(source + markerBegin,
+                                  source + std::min(nextEnd, sourceSize))
                            << std::endl;
                 throw;
             }
@@ -133,6 +206,15 @@ namespace ssvut
         {
             return tokens;
         }
+        inline std::size_t getOffset(const Token& mToken) const noexcept
+        {
+            return mToken.begin - source;
+        }
+        inline const LexicalDFA<TTType>& getDFA()
+        {
+            if(dfaDirty) buildDFA();
+            return dfa;
+        }
     };
 }
 
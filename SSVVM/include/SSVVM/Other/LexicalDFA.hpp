@@ -0,0 +1,354 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef OB_TESTING_OTHER_LEXICALDFA
+#define OB_TESTING_OTHER_LEXICALDFA
+
+namespace ssvut
+{
+    using ByteSet = std::bitset<256>;
+
+    // What a `LexicalFSM` transition matches, kept alongside its rule so that
+    // the FSM can be compiled: either a whole string or a single byte out of
+    // a set
+    struct LexicalPatternLink
+    {
+        std::size_t target;
+        std::string str; // Empty for byte sets
+        ByteSet bytes;
+
+        inline static LexicalPatternLink fromStr(std::string mStr)
+        {
+            return {0, std::move(mStr), {}};
+        }
+        template <typename TF>
+        inline static LexicalPatternLink fromFunc(const TF& mFunc)
+        {
+            LexicalPatternLink result{0, {}, {}};
+            for(auto b(0u); b < 256; ++b) result.bytes[b] = mFunc(char(b));
+            return result;
+        }
+        inline static LexicalPatternLink anything()
+        {
+            return {0, {}, ByteSet{}.set()};
+        }
+    };
+
+    // Mirror of the nodes of a `LexicalFSM`, in creation order - node 0 is
+    // the start state. Links are listed in the order the FSM tries them.
+    // The `continue*` functions build the same nodes as their `FSM`
+    // counterparts.
+    struct LexicalPattern
+    {
+        struct Node
+        {
+            bool terminal;
+            std::vector<LexicalPatternLink> links;
+        };
+
+        std::vector<Node> nodes{{false, {}}};
+
+        inline std::size_t createNode(bool mTerminal)
+        {
+            nodes.push_back({mTerminal, {}});
+            return nodes.size() - 1;
+        }
+        inline void linkTo(std::size_t mFrom, std::size_t mTo,
+            LexicalPatternLink mLink)
+        {
+            mLink.target = mTo;
+            nodes[mFrom].links.emplace_back(std::move(mLink));
+        }
+
+        inline void continueOnce(const LexicalPatternLink& mLink,
+            bool mTerminal)
+        {
+            const auto last(nodes.size() - 1);
+            const auto state(createNode(mTerminal));
+
+            linkTo(last, state, mLink);
+        }
+        inline void continueRepeat(const LexicalPatternLink& mLink,
+            bool mTerminal)
+        {
+            const auto last(nodes.size() - 1);
+            const auto state(createNode(mTerminal));
+
+            linkTo(state, state, mLink);
+            linkTo(last, state, mLink);
+        }
+        inline void continueRepeatUntilOnce(const LexicalPatternLink& mLoop,
+            bool mLoopTerminal, const LexicalPatternLink& mEnd,
+            bool mEndTerminal)
+        {
+            const auto last(nodes.size() - 1);
+            const auto stateEnd(createNode(mEndTerminal));
+            const auto stateLoop(createNode(mLoopTerminal));
+
+            linkTo(stateLoop, stateEnd, mEnd);
+            linkTo(stateLoop, stateLoop, mLoop);
+            linkTo(last, stateEnd, mEnd);
+            linkTo(last, stateLoop, mLoop);
+        }
+    };
+
+    // Deterministic automaton recognizing every token type of a lexical
+    // analyzer at once. Transitions are stored in a single table indexed by
+    // state and byte class (bytes that behave identically in every state
+    // share a class). `match` returns the longest token starting at a given
+    // position; on equal lengths the type registered first wins.
+    template <typename TTType>
+    class LexicalDFA
+    {
+    public:
+        using State = std::uint32_t;
+        static constexpr State deadState{0};
+
+    private:
+        // Byte-level DFA of a single pattern, -1 being the dead state
+        struct ByteDFA
+        {
+            std::vector<std::array<int, 256>> next;
+            std::vector<bool> terminal;
+
+            inline int addState(bool mTerminal)
+            {
+                std::array<int, 256> dead;
+                dead.fill(-1);
+
+                next.emplace_back(dead);
+                terminal.emplace_back(mTerminal);
+                return next.size() - 1;
+            }
+        };
+
+        std::array<std::uint8_t, 256> byteClasses;
+        std::size_t classCount{0};
+        std::vector<State> table;
+        std::vector<int> accepts; // Index in `types`, -1 if not accepting
+        std::vector<TTType> types;
+        State startState{deadState};
+
+        // Every byte is handled by the first link of a node that can match
+        // it, as the FSM tries links in order. Strings become chains of
+        // states; a string is only reachable through bytes that no earlier
+        // link of the same node matches.
+        inline static ByteDFA getByteDFA(const LexicalPattern& mPattern)
+        {
+            ByteDFA result;
+            for(const auto& n : mPattern.nodes) result.addState(n.terminal);
+
+            for(auto i(0u); i < mPattern.nodes.size(); ++i)
+            {
+                ByteSet claimed;
+
+                for(const auto& l : mPattern.nodes[i].links)
+                {
+                    if(l.str.empty())
+                    {
+                        for(auto b(0u); b < 256; ++b)
+                            if(l.bytes[b] && !claimed[b])
+                            {
+                                claimed[b] = true;
+                                result.next[i][b] = l.target;
+                            }
+
+                        continue;
+                    }
+
+                    const auto& first(std::uint8_t(l.str[0]));
+                    if(claimed[first]) continue;
+                    claimed[first] = true;
+
+                    int from(i);
+                    for(auto k(0u); k < l.str.size(); ++k)
+                    {
+                        const auto& to(k + 1 == l.str.size()
+                                           ? int(l.target)
+                                           : result.addState(false));
+                        result.next[from][std::uint8_t(l.str[k])] = to;
+                        from = to;
+                    }
+                }
+            }
+
+            return result;
+        }
+
+        // Runs all the byte DFAs in lockstep: every combined state is the
+        // tuple of their current states
+        inline void buildProduct(const std::vector<ByteDFA>& mDFAs,
+            std::vector<std::array<State, 256>>& mNext)
+        {
+            std::map<std::vector<int>, State> ids;
+            std::vector<std::vector<int>> tuples;
+
+            auto getId([&](const std::vector<int>& mTuple)
+                {
+                    auto itr(ids.find(mTuple));
+                    if(itr != std::end(ids)) return itr->second;
+
+                    int accept{-1};
+                    for(auto i(0u); i < mTuple.size() && accept < 0; ++i)
+                        if(mTuple[i] >= 0 && mDFAs[i].terminal[mTuple[i]])
+                            accept = i;
+
+                    const State id(tuples.size());
+                    ids.emplace(mTuple, id);
+                    tuples.emplace_back(mTuple);
+                    accepts.emplace_back(accept);
+                    return id;
+                });
+
+            getId(std::vector<int>(mDFAs.size(), -1)); // Dead state
+            startState = getId(std::vector<int>(mDFAs.size(), 0));
+
+            for(State s{0}; s < tuples.size(); ++s)
+            {
+                std::array<State, 256> next;
+
+                for(auto b(0u); b < 256; ++b)
+                {
+                    std::vector<int> tuple(mDFAs.size(), -1);
+                    for(auto i(0u); i < mDFAs.size(); ++i)
+                        if(tuples[s][i] >= 0)
+                            tuple[i] = mDFAs[i].next[tuples[s][i]][b];
+
+                    next[b] = getId(tuple);
+                }
+
+                mNext.emplace_back(next);
+            }
+        }
+
+        // Moore partition refinement: states stay together while they
+        // accept the same type and move to the same groups on every byte
+        inline void minimize(std::vector<std::array<State, 256>>& mNext)
+        {
+            std::vector<State> group(mNext.size());
+            std::size_t groupCount{0};
+
+            while(true)
+            {
+                std::map<std::vector<std::int64_t>, State> signatures;
+                std::vector<State> refined(mNext.size());
+
+                for(State s{0}; s < mNext.size(); ++s)
+                {
+                    std::vector<std::int64_t> signature{accepts[s], group[s]};
+                    for(const auto& n : mNext[s])
+                        signature.emplace_back(group[n]);
+
+                    auto itr(signatures.emplace(signature, signatures.size()));
+                    refined[s] = itr.first->second;
+                }
+
+                group = std::move(refined);
+                if(signatures.size() == groupCount) break;
+                groupCount = signatures.size();
+            }
+
+            // Keep the dead state first
+            std::vector<State> order(groupCount, State(-1));
+            State count{0};
+            for(State s{0}; s < mNext.size(); ++s)
+                if(order[group[s]] == State(-1)) order[group[s]] = count++;
+
+            std::vector<std::array<State, 256>> next(groupCount);
+            std::vector<int> groupAccepts(groupCount);
+
+            for(State s{0}; s < mNext.size(); ++s)
+            {
+                const auto& g(order[group[s]]);
+                groupAccepts[g] = accepts[s];
+                for(auto b(0u); b < 256; ++b)
+                    next[g][b] = order[group[mNext[s][b]]];
+            }
+
+            startState = order[group[startState]];
+            accepts = std::move(groupAccepts);
+            mNext = std::move(next);
+        }
+
+        inline void buildTable(const std::vector<std::array<State, 256>>& mNext)
+        {
+            std::map<std::vector<State>, std::uint8_t> columns;
+            std::vector<std::uint8_t> representatives;
+
+            for(auto b(0u); b < 256; ++b)
+            {
+                std::vector<State> column;
+                for(const auto& n : mNext) column.emplace_back(n[b]);
+
+                auto itr(columns.emplace(column, columns.size()));
+                if(itr.second) representatives.emplace_back(b);
+                byteClasses[b] = itr.first->second;
+            }
+
+            classCount = representatives.size();
+            table.resize(mNext.size() * classCount);
+
+            for(State s{0}; s < mNext.size(); ++s)
+                for(auto c(0u); c < classCount; ++c)
+                    table[s * classCount + c] = mNext[s][representatives[c]];
+        }
+
+    public:
+        // `mPatterns` in priority order
+        inline void build(
+            const std::vector<std::pair<TTType, const LexicalPattern*>>&
+                mPatterns)
+        {
+            std::vector<ByteDFA> dfas;
+            types.clear();
+            accepts.clear();
+
+            for(const auto& p : mPatterns)
+            {
+                types.emplace_back(p.first);
+                dfas.emplace_back(getByteDFA(*p.second));
+            }
+
+            std::vector<std::array<State, 256>> next;
+            buildProduct(dfas, next);
+            minimize(next);
+            buildTable(next);
+        }
+
+        // Returns the length of the longest token starting at `mBegin`, or 0
+        // if there is none
+        inline std::size_t match(const char* mBegin, const char* mEnd,
+            TTType& mType) const noexcept
+        {
+            std::size_t result{0};
+            auto state(startState);
+
+            for(auto itr(mBegin); itr != mEnd; ++itr)
+            {
+                state = table[state * classCount +
+                              byteClasses[std::uint8_t(*itr)]];
+                if(state == deadState) break;
+
+                if(accepts[state] >= 0)
+                {
+                    result = itr - mBegin + 1;
+                    mType = types[accepts[state]];
+                }
+            }
+
+            return result;
+        }
+
+        inline std::size_t getStateCount() const noexcept
+        {
+            return accepts.size();
+        }
+        inline std::size_t getClassCount() const noexcept
+        {
+            return classCount;
+        }
+    };
+}
+
+#endif
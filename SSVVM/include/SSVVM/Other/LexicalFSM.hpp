@@ -13,6 +13,14 @@ namespace ssvut
     private:
         T* la;
 
+        // Symbolic copy of the rules, compiled into the analyzer's DFA
+        LexicalPattern pattern;
+
+        inline static bool isTerminal(NodeType mType) noexcept
+        {
+            return mType == NodeType::Terminal;
+        }
+
     public:
         inline LexicalFSM(T& mLexicalAnalyzer) noexcept : la{&mLexicalAnalyzer}
         {
@@ -26,6 +34,7 @@ namespace ssvut
                     return la->match(mStr);
                 },
                 NodeType::Terminal);
+            pattern.continueOnce(LexicalPatternLink::fromStr(mStr), true);
             return *this;
         }
         inline LexicalFSM& once(const std::string& mStr, NodeType mType)
@@ -36,6 +45,8 @@ namespace ssvut
                     return la->match(mStr);
                 },
                 mType);
+            pattern.continueOnce(
+                LexicalPatternLink::fromStr(mStr), isTerminal(mType));
             return *this;
         }
         inline LexicalFSM& repeat(const std::string& mStr, NodeType mType)
@@ -46,6 +57,8 @@ namespace ssvut
                     return la->match(mStr);
                 },
                 mType);
+            pattern.continueRepeat(
+                LexicalPatternLink::fromStr(mStr), isTerminal(mType));
             return *this;
         }
 
@@ -58,6 +71,8 @@ namespace ssvut
                     return mFunc(la->getMatchChar());
                 },
                 mType);
+            pattern.continueOnce(
+                LexicalPatternLink::fromFunc(mFunc), isTerminal(mType));
             return *this;
         }
         template <typename TF>
@@ -69,6 +84,8 @@ namespace ssvut
                     return mFunc(la->getMatchChar());
                 },
                 mType);
+            pattern.continueRepeat(
+                LexicalPatternLink::fromFunc(mFunc), isTerminal(mType));
             return *this;
         }
 
@@ -86,8 +103,16 @@ namespace ssvut
                     return la->match(mEndStr);
                 },
                 mEndType);
+            pattern.continueRepeatUntilOnce(LexicalPatternLink::anything(),
+                isTerminal(mLoopType), LexicalPatternLink::fromStr(mEndStr),
+                isTerminal(mEndType));
             return *this;
         }
+
+        inline const LexicalPattern& getPattern() const noexcept
+        {
+            return pattern;
+        }
     };
 }
 
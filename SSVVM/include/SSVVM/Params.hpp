@@ -27,7 +27,7 @@ namespace ssvvm
     class Params
     {
     public:
-        static constexpr std::size_t valueCount{3};
+        static constexpr std::size_t valueCount{4};
 
     private:
         std::array<Value, valueCount> values;
@@ -7,180 +7,261 @@
 
 namespace ssvvm
 {
-    template <bool TDebug>
-    inline void preprocessSourceRaw(SourceVeeAsm& mSource)
+    // Directive-free tokens produced by `preprocessSource`, which can be
+    // assembled without being turned back into text. The tokens point into
+    // `buffers`.
+    struct PreprocessedSource
     {
-        if(mSource.isPreprocessed()) throw;
-
-        getASMLA().setSource(mSource.getSourceString());
-        getASMLA().tokenize();
+        std::vector<ASMLAToken> tokens;
+        std::vector<std::shared_ptr<const std::string>> buffers;
+        std::size_t stackFrameSize{0};
 
-        auto tokens(getASMLA().getTokens());
+        inline std::string toStr() const
+        {
+            std::string result;
+            for(const auto& t : tokens) result.append(t.begin, t.size);
+            return result;
+        }
+    };
 
+    namespace Impl
+    {
+        // Hash map key referring to the contents of a token, so that
+        // lookups do not copy them
+        struct TokenKey
+        {
+            const char* begin;
+            std::size_t size;
 
-        std::string result;
+            inline TokenKey(const ASMLAToken& mToken) noexcept
+                : begin{mToken.begin}, size{mToken.size}
+            {
+            }
 
-        // Helper functions
-        auto matchTypes = [&tokens](
-            std::size_t mIdx, const std::vector<VMToken>& mTypes) -> bool
+            inline bool operator==(const TokenKey& mRhs) const noexcept
+            {
+                return size == mRhs.size &&
+                       std::memcmp(begin, mRhs.begin, size) == 0;
+            }
+        };
+        struct TokenKeyHash
         {
-            std::size_t ub{mIdx + mTypes.size()}, typeIdx{0u};
-            if(ub >= tokens.size()) return false;
-
-            for(auto i(mIdx); i < ub; ++i)
+            inline std::size_t operator()(const TokenKey& mKey) const noexcept
             {
-                const auto& type(mTypes[typeIdx++]);
-                if(type != VMToken::Anything && type != tokens[i].type)
-                    return false;
+                return getFNV1a(mKey.begin, mKey.size);
             }
-            return true;
         };
 
+        template <typename T>
+        using TokenMap = std::unordered_map<TokenKey, T, TokenKeyHash>;
+
+        // Directive patterns, `$name(...);`
+        static constexpr VMToken requirePattern[]{VMToken::PreprocessorStart,
+            VMToken::Identifier, VMToken::ParenthesisRoundOpen,
+            VMToken::Integer, VMToken::ParenthesisRoundClose,
+            VMToken::Semicolon};
+        static constexpr VMToken definePattern[]{VMToken::PreprocessorStart,
+            VMToken::Identifier, VMToken::ParenthesisRoundOpen,
+            VMToken::Identifier, VMToken::Comma, VMToken::Anything,
+            VMToken::ParenthesisRoundClose, VMToken::Semicolon};
+        static constexpr VMToken labelPattern[]{VMToken::PreprocessorStart,
+            VMToken::Identifier, VMToken::ParenthesisRoundOpen,
+            VMToken::Identifier, VMToken::ParenthesisRoundClose,
+            VMToken::Semicolon};
+
+        // Returns the length of the `$mName` directive at `mIdx` if it
+        // matches `mTypes`, 0 otherwise
+        template <std::size_t TN>
+        inline std::size_t matchDirective(
+            const std::vector<ASMLAToken>& mTokens, std::size_t mIdx,
+            const VMToken(&mTypes)[TN], const std::string& mName) noexcept
+        {
+            if(mIdx + TN > mTokens.size()) return 0;
 
+            for(auto i(0u); i < TN; ++i)
+                if(mTypes[i] != VMToken::Anything &&
+                    mTypes[i] != mTokens[mIdx + i].type)
+                    return 0;
 
-        // Phase 0: discard Comment/WhiteSpace tokens
-        ssvu::eraseRemoveIf(tokens, [](const ASMLAToken& mT)
-            {
-                return mT.type == VMToken::WhiteSpace ||
-                       mT.type == VMToken::Comment;
-            });
+            return mTokens[mIdx + 1].is(mName) ? TN : 0;
+        }
+    }
 
+    // Resolves the `$require_registers`, `$require_stack`, `$define` and
+    // `$label` directives in a single pass. Label references are patched
+    // once every label is known, so labels can be used before they are
+    // declared.
+    template <bool TDebug>
+    inline PreprocessedSource preprocessSource(const SourceVeeAsm& mSource)
+    {
+        if(mSource.isPreprocessed()) throw;
 
+        PreprocessedSource result;
+        result.stackFrameSize = mSource.getStackFrameSize();
 
-        // Phase 1: `$require_registers` directive
-        int requireRegisters{-1};
+        const auto& text(
+            std::make_shared<const std::string>(mSource.getSourceString()));
+        result.buffers.emplace_back(text);
 
-        for(auto i(0u); i < tokens.size(); ++i)
-            if(matchTypes(
-                   i, {VMToken::PreprocessorStart, VMToken::Identifier,
-                          VMToken::ParenthesisRoundOpen, VMToken::Integer,
-                          VMToken::ParenthesisRoundClose, VMToken::Semicolon}))
-                if(getTokenContents(tokens, i + 1) == "require_registers")
-                {
-                    requireRegisters = getTokenAsInt(tokens, i + 3);
-                    for(auto k(0u); k < 6; ++k) tokens[i + k].toDel = true;
-                    if(TDebug)
-                        ssvu::lo("makeProgram - phase 1")
-                            << "Found `$require_registers` = "
-                            << requireRegisters << "\n";
-                    break;
-                }
+        getASMLA().setSource(text->data(), text->size());
+        getASMLA().tokenize();
 
-        ssvu::eraseRemoveIf(tokens, [](const ASMLAToken& mT)
-            {
-                return mT.toDel;
-            });
+        // Discard Comment/WhiteSpace tokens
+        std::vector<ASMLAToken> tokens;
+        tokens.reserve(getASMLA().getTokens().size());
+        for(const auto& t : getASMLA().getTokens())
+            if(t.type != VMToken::WhiteSpace && t.type != VMToken::Comment)
+                tokens.emplace_back(t);
 
+        auto& out(result.tokens);
+        out.reserve(tokens.size());
 
-        // for(const auto& t : tokens) ssvu::lo() << t.contents << "\n";
+        int requireRegisters{-1}, requireStack{-1};
+        Impl::TokenMap<ASMLAToken> defines;
 
-        // Phase 2: `$define` directives
-        std::map<std::string, std::string> defines;
-        for(auto i(0u); i < tokens.size(); ++i)
-            if(matchTypes(
-                   i, {VMToken::PreprocessorStart, VMToken::Identifier,
-                          VMToken::ParenthesisRoundOpen, VMToken::Identifier,
-                          VMToken::Comma, VMToken::Anything,
-                          VMToken::ParenthesisRoundClose, VMToken::Semicolon}))
-            {
-                if(getTokenContents(tokens, i + 1) != "define") continue;
+        // Label names and the index of the instruction they precede
+        std::vector<std::pair<ASMLAToken, std::size_t>> labelDecls;
 
-                const auto& alias(getTokenContents(tokens, i + 3));
-                const auto& replacement(getTokenContents(tokens, i + 5));
+        // Identifiers in `out`, which may refer to defines or labels
+        std::vector<std::size_t> identifiers;
 
-                if(TDebug)
-                    ssvu::lo("makeProgram - phase 2")
-                        << "Found `$define`: " << alias << " -> " << replacement
-                        << "\n";
+        std::size_t currentInstruction{0u};
 
-                if(defines.count(alias) > 0)
+        for(auto i(0u); i < tokens.size();)
+        {
+            if(tokens[i].type == VMToken::PreprocessorStart)
+            {
+                std::size_t length{0};
+
+                if((length = Impl::matchDirective(tokens, i,
+                        Impl::requirePattern, "require_registers")) != 0 ||
+                    (length = Impl::matchDirective(tokens, i,
+                         Impl::requirePattern, "require_stack")) != 0)
+                {
+                    auto& target(tokens[i + 1].is("require_registers")
+                                     ? requireRegisters
+                                     : requireStack);
+
+                    if(target != -1)
+                    {
+                        if(TDebug)
+                            ssvu::lo("preprocessSource")
+                                << "ERROR: `$"
+                                << getTokenContents(tokens, i + 1)
+                                << "` already previously encountered"
+                                << "\n";
+                        throw;
+                    }
+
+                    target = getTokenAsInt(tokens, i + 3);
+                }
+                else if((length = Impl::matchDirective(tokens, i,
+                             Impl::definePattern, "define")) != 0)
                 {
-                    if(TDebug)
-                        ssvu::lo("makeProgram - phase 2")
-                            << "ERROR: alias `" << alias
-                            << "` already previously defined"
-                            << "\n";
-                    throw;
+                    if(!defines.emplace(tokens[i + 3], tokens[i + 5]).second)
+                    {
+                        if(TDebug)
+                            ssvu::lo("preprocessSource")
+                                << "ERROR: alias `"
+                                << getTokenContents(tokens, i + 3)
+                                << "` already previously defined"
+                                << "\n";
+                        throw;
+                    }
+                }
+                else if((length = Impl::matchDirective(tokens, i,
+                             Impl::labelPattern, "label")) != 0)
+                {
+                    labelDecls.emplace_back(tokens[i + 3], currentInstruction);
                 }
 
-                defines[alias] = replacement;
-                for(auto k(0u); k < 8; ++k) tokens[i + k].toDel = true;
+                if(length != 0)
+                {
+                    i += length;
+                    continue;
+                }
             }
 
-        ssvu::eraseRemoveIf(tokens, [](const ASMLAToken& mT)
+            if(tokens[i].type == VMToken::Semicolon) ++currentInstruction;
+            if(tokens[i].type == VMToken::Identifier)
+                identifiers.emplace_back(out.size());
+
+            out.emplace_back(tokens[i]);
+            ++i;
+        }
+
+        if(requireStack > 0) result.stackFrameSize = requireStack;
+
+        // Defines apply to every identifier, label names included
+        auto applyDefine([&defines](ASMLAToken& mToken)
             {
-                return mT.toDel;
+                const auto& itr(defines.find(mToken));
+                if(itr != std::end(defines)) mToken = itr->second;
             });
 
-        if(TDebug)
-            ssvu::lo("makeProgram - phase 2")
-                << "Applying `$define` directives..."
-                << "\n";
-        for(auto& t : tokens)
-            if(defines.count(t.contents) > 0) t.contents = defines[t.contents];
-        if(TDebug)
-            ssvu::lo("makeProgram - phase 2") << "Done"
-                                              << "\n";
+        // Label values are written into a single buffer first, as the
+        // tokens referring to them must not be invalidated
+        auto values(std::make_shared<std::string>());
+        std::vector<std::size_t> valueEnds;
 
+        for(auto& l : labelDecls)
+        {
+            applyDefine(l.first);
+            *values += ssvu::toStr(l.second);
+            valueEnds.emplace_back(values->size());
+        }
 
+        result.buffers.emplace_back(values);
 
-        // Phase 3: `$label` directives
-        std::size_t foundLabels{0u}, currentInstruction{0u};
-        std::map<std::string, std::size_t> labels;
-        for(auto i(0u); i < tokens.size(); ++i)
+        Impl::TokenMap<ASMLAToken> labels;
+        for(auto i(0u); i < labelDecls.size(); ++i)
         {
-            if(tokens[i].type == VMToken::Semicolon) ++currentInstruction;
+            const auto& name(labelDecls[i].first);
+            const auto& begin(i == 0 ? 0 : valueEnds[i - 1]);
+            const ASMLAToken value{
+                VMToken::Integer, values->data() + begin, valueEnds[i] - begin};
 
-            if(matchTypes(
-                   i, {VMToken::PreprocessorStart, VMToken::Identifier,
-                          VMToken::ParenthesisRoundOpen, VMToken::Identifier,
-                          VMToken::ParenthesisRoundClose, VMToken::Semicolon}))
+            if(defines.count(name) > 0 || !labels.emplace(name, value).second)
             {
-                if(tokens[i + 1].contents != "label") continue;
-
-                const auto& name(getTokenContents(tokens, i + 3));
                 if(TDebug)
-                    ssvu::lo("makeProgram - phase 3")
-                        << "Found `$label`: " << name << "\n";
+                    ssvu::lo("preprocessSource")
+                        << "ERROR: label name `" << name.getContents()
+                        << "` already previously encountered"
+                        << "\n";
+                throw;
+            }
 
-                if(defines.count(name) > 0)
-                {
-                    if(TDebug)
-                        ssvu::lo("makeProgram - phase 3")
-                            << "ERROR: label name `" << name
-                            << "` already previously encountered"
-                            << "\n";
-                    throw;
-                }
+            if(TDebug)
+                ssvu::lo("preprocessSource")
+                    << "Found `$label`: " << name.getContents() << " = "
+                    << labelDecls[i].second << "\n";
+        }
 
-                labels[name] = currentInstruction - foundLabels;
-                ++foundLabels;
+        for(const auto& i : identifiers)
+        {
+            auto& t(out[i]);
+            applyDefine(t);
 
-                for(auto k(0u); k < 6; ++k) tokens[i + k].toDel = true;
-            }
+            const auto& itr(labels.find(t));
+            if(itr != std::end(labels)) t = itr->second;
         }
 
-        ssvu::eraseRemoveIf(tokens, [](const ASMLAToken& mT)
-            {
-                return mT.toDel;
-            });
-
-        if(TDebug)
-            ssvu::lo("makeProgram - phase 3")
-                << "Applying `$label` directives..."
-                << "\n";
-        for(auto& t : tokens)
-            if(labels.count(t.contents) > 0)
-                t.contents = ssvu::toStr(labels[t.contents]);
-        if(TDebug)
-            ssvu::lo("makeProgram - phase 3") << "Done"
-                                              << "\n";
+        return result;
+    }
 
-        for(auto& t : tokens) result += t.contents;
+    // Preprocesses `mSource` in place, replacing it with the preprocessed
+    // text. Assembling the result of `preprocessSource` directly is faster,
+    // as it does not lex the source again.
+    template <bool TDebug>
+    inline void preprocessSourceRaw(SourceVeeAsm& mSource)
+    {
+        const auto& preprocessed(preprocessSource<TDebug>(mSource));
+        const auto& result(preprocessed.toStr());
 
-        ssvu::lo() << result << std::endl;
+        if(TDebug) ssvu::lo() << result << std::endl;
 
         mSource.setSourceString(result);
+        mSource.setStackFrameSize(preprocessed.stackFrameSize);
         mSource.setPreprocessed(true);
     }
 }
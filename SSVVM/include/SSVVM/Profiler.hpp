@@ -0,0 +1,220 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVVM_PROFILER
+#define SSVVM_PROFILER
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ssvvm
+{
+    // Cycle counter on x86, nanoseconds elsewhere
+    inline std::uint64_t getProfilerTicks() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    // Data collected by `VMDispatch::Profiled`: executions and ticks per
+    // opcode and per instruction, plus a call tree built from
+    // `callPI`/`returnPI`.
+    class Profiler
+    {
+    public:
+        struct Counter
+        {
+            std::uint64_t count{0}, ticks{0};
+        };
+
+    private:
+        struct CallNode
+        {
+            std::size_t parent;
+            Instruction::Idx function;
+            std::uint64_t ticks;
+        };
+
+        std::array<Counter, opCodeCount> opCodes;
+        std::vector<Counter> instructions;
+
+        // Node 0 is the entry point of the program
+        std::vector<CallNode> nodes;
+        std::unordered_map<std::uint64_t, std::size_t> children;
+        std::size_t current{0};
+
+        // (caller, callee) -> call count
+        std::map<std::pair<Instruction::Idx, Instruction::Idx>, std::uint64_t>
+            calls;
+
+        inline static std::string getFunctionName(Instruction::Idx mOffset)
+        {
+            return mOffset == 0 ? "entry" : "fn@" + ssvu::toStr(mOffset);
+        }
+
+        template <typename T>
+        inline static std::vector<std::size_t> getSortedByTicks(const T& mData)
+        {
+            std::vector<std::size_t> result;
+            for(auto i(0u); i < mData.size(); ++i)
+                if(mData[i].count > 0) result.emplace_back(i);
+
+            std::sort(std::begin(result), std::end(result),
+                [&mData](std::size_t mA, std::size_t mB)
+                {
+                    return mData[mA].ticks > mData[mB].ticks;
+                });
+
+            return result;
+        }
+
+        inline static double getPercentage(
+            std::uint64_t mPart, std::uint64_t mTotal) noexcept
+        {
+            return mTotal == 0 ? 0.0 : 100.0 * mPart / mTotal;
+        }
+
+    public:
+        inline void reset(const Program& mProgram)
+        {
+            opCodes.fill({});
+            instructions.assign(mProgram.getByteSize(), {});
+            nodes.assign(1, {0, 0, 0});
+            children.clear();
+            calls.clear();
+            current = 0;
+        }
+
+        inline void record(
+            OpCode mOpCode, Instruction::Idx mOffset, std::uint64_t mTicks)
+        {
+            auto& o(opCodes[std::size_t(mOpCode)]);
+            ++o.count;
+            o.ticks += mTicks;
+
+            auto& i(instructions[mOffset]);
+            ++i.count;
+            i.ticks += mTicks;
+
+            nodes[current].ticks += mTicks;
+        }
+
+        inline void onCall(Instruction::Idx mTarget)
+        {
+            ++calls[{nodes[current].function, mTarget}];
+
+            const auto& key((std::uint64_t(current) << 32) | mTarget);
+            auto itr(children.find(key));
+
+            if(itr == std::end(children))
+            {
+                nodes.push_back({current, mTarget, 0});
+                itr = children.emplace(key, nodes.size() - 1).first;
+            }
+
+            current = itr->second;
+        }
+        inline void onReturn()
+        {
+            if(current != 0) current = nodes[current].parent;
+        }
+
+        inline const Counter& getOpCodeCounter(OpCode mOpCode) const noexcept
+        {
+            return opCodes[std::size_t(mOpCode)];
+        }
+        inline const Counter& getInstructionCounter(
+            Instruction::Idx mOffset) const noexcept
+        {
+            return instructions[mOffset];
+        }
+
+        // Human-readable report: opcodes and instructions sorted by ticks,
+        // then call counts
+        inline void printReport(std::ostream& mStream, const Program& mProgram,
+            std::size_t mMaxRows = 20) const
+        {
+            const auto& flags(mStream.flags());
+            const auto& precision(mStream.precision());
+
+            std::uint64_t total{0};
+            for(const auto& o : opCodes) total += o.ticks;
+
+            mStream << "Opcodes (by ticks)\n"
+                    << std::setw(34) << std::left << "opcode" << std::right
+                    << std::setw(12) << "count" << std::setw(14) << "ticks"
+                    << std::setw(10) << "avg" << std::setw(8) << "%\n";
+
+            for(const auto& i : getSortedByTicks(opCodes))
+            {
+                const auto& o(opCodes[i]);
+                mStream << std::setw(34) << std::left
+                        << getOpCodeStr(OpCode(i)) << std::right
+                        << std::setw(12) << o.count << std::setw(14)
+                        << o.ticks << std::setw(10) << o.ticks / o.count
+                        << std::setw(7) << std::fixed << std::setprecision(2)
+                        << getPercentage(o.ticks, total) << "\n";
+            }
+
+            mStream << "\nInstructions (by ticks)\n"
+                    << std::setw(8) << "offset" << "  " << std::setw(34)
+                    << std::left << "opcode" << std::right << std::setw(12)
+                    << "count" << std::setw(14) << "ticks" << std::setw(8)
+                    << "%\n";
+
+            std::size_t rows{0};
+            for(const auto& i : getSortedByTicks(instructions))
+            {
+                if(rows++ == mMaxRows) break;
+
+                const auto& c(instructions[i]);
+                mStream << std::setw(8) << i << "  " << std::setw(34)
+                        << std::left << getOpCodeStr(mProgram.getOpCode(i))
+                        << std::right << std::setw(12) << c.count
+                        << std::setw(14) << c.ticks << std::setw(7)
+                        << getPercentage(c.ticks, total) << "\n";
+            }
+
+            mStream << "\nCalls\n";
+            for(const auto& c : calls)
+                mStream << std::setw(12) << getFunctionName(c.first.first)
+                        << " -> " << std::setw(12) << std::left
+                        << getFunctionName(c.first.second) << std::right
+                        << std::setw(12) << c.second << "\n";
+
+            mStream.flags(flags);
+            mStream.precision(precision);
+        }
+
+        // One line per call path: `entry;fn@12;fn@12 ticks`, as expected by
+        // flamegraph tools
+        inline void printFoldedStacks(std::ostream& mStream) const
+        {
+            std::vector<std::string> path;
+
+            for(auto i(0u); i < nodes.size(); ++i)
+            {
+                if(nodes[i].ticks == 0) continue;
+
+                path.clear();
+                for(auto n(i); n != 0; n = nodes[n].parent)
+                    path.emplace_back(getFunctionName(nodes[n].function));
+                path.emplace_back(getFunctionName(0));
+
+                for(auto itr(path.rbegin()); itr != path.rend(); ++itr)
+                    mStream << (itr == path.rbegin() ? "" : ";") << *itr;
+
+                mStream << " " << nodes[i].ticks << "\n";
+            }
+        }
+    };
+}
+
+#endif
@@ -7,26 +7,209 @@
 
 namespace ssvvm
 {
+    // Packed bytecode: every instruction is an opcode byte followed by its
+    // immediate operands, as described by `getOperandLayout`. Jump and call
+    // targets are byte offsets into the bytecode.
+    //
+    // The bytecode is immutable once built, and shared between copies. It is
+    // either owned by the program or by a mapped program file (see
+    // `ProgramFile.hpp`).
     struct Program
     {
+    public:
+        // Stack frame size used when the source has no `$require_stack`
+        static constexpr std::size_t defaultStackFrameSize{64};
+
     private:
-        std::vector<Instruction> instructions;
+        std::shared_ptr<const void> storage; // Keeps `bytecode` alive
+        const OpByte* bytecode{nullptr};
+        std::size_t byteSize{0};
+        std::size_t instructionCount{0}, registerCount{0};
+        std::size_t stackFrameSize{0}; // 0 if not declared
+        bool verified{false};
+
+        template <typename T>
+        inline static void emit(std::vector<OpByte>& mOut, T mValue)
+        {
+            const auto& idx(mOut.size());
+            mOut.resize(idx + sizeof(T));
+            std::memcpy(&mOut[idx], &mValue, sizeof(T));
+        }
+
+        inline void emitOperand(std::vector<OpByte>& mOut, Operand mOperand,
+            const Value& mValue, const std::vector<Instruction::Idx>& mOffsets)
+        {
+            switch(mOperand)
+            {
+                case Operand::Reg:
+                    SSVU_ASSERT(
+                        mValue.get<int>() >= 0 && mValue.get<int>() < 256);
+                    emit(mOut, RegByte(mValue.get<int>()));
+                    registerCount = std::max(
+                        registerCount, std::size_t(mValue.get<int>() + 1));
+                    break;
+                case Operand::Int:
+                    emit(mOut, std::int32_t(mValue.get<int>()));
+                    break;
+                case Operand::Float: emit(mOut, mValue.get<float>()); break;
+                case Operand::Target:
+                    SSVU_ASSERT(mValue.get<int>() >= 0 &&
+                                std::size_t(mValue.get<int>()) <
+                                    mOffsets.size());
+                    emit(mOut, std::int32_t(mOffsets[mValue.get<int>()]));
+                    break;
+                case Operand::None: break;
+            }
+        }
+
+        inline Value readOperandValue(Operand mOperand, std::size_t mOffset,
+            const std::unordered_map<Instruction::Idx, Instruction::Idx>&
+                mIndices) const
+        {
+            std::int32_t i32;
+            float f32;
+
+            switch(mOperand)
+            {
+                case Operand::Reg: return Value::create<int>(bytecode[mOffset]);
+                case Operand::Int:
+                    std::memcpy(&i32, &bytecode[mOffset], sizeof(i32));
+                    return Value::create<int>(i32);
+                case Operand::Float:
+                    std::memcpy(&f32, &bytecode[mOffset], sizeof(f32));
+                    return Value::create<float>(f32);
+                case Operand::Target:
+                    std::memcpy(&i32, &bytecode[mOffset], sizeof(i32));
+                    return Value::create<int>(mIndices.at(i32));
+                case Operand::None: break;
+            }
+
+            return {};
+        }
 
     public:
-        inline Program& operator+=(Instruction mInstruction)
+        // Packs unpacked instructions, whose targets are instruction indices
+        inline static Program fromInstructions(
+            const std::vector<Instruction>& mInstructions)
+        {
+            // Byte offset of every instruction (plus the end of the program),
+            // used to translate instruction indices into byte offsets
+            std::vector<Instruction::Idx> offsets;
+            offsets.reserve(mInstructions.size() + 1);
+
+            Instruction::Idx offset{0};
+            for(const auto& i : mInstructions)
+            {
+                offsets.emplace_back(offset);
+                offset += getInstructionSize(i.opCode);
+            }
+            offsets.emplace_back(offset);
+
+            Program result;
+            auto bytes(std::make_shared<std::vector<OpByte>>());
+            bytes->reserve(offset);
+
+            for(const auto& i : mInstructions)
+            {
+                const auto& layout(getOperandLayout(i.opCode));
+
+                emit(*bytes, OpByte(i.opCode));
+                for(auto k(0u); k < layout.getCount(); ++k)
+                    result.emitOperand(
+                        *bytes, layout.operands[k], i.params[k], offsets);
+            }
+
+            result.bytecode = bytes->data();
+            result.byteSize = bytes->size();
+            result.storage = std::move(bytes);
+            result.instructionCount = mInstructions.size();
+            return result;
+        }
+
+        // Wraps bytecode kept alive by `mStorage`, without copying it. The
+        // bytecode is not checked: see `loadProgramFile`.
+        inline static Program fromBytecode(std::shared_ptr<const void> mStorage,
+            const OpByte* mBytecode, std::size_t mByteSize,
+            std::size_t mInstructionCount, std::size_t mRegisterCount)
+        {
+            Program result;
+            result.storage = std::move(mStorage);
+            result.bytecode = mBytecode;
+            result.byteSize = mByteSize;
+            result.instructionCount = mInstructionCount;
+            result.registerCount = mRegisterCount;
+            return result;
+        }
+
+        // Unpacks the program, turning targets back into instruction indices
+        inline std::vector<Instruction> toInstructions() const
+        {
+            std::unordered_map<Instruction::Idx, Instruction::Idx> indices;
+            Instruction::Idx idx{0};
+
+            for(std::size_t offset{0}; offset < byteSize;
+                offset += lookupInstructionSize(getOpCode(offset)))
+                indices[offset] = idx++;
+            indices[byteSize] = idx;
+
+            std::vector<Instruction> result;
+            result.reserve(instructionCount);
+
+            for(std::size_t offset{0}; offset < byteSize;
+                offset += lookupInstructionSize(getOpCode(offset)))
+            {
+                Instruction instruction;
+                instruction.opCode = getOpCode(offset);
+
+                const auto& layout(getOperandLayout(instruction.opCode));
+                for(auto k(0u); k < layout.getCount(); ++k)
+                    instruction.params[k] = readOperandValue(layout.operands[k],
+                        offset + 1 + layout.getOffset(k), indices);
+
+                result.emplace_back(instruction);
+            }
+
+            return result;
+        }
+
+        inline OpCode getOpCode(Instruction::Idx mOffset) const noexcept
         {
-            instructions.emplace_back(std::move(mInstruction));
-            return *this;
+            SSVU_ASSERT(std::size_t(mOffset) < byteSize);
+            return OpCode(bytecode[mOffset]);
         }
-        inline const Instruction& operator[](std::size_t mIdx) const noexcept
+        inline const OpByte* getData() const noexcept { return bytecode; }
+        inline std::size_t getByteSize() const noexcept
         {
-            SSVU_ASSERT(mIdx < instructions.size());
-            return instructions[mIdx];
+            return byteSize;
         }
-        inline std::size_t getSize() const noexcept
+        inline std::size_t getInstructionCount() const noexcept
         {
-            return instructions.size();
+            return instructionCount;
         }
+
+        // Number of registers the program needs (highest index used + 1)
+        inline std::size_t getRegisterCount() const noexcept
+        {
+            return registerCount;
+        }
+
+        // Maximum number of values a single stack frame can hold
+        inline std::size_t getStackFrameSize() const noexcept
+        {
+            return hasStackFrameSize() ? stackFrameSize
+                                       : defaultStackFrameSize;
+        }
+        inline bool hasStackFrameSize() const noexcept
+        {
+            return stackFrameSize != 0;
+        }
+        inline void setStackFrameSize(std::size_t mValue) noexcept
+        {
+            stackFrameSize = mValue;
+        }
+
+        inline bool isVerified() const noexcept { return verified; }
+        inline void setVerified(bool mValue) noexcept { verified = mValue; }
     };
 }
 
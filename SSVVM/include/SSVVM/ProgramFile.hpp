@@ -0,0 +1,400 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVVM_PROGRAMFILE
+#define SSVVM_PROGRAMFILE
+
+#if SSVVM_MMAP
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ssvvm
+{
+    // Program file layout: a `ProgramFileHeader` immediately followed by the
+    // packed bytecode, which is executed in place once the file is mapped.
+    // Values are stored in native byte order - program files are a cache,
+    // not an interchange format.
+    struct ProgramFileHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+
+        // Changes whenever opcodes or operand layouts change
+        std::uint64_t bytecodeSignature;
+
+        // Hash of the source the program was compiled from, 0 if unknown
+        std::uint64_t sourceHash;
+
+        std::uint32_t byteSize, instructionCount, registerCount;
+        std::uint32_t stackFrameSize; // 0 if not declared
+        std::uint32_t flags;
+        std::uint32_t reserved;
+    };
+
+    SSVU_ASSERT_STATIC(sizeof(ProgramFileHeader) == 48, "");
+
+    static constexpr std::uint32_t programFileVersion{1};
+    static constexpr std::uint32_t programFileVerified{1u << 0};
+
+    namespace Impl
+    {
+        static constexpr char programFileMagic[4]{'S', 'V', 'M', 'B'};
+
+        // Maps the whole file at `mPath` read-only, returning nullptr on
+        // failure. The mapping lives as long as the returned pointer.
+        inline std::shared_ptr<const void> mapFile(
+            const std::string& mPath, std::size_t& mSize)
+        {
+#if SSVVM_MMAP
+            const auto& fd(open(mPath.c_str(), O_RDONLY));
+            if(fd < 0) return nullptr;
+
+            struct stat info;
+            void* data{MAP_FAILED};
+
+            if(fstat(fd, &info) == 0 && info.st_size > 0)
+            {
+                mSize = info.st_size;
+                data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+
+            close(fd);
+            if(data == MAP_FAILED) return nullptr;
+
+            const auto& size(mSize);
+            return std::shared_ptr<const void>(data, [size](const void* mData)
+                {
+                    munmap(const_cast<void*>(mData), size);
+                });
+#else
+            std::ifstream file{mPath, std::ios::binary | std::ios::ate};
+            if(!file) return nullptr;
+
+            auto bytes(std::make_shared<std::vector<char>>(file.tellg()));
+            file.seekg(0);
+            if(bytes->empty() || !file.read(bytes->data(), bytes->size()))
+                return nullptr;
+
+            mSize = bytes->size();
+            return std::shared_ptr<const void>(bytes, bytes->data());
+#endif
+        }
+
+        // Checks that `mData` decodes into `mInstructionCount` instructions
+        // whose register operands are below `mRegisterCount` and whose
+        // targets are instruction boundaries, so that a damaged file cannot
+        // make the VM read outside the bytecode
+        inline bool isWellFormed(const OpByte* mData, std::size_t mSize,
+            std::size_t mInstructionCount, std::size_t mRegisterCount)
+        {
+            std::vector<bool> boundaries(mSize + 1, false);
+            std::size_t offset{0}, count{0};
+
+            while(offset < mSize)
+            {
+                if(mData[offset] >= opCodeCount) return false;
+
+                boundaries[offset] = true;
+                offset += lookupInstructionSize(OpCode(mData[offset]));
+                ++count;
+            }
+
+            if(offset != mSize || count != mInstructionCount) return false;
+            boundaries[mSize] = true;
+
+            for(offset = 0; offset < mSize;
+                offset += lookupInstructionSize(OpCode(mData[offset])))
+            {
+                const auto& layout(getOperandLayout(OpCode(mData[offset])));
+                const auto& operands(mData + offset + 1);
+
+                for(auto k(0u); k < layout.getCount(); ++k)
+                {
+                    const auto& operand(operands + layout.getOffset(k));
+
+                    if(layout.operands[k] == Operand::Reg &&
+                        *operand >= mRegisterCount)
+                        return false;
+
+                    if(layout.operands[k] != Operand::Target) continue;
+
+                    std::int32_t target;
+                    std::memcpy(&target, operand, sizeof(target));
+                    if(target < 0 || std::size_t(target) > mSize ||
+                        !boundaries[target])
+                        return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    // Hash of every opcode name and operand layout, stored in program files
+    // so that files written by an incompatible VM are rejected
+    inline std::uint64_t getBytecodeSignature()
+    {
+        static const std::uint64_t result{[]
+            {
+                std::uint64_t hash{Impl::getFNV1a(nullptr, 0)};
+
+                for(auto i(0u); i < opCodeCount; ++i)
+                {
+                    const auto& name(getOpCodeStr(OpCode(i)));
+                    const auto& layout(getOperandLayout(OpCode(i)));
+
+                    hash = Impl::getFNV1a(name.data(), name.size() + 1, hash);
+                    hash = Impl::getFNV1a(
+                        layout.operands, sizeof(layout.operands), hash);
+                }
+
+                return hash;
+            }()};
+
+        return result;
+    }
+
+    namespace Impl
+    {
+        // Writes `mHeader` followed by the bytecode of `mProgram` to a new
+        // file next to `mPath`, whose name no other writer uses. Returns
+        // its path, or an empty string on failure.
+        inline std::string writeTempProgramFile(const std::string& mPath,
+            const ProgramFileHeader& mHeader, const Program& mProgram)
+        {
+#if SSVVM_MMAP
+            std::string result{mPath + ".XXXXXX"};
+            const auto& fd(mkstemp(&result[0]));
+            if(fd < 0) return {};
+
+            auto writeAll([fd](const void* mData, std::size_t mSize)
+                {
+                    auto bytes(static_cast<const char*>(mData));
+                    while(mSize > 0)
+                    {
+                        const auto& written(write(fd, bytes, mSize));
+                        if(written < 0 && errno == EINTR) continue;
+                        if(written < 0) return false;
+
+                        bytes += written;
+                        mSize -= written;
+                    }
+                    return true;
+                });
+
+            // `mkstemp` creates files readable by their owner only
+            const auto& ok(
+                fchmod(fd, 0644) == 0 && writeAll(&mHeader, sizeof(mHeader)) &&
+                writeAll(mProgram.getData(), mProgram.getByteSize()));
+
+            if(close(fd) != 0 || !ok)
+            {
+                unlink(result.c_str());
+                return {};
+            }
+
+            return result;
+#else
+            // Random names, created exclusively ("x"): a name already taken
+            // by another writer is retried
+            static constexpr int maxAttempts{16};
+            std::random_device device;
+
+            for(int i{0}; i < maxAttempts; ++i)
+            {
+                const auto& result(mPath + "." + ssvu::toStr(device()) +
+                                   ".tmp");
+
+                auto file(std::fopen(result.c_str(), "wbx"));
+                if(file == nullptr) continue;
+
+                const auto& ok(
+                    std::fwrite(&mHeader, sizeof(mHeader), 1, file) == 1 &&
+                    std::fwrite(mProgram.getData(), 1, mProgram.getByteSize(),
+                        file) == mProgram.getByteSize());
+
+                if(std::fclose(file) != 0 || !ok)
+                {
+                    std::remove(result.c_str());
+                    return {};
+                }
+
+                return result;
+            }
+
+            return {};
+#endif
+        }
+    }
+
+    // Writes `mProgram` to `mPath`. The file is written to a temporary file
+    // of its own next to `mPath` first, then renamed, so that readers never
+    // see a partial file and concurrent writers of the same path do not
+    // interleave their writes.
+    inline bool writeProgramFile(const std::string& mPath,
+        const Program& mProgram, std::uint64_t mSourceHash = 0)
+    {
+        ProgramFileHeader header{};
+        std::memcpy(header.magic, Impl::programFileMagic, sizeof(header.magic));
+        header.version = programFileVersion;
+        header.bytecodeSignature = getBytecodeSignature();
+        header.sourceHash = mSourceHash;
+        header.byteSize = mProgram.getByteSize();
+        header.instructionCount = mProgram.getInstructionCount();
+        header.registerCount = mProgram.getRegisterCount();
+        header.stackFrameSize =
+            mProgram.hasStackFrameSize() ? mProgram.getStackFrameSize() : 0;
+        header.flags = mProgram.isVerified() ? programFileVerified : 0;
+
+        const auto& tmpPath(
+            Impl::writeTempProgramFile(mPath, header, mProgram));
+        if(tmpPath.empty()) return false;
+
+        if(std::rename(tmpPath.c_str(), mPath.c_str()) == 0) return true;
+
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    // Maps the program file at `mPath` into `mResult`, without copying the
+    // bytecode. Fails if the file is missing, damaged, written by an
+    // incompatible VM or - with a non-zero `mSourceHash` - compiled from a
+    // different source. The verified flag is trusted: only load files
+    // written by `writeProgramFile`.
+    template <bool TDebug>
+    inline bool loadProgramFile(const std::string& mPath, Program& mResult,
+        std::uint64_t mSourceHash = 0)
+    {
+        std::size_t size{0};
+        auto storage(Impl::mapFile(mPath, size));
+
+        auto reject([&mPath](const char* mReason)
+            {
+                if(TDebug)
+                    ssvu::lo("loadProgramFile") << mPath << ": " << mReason
+                                                << "\n";
+                return false;
+            });
+
+        if(storage == nullptr) return reject("cannot be read");
+
+        ProgramFileHeader header;
+        if(size < sizeof(header)) return reject("truncated header");
+        std::memcpy(&header, storage.get(), sizeof(header));
+
+        if(std::memcmp(header.magic, Impl::programFileMagic,
+               sizeof(header.magic)) != 0 ||
+            header.version != programFileVersion)
+            return reject("not a program file of this version");
+
+        if(header.bytecodeSignature != getBytecodeSignature())
+            return reject("written by an incompatible VM");
+
+        if(mSourceHash != 0 && header.sourceHash != mSourceHash)
+            return reject("compiled from a different source");
+
+        const auto& bytecode(
+            static_cast<const OpByte*>(storage.get()) + sizeof(header));
+
+        if(size - sizeof(header) != header.byteSize ||
+            !Impl::isWellFormed(bytecode, header.byteSize,
+                header.instructionCount, header.registerCount))
+            return reject("damaged bytecode");
+
+        mResult = Program::fromBytecode(std::move(storage), bytecode,
+            header.byteSize, header.instructionCount, header.registerCount);
+        mResult.setStackFrameSize(header.stackFrameSize);
+        mResult.setVerified((header.flags & programFileVerified) != 0);
+
+        return true;
+    }
+
+    // On-disk cache of compiled programs, keyed by a hash of their source.
+    // Cache hits skip lexing, preprocessing and assembling entirely: the
+    // cached file is mapped and executed in place.
+    class ProgramCache
+    {
+    private:
+        std::string directory;
+        std::size_t hits{0}, misses{0};
+
+    public:
+        // `mDirectory` must already exist
+        inline ProgramCache(std::string mDirectory)
+            : directory(std::move(mDirectory))
+        {
+        }
+
+        // Never 0, so it can always be checked by `loadProgramFile`
+        inline static std::uint64_t getSourceHash(const SourceVeeAsm& mSource)
+        {
+            const auto& text(mSource.getSourceString());
+            const std::uint64_t meta[]{getBytecodeSignature(),
+                mSource.isPreprocessed(), mSource.getStackFrameSize()};
+
+            const auto& result(Impl::getFNV1a(text.data(), text.size(),
+                Impl::getFNV1a(meta, sizeof(meta))));
+            return result != 0 ? result : 1;
+        }
+
+        inline std::string getPath(std::uint64_t mSourceHash) const
+        {
+            std::ostringstream result;
+            result << directory << "/" << std::hex << std::setw(16)
+                   << std::setfill('0') << mSourceHash << ".svmb";
+            return result.str();
+        }
+
+        // Returns the cached program for `mSource`, or compiles it with
+        // `mCompile(SourceVeeAsm&)` and caches the result. Anything
+        // `mCompile` does (optimizing, verifying) must only depend on the
+        // source.
+        template <bool TDebug, typename TFn>
+        inline Program get(const SourceVeeAsm& mSource, const TFn& mCompile)
+        {
+            const auto& hash(getSourceHash(mSource));
+            const auto& path(getPath(hash));
+
+            Program result;
+            if(loadProgramFile<TDebug>(path, result, hash))
+            {
+                ++hits;
+                return result;
+            }
+
+            ++misses;
+
+            auto source(mSource);
+            result = mCompile(source);
+
+            if(!writeProgramFile(path, result, hash) && TDebug)
+                ssvu::lo("ProgramCache") << "Cannot write " << path << "\n";
+
+            return result;
+        }
+
+        // Same as above, preprocessing and assembling the source
+        template <bool TDebug>
+        inline Program get(const SourceVeeAsm& mSource)
+        {
+            return get<TDebug>(mSource, [](SourceVeeAsm& mToCompile)
+                {
+                    if(mToCompile.isPreprocessed())
+                        return getAssembledProgram<TDebug>(mToCompile);
+
+                    return getAssembledProgram<TDebug>(
+                        preprocessSource<TDebug>(mToCompile));
+                });
+        }
+
+        inline std::size_t getHits() const noexcept { return hits; }
+        inline std::size_t getMisses() const noexcept { return misses; }
+    };
+}
+
+#endif
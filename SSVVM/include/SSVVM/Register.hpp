@@ -10,7 +10,6 @@ namespace ssvvm
     struct Register
     {
         using Idx = int;
-        Value value;
     };
 }
 
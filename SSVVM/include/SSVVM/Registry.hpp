@@ -7,32 +7,26 @@
 
 namespace ssvvm
 {
-    template <std::size_t TSize>
+    template <std::size_t TSize, typename TValue = Value>
     class Registry
     {
     private:
-        std::array<Register, TSize> registers;
+        std::array<TValue, TSize> values;
 
     public:
-        inline Register& get(std::size_t mIdx) noexcept
+        inline TValue& getValue(std::size_t mIdx) noexcept
         {
             SSVU_ASSERT(mIdx < TSize);
-            return registers[mIdx];
+            return values[mIdx];
         }
-        inline const Register& get(std::size_t mIdx) const noexcept
+        inline const TValue& getValue(std::size_t mIdx) const noexcept
         {
             SSVU_ASSERT(mIdx < TSize);
-            return registers[mIdx];
-        }
-        inline Value& getValue(std::size_t mIdx) noexcept
-        {
-            return get(mIdx).value;
-        }
-        inline const Value& getValue(std::size_t mIdx) const noexcept
-        {
-            return get(mIdx).value;
+            return values[mIdx];
         }
+        inline void clear() noexcept { values.fill(TValue{}); }
         inline std::size_t getSize() const noexcept { return TSize; }
+        inline TValue* getData() noexcept { return values.data(); }
     };
 }
 
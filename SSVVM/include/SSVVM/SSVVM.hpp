@@ -5,6 +5,23 @@
 #ifndef SSVVM
 #define SSVVM
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
 #include <SSVUtils/SSVUtils.hpp>
 #include "SSVVM/Common.hpp"
 #include "SSVVM/SourceVeeAsm.hpp"
@@ -12,16 +29,23 @@
 #include "SSVVM/Register.hpp"
 #include "SSVVM/Params.hpp"
 #include "SSVVM/Registry.hpp"
-#include "SSVVM/Stack.hpp"
 #include "SSVVM/OpCodes.hpp"
 #include "SSVVM/Instruction.hpp"
+#include "SSVVM/Stack.hpp"
+#include "SSVVM/Bytecode.hpp"
 #include "SSVVM/Program.hpp"
 #include "SSVVM/Operations.hpp"
 #include "SSVVM/BoundFunction.hpp"
+#include "SSVVM/JIT.hpp"
+#include "SSVVM/Profiler.hpp"
 #include "SSVVM/VirtualMachine.hpp"
+#include "SSVVM/VMPool.hpp"
 #include "SSVVM/UtilsStringifier.hpp"
 #include "SSVVM/ASMLexicalAnalyzer.hpp"
 #include "SSVVM/Preprocessor.hpp"
 #include "SSVVM/Assembler.hpp"
+#include "SSVVM/Verifier.hpp"
+#include "SSVVM/Optimizer.hpp"
+#include "SSVVM/ProgramFile.hpp"
 
 #endif
@@ -12,6 +12,7 @@ namespace ssvvm
     private:
         std::string contents;
         bool preprocessed{false};
+        std::size_t stackFrameSize{0}; // From `$require_stack`, 0 if absent
 
     public:
         inline static SourceVeeAsm fromStrRaw(std::string mSourceRaw)
@@ -44,6 +45,15 @@ namespace ssvvm
         {
             preprocessed = mValue;
         }
+
+        inline std::size_t getStackFrameSize() const noexcept
+        {
+            return stackFrameSize;
+        }
+        inline void setStackFrameSize(std::size_t mValue) noexcept
+        {
+            stackFrameSize = mValue;
+        }
     };
 }
 
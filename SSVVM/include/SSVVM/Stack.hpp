@@ -7,63 +7,121 @@
 
 namespace ssvvm
 {
+    // Fixed-capacity operand stack. Every stack frame holds at most
+    // `frameSize` values, so room for the whole stack is allocated once.
+    // `push` is not bounds-checked: for verified programs the only overflow
+    // check is the call depth, done once per call by `canPushFrame`, while
+    // the VM checks `canPush` before pushing values of other programs.
+    template <typename TValue = Value>
     class Stack
     {
+    public:
+        static constexpr std::size_t defaultMaxDepth{1024};
+
     private:
-        std::vector<Value> stack;
-        int baseOffset{0}; // Distance between top and base
+        // Call linkage, kept out of the operand stack
+        struct Frame
+        {
+            TValue* base;
+            Instruction::Idx returnIdx;
+        };
+
+        std::vector<TValue> values;
+        std::vector<Frame> frames;
+
+        TValue* top{nullptr};  // One past the top value
+        TValue* base{nullptr}; // First value of the current frame
+        std::size_t depth{0};
 
     public:
-        inline void pushBaseOffset() noexcept
+        inline void init(std::size_t mFrameSize,
+            std::size_t mMaxDepth = defaultMaxDepth)
         {
-            push(Value::create<int>(baseOffset));
-            baseOffset = 0;
+            values.assign(mFrameSize * (mMaxDepth + 1), TValue{});
+            frames.resize(mMaxDepth);
+
+            clear();
         }
-        inline void popBaseOffset() noexcept
+
+        // Drops every value and frame, keeping the allocated storage
+        inline void clear() noexcept
         {
-            baseOffset = getPop().get<int>();
+            top = base = values.data();
+            depth = 0;
         }
 
-        inline void push(Value mValue) noexcept
+        inline bool canPushFrame() const noexcept
         {
-            stack.emplace_back(mValue);
-            ++baseOffset;
+            return depth < frames.size();
         }
-        inline Value getPop() noexcept
+        inline void pushFrame(Instruction::Idx mReturnIdx) noexcept
         {
-            SSVU_ASSERT(!stack.empty());
-            auto result(stack.back());
-            stack.pop_back();
-            --baseOffset;
-            return result;
+            SSVU_ASSERT(canPushFrame());
+            frames[depth++] = {base, mReturnIdx};
+            base = top;
+        }
+        inline Instruction::Idx popFrame() noexcept
+        {
+            SSVU_ASSERT(depth > 0 && top == base);
+            const auto& frame(frames[--depth]);
+            base = frame.base;
+            return frame.returnIdx;
         }
 
-        inline const Value& getTop() const noexcept { return stack.back(); }
-        inline Value& getTop() noexcept { return stack.back(); }
-        inline const Value& getTop(int mOffset) const noexcept
+        inline bool canPush(std::size_t mCount = 1) const noexcept
         {
-            return *(std::end(stack) - mOffset - 1);
+            return std::size_t(values.data() + values.size() - top) >= mCount;
         }
-        inline Value& getTop(int mOffset) noexcept
+        inline void push(TValue mValue) noexcept
         {
-            return *(std::end(stack) - mOffset - 1);
+            SSVU_ASSERT(top < values.data() + values.size());
+            *top++ = mValue;
+        }
+        inline TValue getPop() noexcept
+        {
+            SSVU_ASSERT(top > values.data());
+            return *--top;
+        }
+
+        inline const TValue& getTop() const noexcept { return *(top - 1); }
+        inline TValue& getTop() noexcept { return *(top - 1); }
+        inline const TValue& getTop(int mOffset) const noexcept
+        {
+            return *(top - mOffset - 1);
+        }
+        inline TValue& getTop(int mOffset) noexcept
+        {
+            return *(top - mOffset - 1);
         }
 
         inline void pop() noexcept
         {
-            SSVU_ASSERT(!stack.empty());
-            stack.pop_back();
+            SSVU_ASSERT(top > values.data());
+            --top;
         }
 
-        inline Value getFromBase(int mOffset) noexcept
+        // Non-negative offsets read the caller's values (0 is the nearest),
+        // negative offsets read the current frame (-1 is its first value)
+        inline TValue getFromBase(int mOffset) noexcept
         {
-            return *(std::end(stack) - baseOffset - mOffset - 1);
+            return *(base - mOffset - 1);
         }
-        inline int getBaseOffset() const { return baseOffset; }
+        inline int getBaseOffset() const noexcept { return top - base; }
+        inline std::size_t getDepth() const noexcept { return depth; }
+
+        // Raw access to the current frame, used by JIT-compiled code and by
+        // native function calls
+        inline TValue* getTopPtr() noexcept { return top; }
+        inline void setTopPtr(TValue* mTop) noexcept { top = mTop; }
+        inline TValue* getBasePtr() noexcept { return base; }
 
-        inline const decltype(stack)& getStack() const noexcept
+        inline std::size_t getSize() const noexcept
+        {
+            return top - values.data();
+        }
+        inline const TValue& getValue(std::size_t mIdx) const noexcept
         {
-            return stack;
+            return values[mIdx];
         }
     };
 }
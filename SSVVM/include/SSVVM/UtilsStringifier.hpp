@@ -32,6 +32,22 @@ namespace ssvu
             Impl::printBold<TFmt>(mStream, "]");
         }
     };
+
+    template <>
+    struct Stringifier<ssvvm::RawValue>
+    {
+        template <bool TFmt>
+        inline static void impl(
+            std::ostream& mStream, const ssvvm::RawValue& mValue)
+        {
+            // The type is unknown - print the slot both ways
+            Impl::printBold<TFmt>(mStream, "RAW[");
+            Impl::callStringifyImpl<TFmt>(mStream, mValue.get<int>());
+            Impl::printBold<TFmt>(mStream, " | ");
+            Impl::callStringifyImpl<TFmt>(mStream, mValue.get<float>());
+            Impl::printBold<TFmt>(mStream, "]");
+        }
+    };
 }
 
 #endif
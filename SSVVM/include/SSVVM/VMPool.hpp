@@ -0,0 +1,288 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVVM_VMPOOL
+#define SSVVM_VMPOOL
+
+namespace ssvvm
+{
+    // Runs one program on many independent inputs in parallel. Every worker
+    // thread owns one `TVM` execution context (registers and stack) and all
+    // contexts share the same immutable `Program`.
+    //
+    // A batch is split into chunks of consecutive inputs. Each worker starts
+    // with an even share of the chunks and, once it runs out, steals half of
+    // the remaining chunks of another worker.
+    template <typename TVM>
+    class VMPool
+    {
+    public:
+        using Value = typename TVM::VMValue;
+
+        // Initial values of the registers, starting from register 0. With
+        // `VMStorage::Untagged`, their types must be passed to
+        // `verifyProgram`.
+        using Input = std::vector<Value>;
+
+        // Top of the stack after `halt` - default-constructed if the stack
+        // is empty or if the program overflowed the stack
+        using Output = Value;
+
+        static constexpr std::size_t defaultChunkSize{16};
+
+    private:
+        struct Worker
+        {
+            TVM vm;
+
+            // Chunks left to run, as `(begin << 32) | end`. The owner takes
+            // chunks from the front, thieves take them from the back.
+            std::atomic<std::uint64_t> range{0};
+        };
+
+        std::shared_ptr<const Program> program;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+        std::size_t chunkSize;
+
+        // Current batch
+        const std::vector<Input>* inputs{nullptr};
+        std::vector<Output> outputs;
+
+        std::mutex mutex;
+        std::condition_variable cvStart, cvDone;
+        std::size_t generation{0}, busy{0};
+        bool stopping{false};
+
+        inline static std::uint64_t getRange(
+            std::uint64_t mBegin, std::uint64_t mEnd) noexcept
+        {
+            return (mBegin << 32) | mEnd;
+        }
+        inline static std::uint64_t getBegin(std::uint64_t mRange) noexcept
+        {
+            return mRange >> 32;
+        }
+        inline static std::uint64_t getEnd(std::uint64_t mRange) noexcept
+        {
+            return mRange & 0xFFFFFFFFu;
+        }
+
+        // Takes the first chunk of `mWorker`, returning false if none is left
+        inline static bool pop(Worker& mWorker, std::size_t& mChunk) noexcept
+        {
+            auto range(mWorker.range.load());
+
+            while(getBegin(range) < getEnd(range))
+                if(mWorker.range.compare_exchange_weak(range,
+                       getRange(getBegin(range) + 1, getEnd(range))))
+                {
+                    mChunk = getBegin(range);
+                    return true;
+                }
+
+            return false;
+        }
+
+        // Moves the last half of the chunks of `mVictim` to `mThief`
+        inline static bool steal(Worker& mThief, Worker& mVictim) noexcept
+        {
+            auto range(mVictim.range.load());
+
+            while(getBegin(range) < getEnd(range))
+            {
+                const auto& begin(getBegin(range));
+                const auto& end(getEnd(range));
+                const auto& split(end - (end - begin + 1) / 2);
+
+                if(mVictim.range.compare_exchange_weak(
+                       range, getRange(begin, split)))
+                {
+                    mThief.range.store(getRange(split, end));
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        inline void runInput(Worker& mWorker, std::size_t mIdx) noexcept
+        {
+            auto& vm(mWorker.vm);
+            const auto& input((*inputs)[mIdx]);
+
+            SSVU_ASSERT(input.size() <= vm.registry.getSize());
+
+            vm.reset();
+            for(auto i(0u); i < input.size(); ++i)
+                vm.registry.getValue(i) = input[i];
+
+            vm.execute();
+
+            outputs[mIdx] = vm.overflowed || vm.stack.getSize() == 0
+                                ? Output{}
+                                : vm.stack.getTop();
+        }
+
+        inline void work(std::size_t mIdx) noexcept
+        {
+            auto& self(*workers[mIdx]);
+            std::size_t chunk;
+
+            while(true)
+            {
+                while(pop(self, chunk))
+                {
+                    const auto& begin(chunk * chunkSize);
+                    const auto end(
+                        std::min(begin + chunkSize, inputs->size()));
+
+                    for(auto i(begin); i < end; ++i) runInput(self, i);
+                }
+
+                // Look for a victim, starting from the next worker. Chunks
+                // are never added during a batch, so if every worker is
+                // empty the batch is done.
+                bool stolen{false};
+                for(auto i(1u); i < workers.size() && !stolen; ++i)
+                    stolen = steal(
+                        self, *workers[(mIdx + i) % workers.size()]);
+
+                if(!stolen) return;
+            }
+        }
+
+        inline void threadLoop(std::size_t mIdx)
+        {
+            std::size_t seen{0};
+
+            while(true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock{mutex};
+                    cvStart.wait(lock, [this, &seen]
+                        {
+                            return stopping || generation != seen;
+                        });
+
+                    if(stopping) return;
+                    seen = generation;
+                }
+
+                work(mIdx);
+
+                std::lock_guard<std::mutex> lock{mutex};
+                if(--busy == 0) cvDone.notify_one();
+            }
+        }
+
+    public:
+        // `mThreadCount` includes the thread calling `runAll`. 0 uses one
+        // thread per hardware core.
+        inline VMPool(std::shared_ptr<const Program> mProgram,
+            std::size_t mThreadCount = 0,
+            std::size_t mChunkSize = defaultChunkSize)
+            : program(std::move(mProgram)), chunkSize(mChunkSize)
+        {
+            SSVU_ASSERT(chunkSize > 0);
+
+            if(mThreadCount == 0)
+                mThreadCount =
+                    std::max(std::thread::hardware_concurrency(), 1u);
+
+            for(auto i(0u); i < mThreadCount; ++i)
+            {
+                workers.emplace_back(std::make_unique<Worker>());
+                workers.back()->vm.setProgram(program);
+            }
+
+            for(auto i(1u); i < mThreadCount; ++i)
+                threads.emplace_back([this, i]
+                    {
+                        threadLoop(i);
+                    });
+        }
+        inline VMPool(Program mProgram, std::size_t mThreadCount = 0,
+            std::size_t mChunkSize = defaultChunkSize)
+            : VMPool(std::make_shared<const Program>(std::move(mProgram)),
+                  mThreadCount, mChunkSize)
+        {
+        }
+
+        inline ~VMPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                stopping = true;
+            }
+
+            cvStart.notify_all();
+            for(auto& t : threads) t.join();
+        }
+
+        VMPool(const VMPool&) = delete;
+        VMPool& operator=(const VMPool&) = delete;
+
+        // Runs the program once per input, returning the outputs in the same
+        // order. The calling thread takes part in the batch.
+        inline std::vector<Output> runAll(const std::vector<Input>& mInputs)
+        {
+            const auto& chunkCount(
+                (mInputs.size() + chunkSize - 1) / chunkSize);
+            SSVU_ASSERT(chunkCount <= 0xFFFFFFFFu);
+
+            inputs = &mInputs;
+            outputs.assign(mInputs.size(), Output{});
+
+            // Even share of chunks per worker
+            for(auto i(0u); i < workers.size(); ++i)
+                workers[i]->range.store(
+                    getRange(chunkCount * i / workers.size(),
+                        chunkCount * (i + 1) / workers.size()));
+
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                busy = threads.size();
+                ++generation;
+            }
+
+            cvStart.notify_all();
+            work(0);
+
+            std::unique_lock<std::mutex> lock{mutex};
+            cvDone.wait(lock, [this]
+                {
+                    return busy == 0;
+                });
+
+            inputs = nullptr;
+            return std::move(outputs);
+        }
+
+        // Binds `mFnPtr` in every execution context - see
+        // `VMImpl::bindNative`
+        template <typename TReturn, typename... TArgs>
+        inline std::size_t bindNative(TReturn (*mFnPtr)(TArgs...))
+        {
+            std::size_t result{0};
+            for(auto& w : workers) result = w->vm.bindNative(mFnPtr);
+            return result;
+        }
+
+        // Enables the JIT in every execution context - see
+        // `VMImpl::enableJIT`
+        inline void enableJIT(std::size_t mThreshold) noexcept
+        {
+            for(auto& w : workers) w->vm.enableJIT(mThreshold);
+        }
+
+        inline std::size_t getThreadCount() const noexcept
+        {
+            return workers.size();
+        }
+        inline const Program& getProgram() const noexcept { return *program; }
+    };
+}
+
+#endif
@@ -70,6 +70,62 @@ namespace ssvvm
         SSVU_ASSERT(type == VMVal::Float);
         return implFloat;
     }
+
+    // Untagged 32-bit value slot, used by `VMStorage::Untagged`. Its type is
+    // not stored anywhere: only programs accepted by `verifyProgram`, whose
+    // slot types are known for every instruction, can be run with it.
+    class RawValue
+    {
+    private:
+        union
+        {
+            int implInt;
+            float implFloat;
+        };
+
+    public:
+        template <typename T>
+        inline static RawValue create(T mContents) noexcept
+        {
+            return {mContents};
+        }
+
+        inline RawValue() noexcept : implInt{0} {}
+        template <typename T>
+        inline RawValue(T mContents) noexcept
+        {
+            set<T>(mContents);
+        }
+
+        template <typename T>
+        inline void set(T mContents) noexcept;
+        template <typename T>
+        inline T get() const noexcept;
+    };
+
+    SSVU_ASSERT_STATIC(sizeof(RawValue) == 4, "RawValue must be 32 bits");
+
+    template <>
+    inline void RawValue::set<int>(int mContents) noexcept
+    {
+        implInt = mContents;
+    }
+    template <>
+    inline void RawValue::set<float>(float mContents) noexcept
+    {
+        implFloat = mContents;
+    }
+
+    template <>
+    inline int RawValue::get<int>() const noexcept
+    {
+        return implInt;
+    }
+    template <>
+    inline float RawValue::get<float>() const noexcept
+    {
+        return implFloat;
+    }
 }
 
 #endif
@@ -0,0 +1,663 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVVM_VERIFIER
+#define SSVVM_VERIFIER
+
+namespace ssvvm
+{
+    namespace Impl
+    {
+        // Type of a register or stack slot, as tracked by the verifier
+        enum class VType : std::uint8_t
+        {
+            Unset, // Register never written
+            Int,
+            Float,
+            Any // Different types on different paths
+        };
+
+        inline VType mergeVTypes(VType mA, VType mB) noexcept
+        {
+            return mA == mB ? mA : VType::Any;
+        }
+
+        // `VMVal::Void` has no slot type
+        inline VType getVType(VMVal mType) noexcept
+        {
+            return mType == VMVal::Int
+                       ? VType::Int
+                       : mType == VMVal::Float ? VType::Float : VType::Unset;
+        }
+
+        // Abstract machine state before an instruction
+        struct VState
+        {
+            using Types = std::vector<VType>;
+
+            // Entry of the function the instruction belongs to
+            Instruction::Idx function;
+
+            Types registers;
+
+            // Values pushed in the current stack frame, bottom to top
+            Types frame;
+
+            // Values below the frame base (the callers' frames), nearest
+            // first
+            Types incoming;
+        };
+
+        struct VFunctionSummary
+        {
+            bool returns{false};
+            VState::Types exitRegisters;
+            std::vector<Instruction::Idx> callSites;
+        };
+
+        template <bool TDebug>
+        class Verifier
+        {
+        private:
+            // Caller slots visible to a callee are tracked up to this depth,
+            // and reading deeper ones is rejected
+            static constexpr std::size_t maxIncoming{16};
+
+            const Program& program;
+            const std::vector<VMVal>& inputs;
+            const std::vector<BoundFunction>& natives;
+            std::vector<bool> boundaries, visited;
+            std::vector<VState> states;
+            std::vector<Instruction::Idx> worklist;
+            std::unordered_map<Instruction::Idx, VFunctionSummary> functions;
+            bool ok{true};
+
+            // Largest stack frame reached, and where
+            std::size_t maxFrameSize{0};
+            Instruction::Idx maxFrameOffset{0};
+
+            inline void fail(Instruction::Idx mOffset, const std::string& mMsg)
+            {
+                if(TDebug)
+                    ssvu::lo("verifier")
+                        << "ERROR at offset " << mOffset << " ("
+                        << getOpCodeStr(program.getOpCode(mOffset))
+                        << "): " << mMsg << "\n";
+                ok = false;
+            }
+
+            inline bool findBoundaries()
+            {
+                const auto& size(program.getByteSize());
+                boundaries.assign(size + 1, false);
+
+                std::size_t offset{0};
+                while(offset < size)
+                {
+                    const auto& opByte(program.getData()[offset]);
+                    if(opByte >= opCodeCount)
+                    {
+                        if(TDebug)
+                            ssvu::lo("verifier") << "ERROR: invalid opcode "
+                                                 << int(opByte) << "\n";
+                        return false;
+                    }
+
+                    boundaries[offset] = true;
+                    offset += lookupInstructionSize(OpCode(opByte));
+                }
+
+                return offset == size;
+            }
+
+            inline void mergeInto(Instruction::Idx mFrom,
+                Instruction::Idx mTarget, const VState& mState)
+            {
+                if(mTarget < 0 ||
+                    std::size_t(mTarget) >= program.getByteSize() ||
+                    !boundaries[mTarget])
+                {
+                    fail(mFrom, "invalid jump target or end of program");
+                    return;
+                }
+
+                if(mState.frame.size() > maxFrameSize)
+                {
+                    maxFrameSize = mState.frame.size();
+                    maxFrameOffset = mTarget;
+                }
+
+                if(!visited[mTarget])
+                {
+                    visited[mTarget] = true;
+                    states[mTarget] = mState;
+                    worklist.emplace_back(mTarget);
+                    return;
+                }
+
+                auto& s(states[mTarget]);
+
+                if(s.function != mState.function)
+                {
+                    fail(mTarget, "instruction shared by two functions");
+                    return;
+                }
+                if(s.frame.size() != mState.frame.size())
+                {
+                    fail(mTarget, "stack depth differs between paths");
+                    return;
+                }
+
+                bool changed{false};
+                auto mergeTypes([&changed](VState::Types& mDst,
+                    const VState::Types& mSrc, std::size_t mCount)
+                    {
+                        for(auto i(0u); i < mCount; ++i)
+                        {
+                            auto merged(mergeVTypes(mDst[i], mSrc[i]));
+                            if(merged == mDst[i]) continue;
+
+                            mDst[i] = merged;
+                            changed = true;
+                        }
+                    });
+
+                mergeTypes(s.registers, mState.registers, s.registers.size());
+                mergeTypes(s.frame, mState.frame, s.frame.size());
+
+                if(mState.incoming.size() < s.incoming.size())
+                {
+                    s.incoming.resize(mState.incoming.size());
+                    changed = true;
+                }
+                mergeTypes(s.incoming, mState.incoming, s.incoming.size());
+
+                if(changed) worklist.emplace_back(mTarget);
+            }
+
+            inline bool requireRegister(
+                Instruction::Idx mOffset, const VState& mState,
+                Register::Idx mIdx, VType mType)
+            {
+                if(mState.registers[mIdx] == mType) return true;
+
+                fail(mOffset, "register " + ssvu::toStr(mIdx) +
+                                  " does not hold the expected type");
+                return false;
+            }
+
+            inline bool requireStack(Instruction::Idx mOffset,
+                const VState& mState, std::size_t mCount,
+                VType mType = VType::Any)
+            {
+                const auto& frame(mState.frame);
+
+                if(frame.size() < mCount)
+                {
+                    fail(mOffset, "stack frame underflow");
+                    return false;
+                }
+
+                if(mType == VType::Any) return true;
+
+                for(auto i(0u); i < mCount; ++i)
+                    if(frame[frame.size() - i - 1] != mType)
+                    {
+                        fail(mOffset,
+                            "stack value does not hold the expected type");
+                        return false;
+                    }
+
+                return true;
+            }
+
+            // Type of the slot read by `moveSBOVToR`. Offsets outside the
+            // current frame, or past the caller slots tracked on every path
+            // to the instruction, are rejected: the VM does not check them.
+            inline bool getSBOType(Instruction::Idx mOffset,
+                const VState& mState, int mSBO, VType& mResult)
+            {
+                const auto& slots(mSBO < 0 ? mState.frame : mState.incoming);
+                const auto& idx(std::size_t(mSBO < 0 ? -(mSBO + 1) : mSBO));
+
+                if(idx >= slots.size())
+                {
+                    fail(mOffset, "stack base offset " + ssvu::toStr(mSBO) +
+                                      " is out of range");
+                    return false;
+                }
+
+                mResult = slots[idx];
+                return true;
+            }
+
+            inline void call(Instruction::Idx mOffset, Instruction::Idx mNext,
+                Instruction::Idx mTarget, const VState& mState)
+            {
+                VState callee;
+                callee.function = mTarget;
+                callee.registers = mState.registers;
+                callee.incoming.assign(
+                    mState.frame.rbegin(), mState.frame.rend());
+                callee.incoming.insert(std::end(callee.incoming),
+                    std::begin(mState.incoming), std::end(mState.incoming));
+                if(callee.incoming.size() > maxIncoming)
+                    callee.incoming.resize(maxIncoming);
+
+                mergeInto(mOffset, mTarget, callee);
+
+                auto& summary(functions[mTarget]);
+                if(!ssvu::contains(summary.callSites, mOffset))
+                    summary.callSites.emplace_back(mOffset);
+
+                if(!summary.returns) return;
+
+                VState after(mState);
+                after.registers = summary.exitRegisters;
+                mergeInto(mOffset, mNext, after);
+            }
+
+            // Replaces the arguments on top of `mState.frame` by the result
+            inline bool callNative(
+                Instruction::Idx mOffset, int mIdx, VState& mState)
+            {
+                if(mIdx < 0 || std::size_t(mIdx) >= natives.size())
+                {
+                    fail(mOffset, "unknown native function " +
+                                      ssvu::toStr(mIdx));
+                    return false;
+                }
+
+                const auto& fn(natives[mIdx]);
+                const auto& count(fn.getParamCount());
+                if(!requireStack(mOffset, mState, count)) return false;
+
+                auto& frame(mState.frame);
+                const auto& first(frame.size() - count);
+
+                for(auto i(0u); i < count; ++i)
+                    if(frame[first + i] != getVType(fn.getParamType(i)))
+                    {
+                        fail(mOffset, "argument " + ssvu::toStr(i) +
+                                          " of native function " +
+                                          ssvu::toStr(mIdx) +
+                                          " does not hold the expected type");
+                        return false;
+                    }
+
+                frame.resize(first);
+                if(fn.getReturnType() != VMVal::Void)
+                    frame.emplace_back(getVType(fn.getReturnType()));
+
+                return true;
+            }
+
+            inline void ret(Instruction::Idx mOffset, const VState& mState)
+            {
+                if(mState.function == 0)
+                {
+                    fail(mOffset, "return outside of a function");
+                    return;
+                }
+                if(!mState.frame.empty())
+                {
+                    fail(mOffset, "stack frame not empty on return");
+                    return;
+                }
+
+                auto& summary(functions[mState.function]);
+                bool changed{false};
+
+                if(!summary.returns)
+                {
+                    summary.returns = changed = true;
+                    summary.exitRegisters = mState.registers;
+                }
+                else
+                    for(auto i(0u); i < summary.exitRegisters.size(); ++i)
+                    {
+                        auto& r(summary.exitRegisters[i]);
+                        auto merged(mergeVTypes(r, mState.registers[i]));
+                        if(merged == r) continue;
+
+                        r = merged;
+                        changed = true;
+                    }
+
+                if(changed)
+                    for(const auto& c : summary.callSites)
+                        worklist.emplace_back(c);
+            }
+
+            inline void step(Instruction::Idx mOffset)
+            {
+                // Copied, as `states` may be modified while stepping
+                VState s(states[mOffset]);
+
+                const auto& opCode(program.getOpCode(mOffset));
+                const auto& operands(program.getData() + mOffset + 1);
+                const auto& next(
+                    Instruction::Idx(mOffset + lookupInstructionSize(opCode)));
+
+                auto binaryOp([&](VType mType)
+                    {
+                        if(!requireStack(mOffset, s, 2, mType)) return;
+                        s.frame.pop_back();
+                        mergeInto(mOffset, next, s);
+                    });
+                auto jumpIf([&](Instruction::Idx mTarget, Register::Idx mReg)
+                    {
+                        if(!requireRegister(mOffset, s, mReg, VType::Int))
+                            return;
+                        mergeInto(mOffset, mTarget, s);
+                        mergeInto(mOffset, next, s);
+                    });
+
+#define SSVVM_OPERAND(mOpCode, mIdx) \
+    readOperand<OpCode::mOpCode, mIdx>(operands)
+
+                switch(opCode)
+                {
+                    case OpCode::halt: break;
+
+                    case OpCode::loadIntCVToR:
+                        s.registers[SSVVM_OPERAND(loadIntCVToR, 0)] =
+                            VType::Int;
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::loadFloatCVToR:
+                        s.registers[SSVVM_OPERAND(loadFloatCVToR, 0)] =
+                            VType::Float;
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::moveRVToR:
+                        s.registers[SSVVM_OPERAND(moveRVToR, 0)] =
+                            s.registers[SSVVM_OPERAND(moveRVToR, 1)];
+                        mergeInto(mOffset, next, s);
+                        break;
+
+                    case OpCode::pushRVToS:
+                        s.frame.emplace_back(
+                            s.registers[SSVVM_OPERAND(pushRVToS, 0)]);
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::popSVToR:
+                        if(!requireStack(mOffset, s, 1)) break;
+                        s.registers[SSVVM_OPERAND(popSVToR, 0)] =
+                            s.frame.back();
+                        s.frame.pop_back();
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::moveSBOVToR:
+                        if(!getSBOType(mOffset, s,
+                               SSVVM_OPERAND(moveSBOVToR, 1),
+                               s.registers[SSVVM_OPERAND(moveSBOVToR, 0)]))
+                            break;
+                        mergeInto(mOffset, next, s);
+                        break;
+
+                    case OpCode::pushIntCVToS:
+                        s.frame.emplace_back(VType::Int);
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::pushFloatCVToS:
+                        s.frame.emplace_back(VType::Float);
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::pushSVToS:
+                        if(!requireStack(mOffset, s, 1)) break;
+                        s.frame.emplace_back(s.frame.back());
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::popSV:
+                        if(!requireStack(mOffset, s, 1)) break;
+                        s.frame.pop_back();
+                        mergeInto(mOffset, next, s);
+                        break;
+
+                    case OpCode::goToPI:
+                        mergeInto(mOffset, SSVVM_OPERAND(goToPI, 0), s);
+                        break;
+                    case OpCode::goToPIIfIntRV:
+                        jumpIf(SSVVM_OPERAND(goToPIIfIntRV, 0),
+                            SSVVM_OPERAND(goToPIIfIntRV, 1));
+                        break;
+                    case OpCode::goToPIIfCompareRVGreater:
+                        jumpIf(SSVVM_OPERAND(goToPIIfCompareRVGreater, 0),
+                            SSVVM_OPERAND(goToPIIfCompareRVGreater, 1));
+                        break;
+                    case OpCode::goToPIIfCompareRVSmaller:
+                        jumpIf(SSVVM_OPERAND(goToPIIfCompareRVSmaller, 0),
+                            SSVVM_OPERAND(goToPIIfCompareRVSmaller, 1));
+                        break;
+                    case OpCode::goToPIIfCompareRVEqual:
+                        jumpIf(SSVVM_OPERAND(goToPIIfCompareRVEqual, 0),
+                            SSVVM_OPERAND(goToPIIfCompareRVEqual, 1));
+                        break;
+                    case OpCode::callPI:
+                        call(mOffset, next, SSVVM_OPERAND(callPI, 0), s);
+                        break;
+                    case OpCode::returnPI: ret(mOffset, s); break;
+                    case OpCode::callNative:
+                        if(!callNative(
+                               mOffset, SSVVM_OPERAND(callNative, 0), s))
+                            break;
+                        mergeInto(mOffset, next, s);
+                        break;
+
+                    case OpCode::incrementIntRV:
+                        if(!requireRegister(mOffset, s,
+                               SSVVM_OPERAND(incrementIntRV, 0), VType::Int))
+                            break;
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::decrementIntRV:
+                        if(!requireRegister(mOffset, s,
+                               SSVVM_OPERAND(decrementIntRV, 0), VType::Int))
+                            break;
+                        mergeInto(mOffset, next, s);
+                        break;
+
+                    case OpCode::addInt2SVs:
+                    case OpCode::subtractInt2SVs:
+                    case OpCode::multiplyInt2SVs:
+                    case OpCode::divideInt2SVs: binaryOp(VType::Int); break;
+
+                    case OpCode::addFloat2SVs:
+                    case OpCode::subtractFloat2SVs:
+                    case OpCode::multiplyFloat2SVs:
+                    case OpCode::divideFloat2SVs:
+                        binaryOp(VType::Float);
+                        break;
+
+                    case OpCode::compareIntRVIntRVToR:
+                        if(!requireRegister(mOffset, s,
+                               SSVVM_OPERAND(compareIntRVIntRVToR, 1),
+                               VType::Int) ||
+                            !requireRegister(mOffset, s,
+                                SSVVM_OPERAND(compareIntRVIntRVToR, 2),
+                                VType::Int))
+                            break;
+                        s.registers[SSVVM_OPERAND(compareIntRVIntRVToR, 0)] =
+                            VType::Int;
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::compareIntRVIntSVToR:
+                        if(!requireRegister(mOffset, s,
+                               SSVVM_OPERAND(compareIntRVIntSVToR, 1),
+                               VType::Int) ||
+                            !requireStack(mOffset, s, 1, VType::Int))
+                            break;
+                        s.registers[SSVVM_OPERAND(compareIntRVIntSVToR, 0)] =
+                            VType::Int;
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::compareIntSVIntSVToR:
+                        if(!requireStack(mOffset, s, 2, VType::Int)) break;
+                        s.registers[SSVVM_OPERAND(compareIntSVIntSVToR, 0)] =
+                            VType::Int;
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::compareIntRVIntCVToR:
+                        if(!requireRegister(mOffset, s,
+                               SSVVM_OPERAND(compareIntRVIntCVToR, 1),
+                               VType::Int))
+                            break;
+                        s.registers[SSVVM_OPERAND(compareIntRVIntCVToR, 0)] =
+                            VType::Int;
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::compareIntSVIntCVToR:
+                        if(!requireStack(mOffset, s, 1, VType::Int)) break;
+                        s.registers[SSVVM_OPERAND(compareIntSVIntCVToR, 0)] =
+                            VType::Int;
+                        mergeInto(mOffset, next, s);
+                        break;
+
+                    case OpCode::multiplyIntRVRVToR:
+                    case OpCode::divideIntRVRVToR:
+                    case OpCode::moduloIntRVRVToR:
+                    case OpCode::addIntRVRVToR:
+                    case OpCode::subtractIntRVRVToR:
+                        // Same layout for all five opcodes
+                        if(!requireRegister(mOffset, s,
+                               SSVVM_OPERAND(addIntRVRVToR, 1), VType::Int) ||
+                            !requireRegister(mOffset, s,
+                                SSVVM_OPERAND(addIntRVRVToR, 2), VType::Int))
+                            break;
+                        s.registers[SSVVM_OPERAND(addIntRVRVToR, 0)] =
+                            VType::Int;
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::addIntRVCVToS:
+                    case OpCode::subtractIntRVCVToS:
+                        if(!requireRegister(mOffset, s,
+                               SSVVM_OPERAND(addIntRVCVToS, 0), VType::Int))
+                            break;
+                        s.frame.emplace_back(VType::Int);
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::addIntRVSVToR:
+                        if(!requireRegister(mOffset, s,
+                               SSVVM_OPERAND(addIntRVSVToR, 1), VType::Int) ||
+                            !requireStack(mOffset, s, 1, VType::Int))
+                            break;
+                        s.frame.pop_back();
+                        s.registers[SSVVM_OPERAND(addIntRVSVToR, 0)] =
+                            VType::Int;
+                        mergeInto(mOffset, next, s);
+                        break;
+                    case OpCode::goToPIIfCompareIntRVIntCVGreater:
+                    case OpCode::goToPIIfCompareIntRVIntCVSmaller:
+                    case OpCode::goToPIIfCompareIntRVIntCVEqual:
+                    {
+                        // Same layout for the three opcodes
+                        constexpr auto op(
+                            OpCode::goToPIIfCompareIntRVIntCVEqual);
+
+                        if(!requireRegister(mOffset, s,
+                               readOperand<op, 2>(operands), VType::Int))
+                            break;
+                        s.registers[readOperand<op, 1>(operands)] = VType::Int;
+                        mergeInto(mOffset, readOperand<op, 0>(operands), s);
+                        mergeInto(mOffset, next, s);
+                        break;
+                    }
+                }
+
+#undef SSVVM_OPERAND
+            }
+
+        public:
+            inline Verifier(const Program& mProgram,
+                const std::vector<VMVal>& mInputs,
+                const std::vector<BoundFunction>& mNatives)
+                : program(mProgram), inputs(mInputs), natives(mNatives)
+            {
+            }
+
+            inline bool run()
+            {
+                if(program.getByteSize() == 0 || !findBoundaries())
+                {
+                    if(TDebug)
+                        ssvu::lo("verifier")
+                            << "ERROR: malformed or empty bytecode\n";
+                    return false;
+                }
+
+                visited.assign(program.getByteSize(), false);
+                states.resize(program.getByteSize());
+
+                VState entry;
+                entry.function = 0;
+                entry.registers.assign(
+                    program.getRegisterCount(), VType::Unset);
+
+                for(auto i(0u); i < inputs.size(); ++i)
+                {
+                    if(i >= entry.registers.size())
+                    {
+                        fail(0, "more inputs than `$require_registers`");
+                        return false;
+                    }
+
+                    entry.registers[i] = getVType(inputs[i]);
+                }
+
+                mergeInto(0, 0, entry);
+
+                while(ok && !worklist.empty())
+                {
+                    auto offset(worklist.back());
+                    worklist.pop_back();
+                    step(offset);
+                }
+
+                if(ok && program.hasStackFrameSize() &&
+                    maxFrameSize > program.getStackFrameSize())
+                    fail(maxFrameOffset,
+                        "stack frame holds " + ssvu::toStr(maxFrameSize) +
+                            " values, more than `$require_stack`");
+
+                return ok;
+            }
+
+            inline std::size_t getMaxFrameSize() const noexcept
+            {
+                return maxFrameSize;
+            }
+        };
+    }
+
+    // Proves the type of every register and stack slot used by every
+    // reachable instruction. On success the program is marked as verified,
+    // which allows running it with `VMStorage::Untagged`, and gets its exact
+    // stack frame size if it did not declare one with `$require_stack`.
+    // `mInputs` are the types of the registers set by the caller before
+    // running, starting from register 0 (see `VMPool`). `mNatives` are the
+    // functions bound to the VM, checked at every `callNative`.
+    template <bool TDebug>
+    inline bool verifyProgram(Program& mProgram,
+        const std::vector<VMVal>& mInputs = {},
+        const std::vector<BoundFunction>& mNatives = {})
+    {
+        Impl::Verifier<TDebug> verifier{mProgram, mInputs, mNatives};
+        const auto& result(verifier.run());
+
+        if(TDebug)
+            ssvu::lo("verifier") << (result ? "Program verified"
+                                            : "Program rejected")
+                                 << "\n";
+
+        mProgram.setVerified(result);
+        if(result && !mProgram.hasStackFrameSize())
+            mProgram.setStackFrameSize(
+                std::max(std::size_t(1), verifier.getMaxFrameSize()));
+
+        return result;
+    }
+}
+
+#endif
@@ -5,35 +5,100 @@
 #ifndef SSVVM_VIRTUALMACHINE
 #define SSVVM_VIRTUALMACHINE
 
+#if SSVVM_COMPUTED_GOTO
+#define SSVVM_THREADED_DISPATCH()                \
+    do                                           \
+    {                                            \
+        operands = code + programCounter + 1;    \
+        goto* handlers[code[programCounter]];    \
+    } while(false)
+
+#define SSVVM_THREADED_LABEL(mIdx, mData, mArg) \
+    &&VRM_PP_CAT(threaded_, mArg) VRM_PP_COMMA_IF(mIdx)
+
+#define SSVVM_THREADED_HANDLER(mIdx, mData, mArg)                   \
+    VRM_PP_CAT(threaded_, mArg)                                     \
+        : programCounter += getInstructionSize(OpCode::mArg);       \
+    mArg();                                                         \
+    if(TDebug) printState();                                        \
+    if(canStop(OpCode::mArg) && !running) return;                   \
+    SSVVM_THREADED_DISPATCH();
+#else
+#define SSVVM_THREADED_CASE(mIdx, mData, mArg)                  \
+    case OpCode::mArg:                                          \
+        programCounter += getInstructionSize(OpCode::mArg);     \
+        mArg();                                                 \
+        break;
+#endif
+
 namespace ssvvm
 {
     namespace Impl
     {
-        template <std::size_t TRegistrySize, bool TDebug>
+        template <std::size_t TRegistrySize, bool TDebug,
+            VMDispatch TDispatch = VMDispatch::FnPtr,
+            VMStorage TStorage = VMStorage::Tagged>
         class VMImpl
         {
         public:
-            Registry<TRegistrySize> registry;
-            Stack stack;
+            using VMValue = std::conditional_t<TStorage == VMStorage::Tagged,
+                Value, RawValue>;
+
+            Registry<TRegistrySize, VMValue> registry;
+            Stack<VMValue> stack;
 
             Instruction::Idx programCounter{0};
-            Program program;
+            std::shared_ptr<const Program> program; // Shared by `VMPool`
+            std::vector<BoundFunction> natives;     // `callNative` targets
+            JIT<VMValue> jit;
+            Profiler profiler; // Only filled by `VMDispatch::Profiled`
 
-            Instruction programInstruction;
+            OpCode opCode;
             VMFnPtr<VMImpl> fnPtr;
-            Params params;
+            const OpByte* operands{nullptr};
+
+            bool running{false}, overflowed{false};
+
+            // Set for programs that were not verified, whose stack frames
+            // may outgrow `Program::getStackFrameSize`
+            bool checkPushes{false};
+
+            // Instructions that can grow the current stack frame
+            inline static constexpr bool canPush(OpCode mOpCode) noexcept
+            {
+                return mOpCode == OpCode::pushRVToS ||
+                       mOpCode == OpCode::pushIntCVToS ||
+                       mOpCode == OpCode::pushFloatCVToS ||
+                       mOpCode == OpCode::pushSVToS ||
+                       mOpCode == OpCode::addIntRVCVToS ||
+                       mOpCode == OpCode::subtractIntRVCVToS ||
+                       mOpCode == OpCode::callNative;
+            }
 
-            bool running{false};
+            // Only these instructions can stop execution - `callPI` stops on
+            // stack overflow, and so do pushes when `checkPushes` is set
+            // (never with `VMStorage::Untagged`, which requires verified
+            // programs)
+            inline static constexpr bool canStop(OpCode mOpCode) noexcept
+            {
+                return mOpCode == OpCode::halt || mOpCode == OpCode::callPI ||
+                       (TStorage == VMStorage::Tagged && canPush(mOpCode));
+            }
 
             // Helper functions
-            inline Value& getRV(const Value& mValueIdx) noexcept
+            template <OpCode TOpCode, std::size_t TIdx>
+            inline auto getOperand() const noexcept
+            {
+                return readOperand<TOpCode, TIdx>(operands);
+            }
+            inline VMValue& getRV(Register::Idx mIdx) noexcept
             {
-                return registry.getValue(mValueIdx.get<Register::Idx>());
+                return registry.getValue(mIdx);
             }
             template <typename T>
-            inline Value execOnStack2(const T& mFn) noexcept
+            inline VMValue execOnStack2(const T& mFn) noexcept
             {
-                Value a{stack.getPop()}, b{stack.getPop()};
+                VMValue a{stack.getPop()}, b{stack.getPop()};
 
                 if(TDebug)
                 {
@@ -44,11 +109,37 @@ namespace ssvvm
                 return mFn(a, b);
             }
             template <typename T>
-            inline T getFromValue(const Value& mValue) const noexcept
+            inline T getFromValue(const VMValue& mValue) const noexcept
             {
                 return mValue.template get<T>();
             }
 
+            // Returns false and stops the VM if pushing `mCount` values would
+            // overflow the stack of a program that was not verified
+            inline bool checkPush(std::size_t mCount = 1) noexcept
+            {
+                if(!checkPushes || stack.canPush(mCount)) return true;
+
+                ssvu::lo("push") << "ERROR: stack overflow at depth "
+                                 << stack.getDepth() << "\n";
+                running = false;
+                overflowed = true;
+                return false;
+            }
+
+            // Runs JIT-compiled code for the current instruction, if any
+            inline void enterNative() noexcept
+            {
+                const auto& entry(jit.getEntry(programCounter));
+                if(entry == nullptr) return;
+
+                if(TDebug)
+                    ssvu::lo("JIT") << "Entering compiled code at instruction "
+                                    << programCounter << "\n";
+
+                programCounter = jit.run(entry, registry, stack);
+            }
+
             // Instructions
             inline void halt() noexcept
             {
@@ -60,43 +151,43 @@ namespace ssvvm
 
             inline void loadIntCVToR() noexcept
             {
-                SSVU_ASSERT(params[1].getType() == VMVal::Int);
+                constexpr auto op(OpCode::loadIntCVToR);
 
-                auto& regValue(getRV(params[0]));
-                regValue = params[1];
+                auto& regValue(getRV(getOperand<op, 0>()));
+                regValue = getOperand<op, 1>();
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[0]));
-                    ssvu::lo("loadIntCVToR") << "Loaded " << params[1]
-                                             << " into register " << dbgIdxReg
-                                             << "\n";
+                    const auto& dbgIdxReg(getOperand<op, 0>());
+                    ssvu::lo("loadIntCVToR")
+                        << "Loaded " << getOperand<op, 1>() << " into register "
+                        << dbgIdxReg << "\n";
                 }
             }
             inline void loadFloatCVToR() noexcept
             {
-                SSVU_ASSERT(params[1].getType() == VMVal::Float);
+                constexpr auto op(OpCode::loadFloatCVToR);
 
-                auto& regValue(getRV(params[0]));
-                regValue = params[1];
+                auto& regValue(getRV(getOperand<op, 0>()));
+                regValue = getOperand<op, 1>();
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[0]));
-                    ssvu::lo("loadFloatCVToR") << "Loaded " << params[1]
-                                               << " into register " << dbgIdxReg
-                                               << "\n";
+                    const auto& dbgIdxReg(getOperand<op, 0>());
+                    ssvu::lo("loadFloatCVToR")
+                        << "Loaded " << getOperand<op, 1>() << " into register "
+                        << dbgIdxReg << "\n";
                 }
             }
 
             inline void moveRVToR() noexcept
             {
-                const auto& idxDst(getFromValue<Register::Idx>(params[0]));
-                const auto& idxSrc(params[1].template get<Register::Idx>());
+                constexpr auto op(OpCode::moveRVToR);
+
+                const auto& idxDst(getOperand<op, 0>());
+                const auto& idxSrc(getOperand<op, 1>());
 
-                registry.get(idxDst) = registry.get(idxSrc);
+                registry.getValue(idxDst) = registry.getValue(idxSrc);
 
                 if(TDebug)
                 {
@@ -104,19 +195,22 @@ namespace ssvvm
                                           << " into register " << idxDst
                                           << "\n";
                     ssvu::lo("moveRVToR") << "Both registers' value is now "
-                                          << registry.get(idxSrc).value << "\n";
+                                          << registry.getValue(idxSrc) << "\n";
                 }
             }
 
             inline void pushRVToS() noexcept
             {
-                const auto& toPush(getRV(params[0]));
+                constexpr auto op(OpCode::pushRVToS);
+
+                if(!checkPush()) return;
+
+                const auto& toPush(getRV(getOperand<op, 0>()));
                 stack.push(toPush);
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[0]));
+                    const auto& dbgIdxReg(getOperand<op, 0>());
                     ssvu::lo("pushRVToS") << "Pushed register " << dbgIdxReg
                                           << " value " << toPush
                                           << " onto stack"
@@ -125,13 +219,14 @@ namespace ssvvm
             }
             inline void popSVToR() noexcept
             {
-                auto& popDst(getRV(params[0]));
+                constexpr auto op(OpCode::popSVToR);
+
+                auto& popDst(getRV(getOperand<op, 0>()));
                 popDst = stack.getPop();
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[0]));
+                    const auto& dbgIdxReg(getOperand<op, 0>());
                     ssvu::lo("popSVToR") << "Popped value " << popDst
                                          << " in register " << dbgIdxReg
                                          << " from stack"
@@ -140,51 +235,60 @@ namespace ssvvm
             }
             inline void moveSBOVToR() noexcept
             {
-                const auto& sbOffset(
-                    stack.getFromBase(params[1].template get<int>()));
+                constexpr auto op(OpCode::moveSBOVToR);
+
+                const auto& sbOffset(stack.getFromBase(getOperand<op, 1>()));
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[0]));
+                    const auto& dbgIdxReg(getOperand<op, 0>());
                     ssvu::lo("moveSBOVToR") << "Moved SBO value " << sbOffset
                                             << " into register " << dbgIdxReg
                                             << " from stack base offset"
                                             << "\n";
                 }
 
-                getRV(params[0]) = sbOffset;
+                getRV(getOperand<op, 0>()) = sbOffset;
             }
 
             inline void pushIntCVToS() noexcept
             {
+                constexpr auto op(OpCode::pushIntCVToS);
+
+                if(!checkPush()) return;
+
                 if(TDebug)
                 {
                     ssvu::lo("pushIntCVToS") << "Pushing constant int value "
-                                             << params[0] << " on stack"
+                                             << getOperand<op, 0>()
+                                             << " on stack"
                                              << "\n";
                 }
 
-                SSVU_ASSERT(params[0].getType() == VMVal::Int);
-                stack.push(params[0]);
+                stack.push(getOperand<op, 0>());
             }
 
             inline void pushFloatCVToS() noexcept
             {
+                constexpr auto op(OpCode::pushFloatCVToS);
+
+                if(!checkPush()) return;
+
                 if(TDebug)
                 {
                     ssvu::lo("pushFloatCVToS")
-                        << "Pushing constant float value " << params[0]
-                        << " on stack"
+                        << "Pushing constant float value "
+                        << getOperand<op, 0>() << " on stack"
                         << "\n";
                 }
 
-                SSVU_ASSERT(params[0].getType() == VMVal::Float);
-                stack.push(params[0]);
+                stack.push(getOperand<op, 0>());
             }
 
             inline void pushSVToS() noexcept
             {
+                if(!checkPush()) return;
+
                 if(TDebug)
                 {
                     ssvu::lo("pushSVToS")
@@ -208,7 +312,9 @@ namespace ssvvm
 
             inline void goToPI() noexcept
             {
-                const auto& jmpDst(getFromValue<Instruction::Idx>(params[0]));
+                constexpr auto op(OpCode::goToPI);
+
+                const auto& jmpDst(getOperand<op, 0>());
 
                 if(TDebug)
                 {
@@ -220,13 +326,14 @@ namespace ssvvm
             }
             inline void goToPIIfIntRV() noexcept
             {
-                const auto& jmpDst(getFromValue<Instruction::Idx>(params[0]));
-                const auto& cndVal(getRV(params[1]));
+                constexpr auto op(OpCode::goToPIIfIntRV);
+
+                const auto& jmpDst(getOperand<op, 0>());
+                const auto& cndVal(getRV(getOperand<op, 1>()));
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[1]));
+                    const auto& dbgIdxReg(getOperand<op, 1>());
                     ssvu::lo("goToPIIfIntRV")
                         << "Conditional jump to instruction " << jmpDst << "\n";
                     ssvu::lo("goToPIIfIntRV") << "Condition: register "
@@ -248,13 +355,14 @@ namespace ssvvm
 
             inline void goToPIIfCompareRVGreater() noexcept
             {
-                const auto& jmpDst(getFromValue<Instruction::Idx>(params[0]));
-                const auto& cndVal(getRV(params[1]));
+                constexpr auto op(OpCode::goToPIIfCompareRVGreater);
+
+                const auto& jmpDst(getOperand<op, 0>());
+                const auto& cndVal(getRV(getOperand<op, 1>()));
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[1]));
+                    const auto& dbgIdxReg(getOperand<op, 1>());
                     ssvu::lo("goToPIIfCompareRVGreater")
                         << "Conditional jump to instruction " << jmpDst << "\n";
                     ssvu::lo("goToPIIfCompareRVGreater")
@@ -277,13 +385,14 @@ namespace ssvvm
             }
             inline void goToPIIfCompareRVSmaller() noexcept
             {
-                const auto& jmpDst(getFromValue<Instruction::Idx>(params[0]));
-                const auto& cndVal(getRV(params[1]));
+                constexpr auto op(OpCode::goToPIIfCompareRVSmaller);
+
+                const auto& jmpDst(getOperand<op, 0>());
+                const auto& cndVal(getRV(getOperand<op, 1>()));
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[1]));
+                    const auto& dbgIdxReg(getOperand<op, 1>());
                     ssvu::lo("goToPIIfCompareRVSmaller")
                         << "Conditional jump to instruction " << jmpDst << "\n";
                     ssvu::lo("goToPIIfCompareRVSmaller")
@@ -306,13 +415,14 @@ namespace ssvvm
             }
             inline void goToPIIfCompareRVEqual() noexcept
             {
-                const auto& jmpDst(getFromValue<Instruction::Idx>(params[0]));
-                const auto& cndVal(getRV(params[1]));
+                constexpr auto op(OpCode::goToPIIfCompareRVEqual);
+
+                const auto& jmpDst(getOperand<op, 0>());
+                const auto& cndVal(getRV(getOperand<op, 1>()));
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[1]));
+                    const auto& dbgIdxReg(getOperand<op, 1>());
                     ssvu::lo("goToPIIfCompareRVEqual")
                         << "Conditional jump to instruction " << jmpDst << "\n";
                     ssvu::lo("goToPIIfCompareRVEqual")
@@ -337,66 +447,86 @@ namespace ssvvm
 
             inline void callPI() noexcept
             {
-                const auto& callDst(getFromValue<Instruction::Idx>(params[0]));
+                constexpr auto op(OpCode::callPI);
+
+                const auto& callDst(getOperand<op, 0>());
 
                 if(TDebug)
                     ssvu::lo("callPI")
                         << "Preparing to call function at instruction "
                         << callDst << "\n";
 
-                if(TDebug)
-                    ssvu::lo("callPI") << "Push current instruction ("
-                                       << programCounter
-                                       << ") on stack (for return)\n";
-                stack.push(Value::create<Instruction::Idx>(programCounter));
+                if(!stack.canPushFrame())
+                {
+                    ssvu::lo("callPI") << "ERROR: stack overflow at depth "
+                                       << stack.getDepth() << "\n";
+                    running = false;
+                    overflowed = true;
+                    return;
+                }
 
                 if(TDebug)
-                    ssvu::lo("callPI") << "Push current stack base ("
-                                       << stack.getBaseOffset()
-                                       << ") and reset it\n";
-                stack.pushBaseOffset();
+                    ssvu::lo("callPI") << "Push new stack frame, returning to "
+                                       << programCounter << "\n";
+                stack.pushFrame(programCounter);
 
                 if(TDebug)
                     ssvu::lo("callPI")
                         << "Calling function (jumping) at instruction "
                         << callDst << "\n";
                 programCounter = callDst;
+
+                if(jit.isEnabled())
+                {
+                    jit.countCall(*program, natives, callDst);
+                    enterNative();
+                }
             }
             inline void returnPI() noexcept
             {
                 if(TDebug)
-                {
-                    ssvu::lo("returnPI")
-                        << "Returning from a function - restoring stack base\n";
                     ssvu::lo("returnPI")
-                        << "\tBefore: " << stack.getBaseOffset() << "\n";
-                }
+                        << "Returning from a function - popping stack frame\n";
 
-                stack.popBaseOffset();
-                const auto& returnDst(
-                    getFromValue<Instruction::Idx>(stack.getPop()));
+                const auto& returnDst(stack.popFrame());
 
                 if(TDebug)
-                {
-                    ssvu::lo("returnPI") << "\tAfter: " << stack.getBaseOffset()
-                                         << "\n";
-                    ssvu::lo("callPI") << "Returning (jumping) to instruction "
-                                          "at the top of the stack ("
-                                       << returnDst << ")"
-                                       << "\n";
-                }
+                    ssvu::lo("returnPI")
+                        << "Returning (jumping) to instruction " << returnDst
+                        << "\n";
 
                 programCounter = returnDst;
+                if(jit.isEnabled()) enterNative();
+            }
+            inline void callNative() noexcept
+            {
+                constexpr auto op(OpCode::callNative);
+
+                const auto& idx(getOperand<op, 0>());
+                SSVU_ASSERT(idx >= 0 && std::size_t(idx) < natives.size());
+
+                // Only functions without parameters grow the stack
+                const auto& fn(natives[idx]);
+                if(fn.getParamCount() == 0 &&
+                    fn.getReturnType() != VMVal::Void && !checkPush())
+                    return;
+
+                if(TDebug)
+                    ssvu::lo("callNative")
+                        << "Calling native function " << idx << "\n";
+
+                stack.setTopPtr(fn.call(stack.getTopPtr()));
             }
 
             inline void incrementIntRV() noexcept
             {
-                auto& regVal(getRV(params[0]));
+                constexpr auto op(OpCode::incrementIntRV);
+
+                auto& regVal(getRV(getOperand<op, 0>()));
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[0]));
+                    const auto& dbgIdxReg(getOperand<op, 0>());
                     ssvu::lo("incrementIntRV") << "Incrementing value "
                                                << regVal << " in register "
                                                << dbgIdxReg << "\n";
@@ -406,12 +536,13 @@ namespace ssvvm
             }
             inline void decrementIntRV() noexcept
             {
-                auto& regVal(getRV(params[0]));
+                constexpr auto op(OpCode::decrementIntRV);
+
+                auto& regVal(getRV(getOperand<op, 0>()));
 
                 if(TDebug)
                 {
-                    const auto& dbgIdxReg(
-                        getFromValue<Register::Idx>(params[0]));
+                    const auto& dbgIdxReg(getOperand<op, 0>());
                     ssvu::lo("decrementIntRV") << "Decrementing value "
                                                << regVal << " in register "
                                                << dbgIdxReg << "\n";
@@ -419,20 +550,38 @@ namespace ssvvm
 
                 regVal.template set<int>(regVal.template get<int>() - 1);
             }
+            inline void multiplyIntRVRVToR() noexcept
+            {
+                execIntRVRVToR<OpCode::multiplyIntRVRVToR>(
+                    "multiplyIntRVRVToR",
+                    VMOperations::getMultiplication<int, VMValue>);
+            }
+            inline void divideIntRVRVToR() noexcept
+            {
+                execIntRVRVToR<OpCode::divideIntRVRVToR>("divideIntRVRVToR",
+                    VMOperations::getDivision<int, VMValue>);
+            }
+            inline void moduloIntRVRVToR() noexcept
+            {
+                execIntRVRVToR<OpCode::moduloIntRVRVToR>(
+                    "moduloIntRVRVToR", VMOperations::getModulo<int, VMValue>);
+            }
 
             inline void addInt2SVs() noexcept
             {
                 if(TDebug)
                     ssvu::lo("addInt2SVs") << "Adding 2 ints"
                                            << "\n";
-                stack.push(execOnStack2(VMOperations::getAddition<int>));
+                stack.push(execOnStack2(
+                    VMOperations::getAddition<int, VMValue>));
             }
             inline void addFloat2SVs() noexcept
             {
                 if(TDebug)
                     ssvu::lo("addFloat2SVs") << "Adding 2 floats"
                                              << "\n";
-                stack.push(execOnStack2(VMOperations::getAddition<float>));
+                stack.push(execOnStack2(
+                    VMOperations::getAddition<float, VMValue>));
             }
 
             inline void subtractInt2SVs() noexcept
@@ -440,14 +589,16 @@ namespace ssvvm
                 if(TDebug)
                     ssvu::lo("subtractInt2SVs") << "Subtracting 2 ints"
                                                 << "\n";
-                stack.push(execOnStack2(VMOperations::getSubtraction<int>));
+                stack.push(execOnStack2(
+                    VMOperations::getSubtraction<int, VMValue>));
             }
             inline void subtractFloat2SVs() noexcept
             {
                 if(TDebug)
                     ssvu::lo("subtractFloat2SVs") << "Subtracting 2 floats"
                                                   << "\n";
-                stack.push(execOnStack2(VMOperations::getSubtraction<float>));
+                stack.push(execOnStack2(
+                    VMOperations::getSubtraction<float, VMValue>));
             }
 
             inline void multiplyInt2SVs() noexcept
@@ -455,15 +606,16 @@ namespace ssvvm
                 if(TDebug)
                     ssvu::lo("multiplyInt2SVs") << "Multiplying 2 ints"
                                                 << "\n";
-                stack.push(execOnStack2(VMOperations::getMultiplication<int>));
+                stack.push(execOnStack2(
+                    VMOperations::getMultiplication<int, VMValue>));
             }
             inline void multiplyFloat2SVs() noexcept
             {
                 if(TDebug)
                     ssvu::lo("multiplyFloat2SVs") << "Multiplying 2 floats"
                                                   << "\n";
-                stack.push(
-                    execOnStack2(VMOperations::getMultiplication<float>));
+                stack.push(execOnStack2(
+                    VMOperations::getMultiplication<float, VMValue>));
             }
 
             inline void divideInt2SVs() noexcept
@@ -471,27 +623,32 @@ namespace ssvvm
                 if(TDebug)
                     ssvu::lo("divideInt2SVs") << "Dividing 2 ints"
                                               << "\n";
-                stack.push(execOnStack2(VMOperations::getDivision<int>));
+                stack.push(execOnStack2(
+                    VMOperations::getDivision<int, VMValue>));
             }
             inline void divideFloat2SVs() noexcept
             {
                 if(TDebug)
                     ssvu::lo("divideFloat2SVs") << "Dividing 2 floats"
                                                 << "\n";
-                stack.push(execOnStack2(VMOperations::getDivision<float>));
+                stack.push(execOnStack2(
+                    VMOperations::getDivision<float, VMValue>));
             }
 
 
             inline void compareIntRVIntRVToR() noexcept
             {
-                const auto& idxDst(getFromValue<Register::Idx>(params[0]));
-                const auto& idxA(getFromValue<Register::Idx>(params[1]));
-                const auto& idxB(getFromValue<Register::Idx>(params[2]));
-                const auto& valA(getFromValue<int>(registry.get(idxA).value));
-                const auto& valB(getFromValue<int>(registry.get(idxB).value));
-                const auto& result(VMOperations::getIntComparison(valA, valB));
+                constexpr auto op(OpCode::compareIntRVIntRVToR);
+
+                const auto& idxDst(getOperand<op, 0>());
+                const auto& idxA(getOperand<op, 1>());
+                const auto& idxB(getOperand<op, 2>());
+                const auto& valA(getFromValue<int>(registry.getValue(idxA)));
+                const auto& valB(getFromValue<int>(registry.getValue(idxB)));
+                const auto& result(
+                    VMOperations::getIntComparison<VMValue>(valA, valB));
 
-                registry.get(idxDst).value = result;
+                registry.getValue(idxDst) = result;
 
                 if(TDebug)
                 {
@@ -505,13 +662,16 @@ namespace ssvvm
             }
             inline void compareIntRVIntSVToR() noexcept
             {
-                const auto& idxDst(getFromValue<Register::Idx>(params[0]));
-                const auto& idxA(getFromValue<Register::Idx>(params[1]));
-                const auto& valA(getFromValue<int>(registry.get(idxA).value));
+                constexpr auto op(OpCode::compareIntRVIntSVToR);
+
+                const auto& idxDst(getOperand<op, 0>());
+                const auto& idxA(getOperand<op, 1>());
+                const auto& valA(getFromValue<int>(registry.getValue(idxA)));
                 const auto& valB(stack.getTop());
-                const auto& result(VMOperations::getIntComparison(valA, valB));
+                const auto& result(
+                    VMOperations::getIntComparison<VMValue>(valA, valB));
 
-                registry.get(idxDst).value = result;
+                registry.getValue(idxDst) = result;
 
                 if(TDebug)
                 {
@@ -525,12 +685,15 @@ namespace ssvvm
             }
             inline void compareIntSVIntSVToR() noexcept
             {
-                const auto& idxDst(getFromValue<Register::Idx>(params[0]));
+                constexpr auto op(OpCode::compareIntSVIntSVToR);
+
+                const auto& idxDst(getOperand<op, 0>());
                 const auto& valA(stack.getTop());
                 const auto& valB(stack.getTop(1));
-                const auto& result(VMOperations::getIntComparison(valA, valB));
+                const auto& result(
+                    VMOperations::getIntComparison<VMValue>(valA, valB));
 
-                registry.get(idxDst).value = result;
+                registry.getValue(idxDst) = result;
 
                 if(TDebug)
                 {
@@ -544,13 +707,16 @@ namespace ssvvm
             }
             inline void compareIntRVIntCVToR() noexcept
             {
-                const auto& idxDst(getFromValue<Register::Idx>(params[0]));
-                const auto& idxA(getFromValue<Register::Idx>(params[1]));
-                const auto& valA(getFromValue<int>(registry.get(idxA).value));
-                const auto& valB(getFromValue<int>(params[2]));
-                const auto& result(VMOperations::getIntComparison(valA, valB));
+                constexpr auto op(OpCode::compareIntRVIntCVToR);
+
+                const auto& idxDst(getOperand<op, 0>());
+                const auto& idxA(getOperand<op, 1>());
+                const auto& valA(getFromValue<int>(registry.getValue(idxA)));
+                const auto& valB(getOperand<op, 2>());
+                const auto& result(
+                    VMOperations::getIntComparison<VMValue>(valA, valB));
 
-                registry.get(idxDst).value = result;
+                registry.getValue(idxDst) = result;
 
                 if(TDebug)
                 {
@@ -564,12 +730,15 @@ namespace ssvvm
             }
             inline void compareIntSVIntCVToR() noexcept
             {
-                const auto& idxDst(getFromValue<Register::Idx>(params[0]));
+                constexpr auto op(OpCode::compareIntSVIntCVToR);
+
+                const auto& idxDst(getOperand<op, 0>());
                 const auto& valA(stack.getTop());
-                const auto& valB(getFromValue<int>(params[1]));
-                const auto& result(VMOperations::getIntComparison(valA, valB));
+                const auto& valB(getOperand<op, 1>());
+                const auto& result(
+                    VMOperations::getIntComparison<VMValue>(valA, valB));
 
-                registry.get(idxDst).value = result;
+                registry.getValue(idxDst) = result;
 
                 if(TDebug)
                 {
@@ -582,82 +751,325 @@ namespace ssvvm
                 }
             }
 
+            // Superinstructions
+            template <OpCode TOpCode, typename TOperation>
+            inline void execIntRVRVToR(
+                const char* mTitle, const TOperation& mFn) noexcept
+            {
+                const auto& idxDst(getOperand<TOpCode, 0>());
+                const auto& idxA(getOperand<TOpCode, 1>());
+                const auto& idxB(getOperand<TOpCode, 2>());
+
+                registry.getValue(idxDst) =
+                    mFn(registry.getValue(idxA), registry.getValue(idxB));
+
+                if(TDebug)
+                    ssvu::lo(mTitle) << "Register " << idxDst << " = register "
+                                     << idxA << " op register " << idxB
+                                     << " = " << registry.getValue(idxDst)
+                                     << "\n";
+            }
+            template <OpCode TOpCode, typename TOperation>
+            inline void execIntRVCVToS(
+                const char* mTitle, const TOperation& mFn) noexcept
+            {
+                if(!checkPush()) return;
+
+                const auto& idxA(getOperand<TOpCode, 0>());
+                const VMValue valB(getOperand<TOpCode, 1>());
+
+                stack.push(mFn(registry.getValue(idxA), valB));
+
+                if(TDebug)
+                    ssvu::lo(mTitle) << "Pushed register " << idxA
+                                     << " op constant int " << valB << " = "
+                                     << stack.getTop() << "\n";
+            }
+            template <OpCode TOpCode, typename TCondition>
+            inline void execGoToPIIfCompareIntRVIntCV(
+                const char* mTitle, const TCondition& mFn) noexcept
+            {
+                const auto& jmpDst(getOperand<TOpCode, 0>());
+                const auto& idxDst(getOperand<TOpCode, 1>());
+                const auto& idxA(getOperand<TOpCode, 2>());
+                const auto& valA(getFromValue<int>(registry.getValue(idxA)));
+                const auto& valB(getOperand<TOpCode, 3>());
+                const auto& result(
+                    VMOperations::getIntComparison<VMValue>(valA, valB));
+
+                registry.getValue(idxDst) = result;
+
+                if(TDebug)
+                    ssvu::lo(mTitle) << "Comparing register value " << valA
+                                     << " with constant int " << valB
+                                     << " into register " << idxDst
+                                     << ", conditional jump to instruction "
+                                     << jmpDst << "\n";
+
+                if(mFn(result.template get<int>())) programCounter = jmpDst;
+            }
+
+            inline void addIntRVRVToR() noexcept
+            {
+                execIntRVRVToR<OpCode::addIntRVRVToR>(
+                    "addIntRVRVToR", VMOperations::getAddition<int, VMValue>);
+            }
+            inline void subtractIntRVRVToR() noexcept
+            {
+                execIntRVRVToR<OpCode::subtractIntRVRVToR>(
+                    "subtractIntRVRVToR",
+                    VMOperations::getSubtraction<int, VMValue>);
+            }
+            inline void addIntRVCVToS() noexcept
+            {
+                execIntRVCVToS<OpCode::addIntRVCVToS>(
+                    "addIntRVCVToS", VMOperations::getAddition<int, VMValue>);
+            }
+            inline void subtractIntRVCVToS() noexcept
+            {
+                execIntRVCVToS<OpCode::subtractIntRVCVToS>(
+                    "subtractIntRVCVToS",
+                    VMOperations::getSubtraction<int, VMValue>);
+            }
+            inline void addIntRVSVToR() noexcept
+            {
+                constexpr auto op(OpCode::addIntRVSVToR);
+
+                const auto& idxDst(getOperand<op, 0>());
+                const auto& idxA(getOperand<op, 1>());
+
+                registry.getValue(idxDst) =
+                    VMOperations::getAddition<int, VMValue>(
+                        registry.getValue(idxA), stack.getPop());
+
+                if(TDebug)
+                    ssvu::lo("addIntRVSVToR")
+                        << "Register " << idxDst << " = register " << idxA
+                        << " + popped stack value = "
+                        << registry.getValue(idxDst) << "\n";
+            }
+            inline void goToPIIfCompareIntRVIntCVGreater() noexcept
+            {
+                execGoToPIIfCompareIntRVIntCV<
+                    OpCode::goToPIIfCompareIntRVIntCVGreater>(
+                    "goToPIIfCompareIntRVIntCVGreater", [](int mX)
+                    {
+                        return mX > 0;
+                    });
+            }
+            inline void goToPIIfCompareIntRVIntCVSmaller() noexcept
+            {
+                execGoToPIIfCompareIntRVIntCV<
+                    OpCode::goToPIIfCompareIntRVIntCVSmaller>(
+                    "goToPIIfCompareIntRVIntCVSmaller", [](int mX)
+                    {
+                        return mX < 0;
+                    });
+            }
+            inline void goToPIIfCompareIntRVIntCVEqual() noexcept
+            {
+                execGoToPIIfCompareIntRVIntCV<
+                    OpCode::goToPIIfCompareIntRVIntCVEqual>(
+                    "goToPIIfCompareIntRVIntCVEqual", [](int mX)
+                    {
+                        return mX == 0;
+                    });
+            }
+
             // Execution impl
             inline void fetch() noexcept
             {
                 if(TDebug)
                     ssvu::lo("fetch") << "Fetching instruction at "
                                       << programCounter << "\n";
-                programInstruction = program[programCounter++];
+                opCode = program->getOpCode(programCounter);
+                operands = program->getData() + programCounter + 1;
+                programCounter += lookupInstructionSize(opCode);
             }
             inline void decode() noexcept
             {
                 if(TDebug)
                     ssvu::lo("decode") << "Decoding instruction: OPCODE("
-                                       << int(programInstruction.opCode) << ")"
+                                       << int(opCode) << ")"
                                        << "\n";
-                fnPtr = getVMFnPtr<VMImpl>(programInstruction.opCode);
-                params = programInstruction.params;
+                fnPtr = getVMFnPtr<VMImpl>(opCode);
             }
             inline void eval() noexcept { (this->*fnPtr)(); }
 
-            // Execution interface
-            inline void run() noexcept
+            inline void printState() noexcept
+            {
+                ssvu::lo() << "\n";
+                ssvu::lo("run()") << "Printing VM state...\n\n";
+                const auto& stSize(stack.getSize());
+
+                for(int i{0}; i < int(std::max(stSize, registry.getSize()));
+                    ++i)
+                {
+                    std::size_t sIdx(stSize - i - 1);
+
+                    ssvu::lo() << ((sIdx < stSize)
+                                       ? "\t|--------------------|"
+                                       : "\t                      ");
+
+                    if(i < int(registry.getSize()))
+                        ssvu::lo() << "\t\tRegister " << i << ": "
+                                   << registry.getValue(i);
+
+                    ssvu::lo() << "\n";
+
+                    if(sIdx < stSize)
+                    {
+                        ssvu::lo()
+                            << ((i == int(stack.getBaseOffset())) ? "--->\t"
+                                                                  : "\t")
+                            << i << "(" << -(int(stack.getBaseOffset()) - i)
+                            << ")"
+                            << "\t" << stack.getValue(sIdx) << "\n";
+                    }
+
+                    if(sIdx == 0) ssvu::lo() << "\t|--------------------|\n";
+                }
+
+                ssvu::lo() << "\n";
+            }
+
+            inline void runFnPtr() noexcept
             {
-                running = true;
                 while(running)
                 {
                     fetch();
                     decode();
                     eval();
 
-                    if(TDebug)
+                    if(TDebug) printState();
+                }
+            }
+
+            // Same as `runFnPtr`, timing every instruction and tracking calls
+            inline void runProfiled() noexcept
+            {
+                while(running)
+                {
+                    const auto offset(programCounter);
+
+                    fetch();
+                    decode();
+
+                    const auto& start(getProfilerTicks());
+                    eval();
+                    profiler.record(opCode, offset, getProfilerTicks() - start);
+
+                    if(opCode == OpCode::callPI && !overflowed)
+                        profiler.onCall(getOperand<OpCode::callPI, 0>());
+                    else if(opCode == OpCode::returnPI)
+                        profiler.onReturn();
+
+                    if(TDebug) printState();
+                }
+            }
+
+#if SSVVM_COMPUTED_GOTO
+            // Threaded loop: every handler jumps straight to the handler of
+            // the next opcode, through a label table resolved only once
+            inline void threadedImpl() noexcept
+            {
+                static const void* const handlers[]{VRM_PP_FOREACH_REVERSE(
+                    SSVVM_THREADED_LABEL, VRM_PP_EMPTY(), SSVVM_OPCODE_LIST)};
+
+                const auto code(program->getData());
+                SSVVM_THREADED_DISPATCH();
+
+                VRM_PP_FOREACH_REVERSE(
+                    SSVVM_THREADED_HANDLER, VRM_PP_EMPTY(), SSVVM_OPCODE_LIST)
+            }
+#else
+            // Portable fallback: a single `switch` over the opcodes, which
+            // still avoids the member function pointer call
+            inline void threadedImpl() noexcept
+            {
+                const auto code(program->getData());
+
+                while(running)
+                {
+                    operands = code + programCounter + 1;
+
+                    switch(OpCode(code[programCounter]))
                     {
-                        ssvu::lo() << "\n";
-                        ssvu::lo("run()") << "Printing VM state...\n\n";
-                        const auto& st(stack.getStack());
-
-                        for(int i{0};
-                            i < int(std::max(st.size(), registry.getSize()));
-                            ++i)
-                        {
-                            std::size_t sIdx(st.size() - i - 1);
-
-                            ssvu::lo() << ((sIdx < st.size())
-                                               ? "\t|--------------------|"
-                                               : "\t                      ");
-
-                            if(i < int(registry.getSize()))
-                                ssvu::lo() << "\t\tRegister " << i << ": "
-                                           << registry.get(i).value;
-
-                            ssvu::lo() << "\n";
-
-                            if(sIdx < st.size())
-                            {
-                                ssvu::lo() << ((i == int(stack.getBaseOffset()))
-                                                      ? "--->\t"
-                                                      : "\t")
-                                           << i << "("
-                                           << -(int(stack.getBaseOffset()) - i)
-                                           << ")"
-                                           << "\t" << st.at(sIdx) << "\n";
-                            }
-
-                            if(sIdx == 0)
-                                ssvu::lo() << "\t|--------------------|\n";
-                        }
-
-                        ssvu::lo() << "\n";
+                        VRM_PP_FOREACH_REVERSE(SSVVM_THREADED_CASE,
+                            VRM_PP_EMPTY(), SSVVM_OPCODE_LIST)
                     }
+
+                    if(TDebug) printState();
                 }
+            }
+#endif
 
+            // Execution interface
+            inline void run() noexcept
+            {
+                execute();
                 ssvu::lo().flush();
             }
 
-            inline void setProgram(Program mProgram) noexcept
+            // Same as `run`, without flushing the log
+            inline void execute() noexcept
             {
+                running = true;
+
+                if(TDispatch == VMDispatch::Threaded)
+                    threadedImpl();
+                else if(TDispatch == VMDispatch::Profiled)
+                    runProfiled();
+                else
+                    runFnPtr();
+            }
+
+            // Prepares the VM to run the current program again from the
+            // start. JIT-compiled code is kept.
+            inline void reset() noexcept
+            {
+                registry.clear();
+                stack.clear();
+                programCounter = 0;
+                overflowed = false;
+            }
+
+            inline void setProgram(std::shared_ptr<const Program> mProgram)
+            {
+                SSVU_ASSERT(mProgram != nullptr);
+                SSVU_ASSERT(mProgram->getRegisterCount() <= TRegistrySize);
+                SSVU_ASSERT(
+                    TStorage == VMStorage::Tagged || mProgram->isVerified());
+
                 program = std::move(mProgram);
+                stack.init(program->getStackFrameSize());
+                checkPushes = !program->isVerified();
+                jit.reset(*program);
+                profiler.reset(*program);
+                overflowed = false;
+            }
+            inline void setProgram(Program mProgram)
+            {
+                setProgram(
+                    std::make_shared<const Program>(std::move(mProgram)));
+            }
+
+            // Makes `mFnPtr` callable with `callNative(index)`, returning its
+            // index. Untagged programs must be verified with `natives`.
+            template <typename TReturn, typename... TArgs>
+            inline std::size_t bindNative(TReturn (*mFnPtr)(TArgs...))
+            {
+                natives.emplace_back(mFnPtr);
+                return natives.size() - 1;
+            }
+
+            // Compiles functions called at least `mThreshold` times to native
+            // code (0 disables the JIT). Only has an effect with
+            // `VMStorage::Untagged`, on platforms where `SSVVM_JIT` is set.
+            // Ignored by `VMDispatch::Profiled`.
+            inline void enableJIT(std::size_t mThreshold) noexcept
+            {
+                if(TDispatch != VMDispatch::Profiled) jit.enable(mThreshold);
             }
         };
     }
@@ -0,0 +1,69 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Checks that the assembler accepts the largest register and jumps to the
+// end of the program, and rejects register indices and targets that the
+// packed bytecode cannot represent.
+
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+
+inline ssvvm::Program assemble(const std::string& mSource)
+{
+    auto src(ssvvm::SourceVeeAsm::fromStrRaw(mSource));
+    ssvvm::preprocessSourceRaw<false>(src);
+    return ssvvm::getAssembledProgram<false>(src);
+}
+
+inline bool accepts(const std::string& mIdentifier, std::size_t mIdx,
+    int mValue, std::size_t mInstructionCount)
+{
+    return ssvvm::Impl::getInstructionTemplate(mIdentifier)
+        .acceptsArgValue(
+            mIdx, ssvvm::Value::create<int>(mValue), mInstructionCount);
+}
+
+int main()
+{
+    struct Case
+    {
+        const char* title;
+        bool result, expected;
+    };
+
+    const auto& program(assemble(R"(
+        //!ssvasm
+        $require_registers(256);
+        loadIntCVToR(255, 1);
+        goToPI(3);
+        halt();
+    )"));
+
+    const Case cases[]{
+        {"largest register", program.getRegisterCount() == 256, true},
+        {"jump to the end", program.getInstructionCount() == 3, true},
+        {"register 255", accepts("loadIntCVToR", 0, 255, 1), true},
+        {"register 256", accepts("loadIntCVToR", 0, 256, 1), false},
+        {"register 300", accepts("loadIntCVToR", 0, 300, 1), false},
+        {"negative register", accepts("loadIntCVToR", 0, -1, 1), false},
+        {"large constant", accepts("loadIntCVToR", 1, 300, 1), true},
+        {"target at the end", accepts("goToPI", 0, 3, 3), true},
+        {"target past the end", accepts("goToPI", 0, 4, 3), false},
+        {"negative target", accepts("goToPI", 0, -1, 3), false},
+    };
+
+    bool ok{true};
+    for(const auto& c : cases)
+    {
+        if(c.result == c.expected) continue;
+
+        ssvu::lo("Assembler") << "ERROR: " << c.title << " should have been "
+                              << (c.expected ? "accepted" : "rejected")
+                              << "\n";
+        ok = false;
+    }
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
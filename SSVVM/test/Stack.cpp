@@ -0,0 +1,52 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Checks that programs that were not verified stop on stack overflow
+// instead of pushing past the end of the stack.
+
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+
+using ssvvm::OpCode;
+
+// Pushes forever with `mPush`, which never passes verification
+inline ssvvm::Program getPushLoopProgram(OpCode mPush)
+{
+    return ssvvm::Program::fromInstructions(
+        {{OpCode::loadIntCVToR, {0, 1}}, {mPush, {0, 1}}, {OpCode::goToPI, {1}},
+            {OpCode::halt, {}}});
+}
+
+template <ssvvm::VMDispatch TDispatch>
+inline bool overflows(const std::string& mTitle, OpCode mPush)
+{
+    ssvvm::Impl::VMImpl<6, false, TDispatch> vm;
+    vm.setProgram(getPushLoopProgram(mPush));
+    vm.run();
+
+    if(vm.overflowed) return true;
+
+    ssvu::lo("Stack") << "ERROR: " << mTitle << " did not overflow\n";
+    return false;
+}
+
+template <ssvvm::VMDispatch TDispatch>
+inline bool overflowsAll(const std::string& mTitle)
+{
+    return overflows<TDispatch>(mTitle + " pushRVToS", OpCode::pushRVToS) &&
+           overflows<TDispatch>(
+               mTitle + " pushIntCVToS", OpCode::pushIntCVToS) &&
+           overflows<TDispatch>(
+               mTitle + " addIntRVCVToS", OpCode::addIntRVCVToS);
+}
+
+int main()
+{
+    const auto& ok(overflowsAll<ssvvm::VMDispatch::FnPtr>("FnPtr") &&
+                   overflowsAll<ssvvm::VMDispatch::Threaded>("Threaded") &&
+                   overflowsAll<ssvvm::VMDispatch::Profiled>("Profiled"));
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
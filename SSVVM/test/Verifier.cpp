@@ -0,0 +1,88 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Checks that the verifier accepts the samples and rejects programs that
+// would read outside the stack with `moveSBOVToR`.
+
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+#include "../src/SSVVM/Samples.hpp"
+
+using ssvvm::OpCode;
+
+inline bool verify(ssvvm::Program mProgram)
+{
+    return ssvvm::verifyProgram<false>(mProgram);
+}
+
+// The main function pushes `mArgs` values and calls a function, which pushes
+// `mLocals` values and reads the stack base offset `mOffset`. Built from
+// instructions, as the assembler does not parse negative operands.
+inline ssvvm::Program getReadProgram(int mArgs, int mLocals, int mOffset)
+{
+    std::vector<ssvvm::Instruction> result;
+    const auto& fnIdx(2 * mArgs + 2);
+
+    for(int i{0}; i < mArgs; ++i)
+        result.push_back({OpCode::pushIntCVToS, {i}});
+    result.push_back({OpCode::callPI, {fnIdx}});
+    for(int i{0}; i < mArgs; ++i) result.push_back({OpCode::popSV, {}});
+    result.push_back({OpCode::halt, {}});
+
+    for(int i{0}; i < mLocals; ++i)
+        result.push_back({OpCode::pushIntCVToS, {i}});
+    result.push_back({OpCode::moveSBOVToR, {0, mOffset}});
+    for(int i{0}; i < mLocals; ++i) result.push_back({OpCode::popSV, {}});
+    result.push_back({OpCode::returnPI, {}});
+
+    return ssvvm::Program::fromInstructions(result);
+}
+
+inline ssvvm::Program getFibProgram()
+{
+    auto src(ssvvm::SourceVeeAsm::fromStrRaw(samples::getFibSource(10)));
+    ssvvm::preprocessSourceRaw<false>(src);
+    return ssvvm::getAssembledProgram<false>(src);
+}
+
+int main()
+{
+    struct Case
+    {
+        const char* title;
+        ssvvm::Program program;
+        bool expected;
+    };
+
+    const Case cases[]{
+        {"fib sample", getFibProgram(), true},
+        {"nearest caller value", getReadProgram(1, 0, 0), true},
+        {"farthest caller value", getReadProgram(3, 0, 2), true},
+        {"first frame value", getReadProgram(0, 2, -1), true},
+        {"last frame value", getReadProgram(0, 2, -2), true},
+        {"past the caller values", getReadProgram(1, 0, 1), false},
+        {"no caller values", getReadProgram(0, 0, 0), false},
+        {"past the frame values", getReadProgram(0, 2, -3), false},
+        {"empty frame", getReadProgram(1, 0, -1), false},
+        {"past the tracked caller values", getReadProgram(20, 0, 17), false},
+        {"caller of the entry point",
+            ssvvm::Program::fromInstructions({{OpCode::moveSBOVToR, {0, 0}},
+                {OpCode::halt, {}}}),
+            false},
+    };
+
+    bool ok{true};
+    for(const auto& c : cases)
+    {
+        if(verify(c.program) == c.expected) continue;
+
+        ssvu::lo("Verifier") << "ERROR: " << c.title << " should have been "
+                             << (c.expected ? "accepted" : "rejected")
+                             << "\n";
+        ok = false;
+    }
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
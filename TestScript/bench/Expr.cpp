@@ -0,0 +1,164 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Evaluates large random expressions with the tree-walking `eval()` and as
+// SSVVM programs compiled by `ExprCompiler`, without constant folding (so
+// that the VM executes every operation) and with it.
+
+#include <chrono>
+#include <random>
+#include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
+#include "TestScript/Engine/Engine.hpp"
+#include "TestScript/Language/Language.hpp"
+
+static constexpr int leafCount{200000};
+static constexpr int runs{20};
+static constexpr std::int64_t valueBound{1 << 20};
+
+using VM = ssvvm::Impl::VMImpl<6, false, ssvvm::VMDispatch::Threaded,
+    ssvvm::VMStorage::Untagged>;
+using Clock = std::chrono::high_resolution_clock;
+
+// Builds random expressions whose intermediate values stay small, so that
+// neither evaluation overflows or divides by zero
+class ExprGenerator
+{
+private:
+    std::minstd_rand rng{1234};
+    std::vector<ssvu::UPtr<Lang::ASTExpr>> nodes;
+
+    template <typename T, typename... TArgs>
+    inline Lang::ASTExpr& create(TArgs&&... mArgs)
+    {
+        nodes.emplace_back(std::make_unique<T>(FWD(mArgs)...));
+        return *nodes.back();
+    }
+
+    template <template <typename> class TOp>
+    inline Lang::ASTExpr& createOp(Lang::ASTExpr& mLhs, Lang::ASTExpr& mRhs)
+    {
+        return create<Lang::ASTBinaryOp<TOp<int>>>(mLhs, mRhs);
+    }
+
+public:
+    // Returns the expression and its value
+    inline std::pair<Lang::ASTExpr*, std::int64_t> generate(int mLeaves)
+    {
+        if(mLeaves == 1)
+        {
+            const auto& value(int(rng() % 100));
+            return {&create<Lang::ASTNumber>(value), value};
+        }
+
+        const auto& split(1 + int(rng() % (mLeaves - 1)));
+        const auto& lhs(generate(split));
+        const auto& rhs(generate(mLeaves - split));
+        const auto& a(lhs.second);
+        const auto& b(rhs.second);
+
+        auto fits([](std::int64_t mValue)
+            {
+                return mValue > -valueBound && mValue < valueBound;
+            });
+
+        switch(rng() % 5)
+        {
+            case 2:
+                if(fits(a * b))
+                    return {&createOp<Lang::OpMul>(*lhs.first, *rhs.first),
+                        a * b};
+                break;
+            case 3:
+                if(b != 0)
+                    return {&createOp<Lang::OpDiv>(*lhs.first, *rhs.first),
+                        a / b};
+                break;
+            case 4:
+                if(b != 0)
+                    return {&createOp<Lang::OpMod>(*lhs.first, *rhs.first),
+                        a % b};
+                break;
+        }
+
+        // One of the two always fits
+        if((rng() % 2 == 0 && fits(a + b)) || !fits(a - b))
+            return {&createOp<Lang::OpAdd>(*lhs.first, *rhs.first), a + b};
+
+        return {&createOp<Lang::OpSub>(*lhs.first, *rhs.first), a - b};
+    }
+};
+
+template <typename TFn>
+inline Clock::duration getBest(const TFn& mFn)
+{
+    Clock::duration best{Clock::duration::max()};
+
+    for(int i{0}; i < runs; ++i)
+    {
+        auto start(Clock::now());
+        mFn();
+        best = std::min(best, Clock::now() - start);
+    }
+
+    return best;
+}
+
+inline long toUs(Clock::duration mDuration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(mDuration)
+        .count();
+}
+
+inline bool benchVM(const std::string& mTitle, Lang::ASTExpr& mExpr,
+    bool mFold, int mExpected)
+{
+    auto program(Lang::getCompiledExpr(mExpr, 6, mFold));
+    if(!ssvvm::verifyProgram<false>(program))
+    {
+        ssvu::lo(mTitle) << "ERROR: verification failed\n";
+        return false;
+    }
+
+    VM vm;
+    vm.setProgram(std::move(program));
+
+    int result{0};
+    const auto& best(getBest([&]
+        {
+            vm.reset();
+            vm.run();
+            result = vm.stack.getTop().get<int>();
+        }));
+
+    ssvu::lo(mTitle) << (result == mExpected ? "OK" : "ERROR: wrong result")
+                     << " | " << vm.program->getInstructionCount()
+                     << " instructions, " << toUs(best) << " us\n";
+
+    return result == mExpected;
+}
+
+int main()
+{
+    ExprGenerator generator;
+    const auto& expr(generator.generate(leafCount));
+    auto& root(*expr.first);
+
+    int result{0};
+    const auto& evalBest(getBest([&]
+        {
+            result = root.eval();
+        }));
+
+    bool ok{result == expr.second};
+    ssvu::lo("eval()") << (ok ? "OK" : "ERROR: wrong result") << " | "
+                       << leafCount << " leaves, " << toUs(evalBest)
+                       << " us\n";
+
+    ok = benchVM("VM", root, false, expr.second) && ok;
+    ok = benchVM("VM (folded)", root, true, expr.second) && ok;
+
+    ssvu::lo().flush();
+    return ok ? 0 : 1;
+}
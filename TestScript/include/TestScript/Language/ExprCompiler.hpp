@@ -0,0 +1,164 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef TESTSCRIPT_LANGUAGE_EXPRCOMPILER
+#define TESTSCRIPT_LANGUAGE_EXPRCOMPILER
+
+namespace Lang
+{
+    // Lowers integer expressions into an `ssvvm::Program`, driven by the AST
+    // nodes' `toBytecode`. Constant subexpressions are folded; other values
+    // live in registers. Pending values form a stack, so when registers run
+    // out the oldest ones are spilled to the VM stack, and popped back in
+    // reverse order when they are needed.
+    class ExprCompiler
+    {
+    public:
+        // Result of a subexpression: a folded constant, or the newest value
+        // not consumed yet
+        struct Operand
+        {
+            bool constant;
+            int value; // Only meaningful for constants
+        };
+
+    private:
+        static constexpr int spilled{-1};
+
+        std::vector<ssvvm::Instruction> instructions;
+        std::vector<int> freeRegisters;
+
+        // Register of every pending value, oldest first - spilled values
+        // are always the oldest ones
+        std::vector<int> pending;
+        std::size_t spilledCount{0}, maxSpilledCount{0};
+        bool fold;
+
+        inline void emit(ssvvm::OpCode mOpCode, const ssvvm::Params& mParams)
+        {
+            instructions.push_back({mOpCode, mParams});
+        }
+
+        inline int allocate()
+        {
+            if(freeRegisters.empty())
+            {
+                SSVU_ASSERT(spilledCount < pending.size());
+
+                auto& oldest(pending[spilledCount++]);
+                emit(ssvvm::OpCode::pushRVToS, {oldest});
+                freeRegisters.emplace_back(oldest);
+                oldest = spilled;
+                maxSpilledCount = std::max(maxSpilledCount, spilledCount);
+            }
+
+            const auto result(freeRegisters.back());
+            freeRegisters.pop_back();
+            return result;
+        }
+
+        // Makes `mOperand` a pending value, returning its index in `pending`
+        inline std::size_t materialize(
+            const Operand& mOperand, std::size_t mIdx)
+        {
+            if(!mOperand.constant) return mIdx;
+
+            const auto& reg(allocate());
+            emit(ssvvm::OpCode::loadIntCVToR, {reg, mOperand.value});
+            pending.emplace_back(reg);
+            return pending.size() - 1;
+        }
+
+        // Pops the newest spilled value into a register
+        inline void reload()
+        {
+            SSVU_ASSERT(spilledCount > 0);
+
+            const auto& reg(allocate());
+            emit(ssvvm::OpCode::popSVToR, {reg});
+            pending[--spilledCount] = reg;
+        }
+
+        template <typename TOp>
+        inline static bool canFold(int mA, int mB) noexcept
+        {
+            // Division by zero and overflowing divisions are left to the VM
+            if(TOp::opCode != ssvvm::OpCode::divideIntRVRVToR &&
+                TOp::opCode != ssvvm::OpCode::moduloIntRVRVToR)
+                return true;
+
+            return mB != 0 &&
+                   !(mB == -1 && mA == std::numeric_limits<int>::min());
+        }
+
+    public:
+        // Never uses more than `mRegisterLimit` registers, which must be at
+        // least 2. Without `mFold`, every operation is executed by the VM.
+        inline ExprCompiler(std::size_t mRegisterLimit = 6, bool mFold = true)
+            : fold{mFold}
+        {
+            SSVU_ASSERT(mRegisterLimit >= 2);
+
+            for(auto i(mRegisterLimit); i > 0; --i)
+                freeRegisters.emplace_back(int(i - 1));
+        }
+
+        inline Operand getConstant(int mValue) const noexcept
+        {
+            return {true, mValue};
+        }
+
+        // `TOp` is one of the `Lang` operation structs. `mRhs` must be the
+        // newest operand.
+        template <typename TOp>
+        inline Operand getBinary(const Operand& mLhs, const Operand& mRhs)
+        {
+            if(fold && mLhs.constant && mRhs.constant &&
+                canFold<TOp>(mLhs.value, mRhs.value))
+                return getConstant(TOp::get(mLhs.value, mRhs.value));
+
+            // Pending values consumed by this operation are on top
+            const auto& consumed(
+                std::size_t(!mLhs.constant) + std::size_t(!mRhs.constant));
+            auto rhsIdx(pending.size() - 1);
+            auto lhsIdx(pending.size() - consumed);
+
+            rhsIdx = materialize(mRhs, rhsIdx);
+            lhsIdx = materialize(mLhs, lhsIdx);
+
+            // Spilled values are reloaded newest first
+            while(spilledCount > pending.size() - 2) reload();
+
+            const auto& lhsReg(pending[lhsIdx]);
+            const auto& rhsReg(pending[rhsIdx]);
+            emit(TOp::opCode, {lhsReg, lhsReg, rhsReg});
+
+            const auto result(lhsReg);
+            freeRegisters.emplace_back(rhsReg);
+            pending.resize(pending.size() - 2);
+            pending.emplace_back(result);
+
+            return {false, 0};
+        }
+
+        // Returns a program leaving the value of `mResult` on top of the
+        // stack
+        inline ssvvm::Program getProgram(const Operand& mResult)
+        {
+            if(mResult.constant)
+                emit(ssvvm::OpCode::pushIntCVToS, {mResult.value});
+            else if(spilledCount == 0)
+                emit(ssvvm::OpCode::pushRVToS, {pending.back()});
+
+            emit(ssvvm::OpCode::halt, {});
+
+            auto result(ssvvm::Program::fromInstructions(instructions));
+            result.setStackFrameSize(
+                std::max(maxSpilledCount, std::size_t(1)));
+            return result;
+        }
+    };
+}
+
+#endif
@@ -5,6 +5,8 @@
 #ifndef TESTSCRIPT_LANGUAGE
 #define TESTSCRIPT_LANGUAGE
 
+#include "TestScript/Language/ExprCompiler.hpp"
+
 namespace Lang
 {
     enum class Tkn : int
@@ -37,7 +39,7 @@ namespace Lang
     {
         inline virtual std::string getName() { return "ASTExpr"; }
         virtual int eval() = 0;
-        virtual void toBytecode() = 0;
+        virtual ExprCompiler::Operand toBytecode(ExprCompiler& mCompiler) = 0;
     };
 
 
@@ -50,9 +52,10 @@ namespace Lang
         inline std::string getName() override { return ssvu::toStr(value); }
         inline int eval() override { return value; }
 
-        inline void toBytecode() override
+        inline ExprCompiler::Operand toBytecode(
+            ExprCompiler& mCompiler) override
         {
-            ssvu::lo() << "push(" << value << ");\n";
+            return mCompiler.getConstant(value);
         }
     };
 
@@ -68,28 +71,35 @@ namespace Lang
 
         inline std::string getName() override { return "( ... )"; }
         inline int eval() override { return innerExpr->eval(); }
-        inline void toBytecode() override { innerExpr->toBytecode(); }
+        inline ExprCompiler::Operand toBytecode(
+            ExprCompiler& mCompiler) override
+        {
+            return innerExpr->toBytecode(mCompiler);
+        }
     };
 
-#define CREATE_OP_STRUCT(mName, mOp)                           \
-    template <typename T>                                      \
-    struct mName                                               \
-    {                                                          \
-        inline static T get(const T& mA, const T& mB) noexcept \
-        {                                                      \
-            return mA mOp mB;                                  \
-        }                                                      \
-        inline static std::string getStr() noexcept            \
-        {                                                      \
-            return SSVPP_TOSTR(mOp);                           \
-        }                                                      \
+#define CREATE_OP_STRUCT(mName, mOp, mOpCode)                     \
+    template <typename T>                                        \
+    struct mName                                                 \
+    {                                                            \
+        static constexpr ssvvm::OpCode opCode{                   \
+            ssvvm::OpCode::mOpCode};                             \
+                                                                 \
+        inline static T get(const T& mA, const T& mB) noexcept   \
+        {                                                        \
+            return mA mOp mB;                                    \
+        }                                                        \
+        inline static std::string getStr() noexcept              \
+        {                                                        \
+            return SSVPP_TOSTR(mOp);                             \
+        }                                                        \
     }
 
-    CREATE_OP_STRUCT(OpAdd, +);
-    CREATE_OP_STRUCT(OpSub, -);
-    CREATE_OP_STRUCT(OpMul, *);
-    CREATE_OP_STRUCT(OpDiv, / );
-    CREATE_OP_STRUCT(OpMod, % );
+    CREATE_OP_STRUCT(OpAdd, +, addIntRVRVToR);
+    CREATE_OP_STRUCT(OpSub, -, subtractIntRVRVToR);
+    CREATE_OP_STRUCT(OpMul, *, multiplyIntRVRVToR);
+    CREATE_OP_STRUCT(OpDiv, / , divideIntRVRVToR);
+    CREATE_OP_STRUCT(OpMod, % , moduloIntRVRVToR);
 
     template <typename TOp>
     struct ASTBinaryOp : public ASTExpr
@@ -110,13 +120,22 @@ namespace Lang
             return TOp::get(lhs->eval(), rhs->eval());
         }
 
-        inline void toBytecode() override
+        inline ExprCompiler::Operand toBytecode(
+            ExprCompiler& mCompiler) override
         {
-            lhs->toBytecode();
-            rhs->toBytecode();
-            ssvu::lo() << "popOp(" << TOp::getStr() << ");\n";
+            const auto& lhsResult(lhs->toBytecode(mCompiler));
+            const auto& rhsResult(rhs->toBytecode(mCompiler));
+            return mCompiler.getBinary<TOp>(lhsResult, rhsResult);
         }
     };
+
+    // Compiles `mExpr` into a program leaving its value on top of the stack
+    inline ssvvm::Program getCompiledExpr(
+        ASTExpr& mExpr, std::size_t mRegisterLimit = 6, bool mFold = true)
+    {
+        ExprCompiler compiler{mRegisterLimit, mFold};
+        return compiler.getProgram(mExpr.toBytecode(compiler));
+    }
 }
 
 #endif
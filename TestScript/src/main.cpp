@@ -1,4 +1,5 @@
 #include <SSVUtils/SSVUtils.hpp>
+#include "SSVVM/SSVVM.hpp"
 #include "TestScript/Engine/Engine.hpp"
 #include "TestScript/Language/Language.hpp"
 
@@ -132,7 +133,11 @@ int main()
 
     auto& b(parser.getParseStack().back());
     ssvu::lo("RESULT") << b->getAs<ASTExpr>().eval() << "\n";
-    b->getAs<ASTExpr>().toBytecode();
+
+    ssvvm::VirtualMachine vm;
+    vm.setProgram(getCompiledExpr(b->getAs<ASTExpr>(), 6, false));
+    vm.run();
+    ssvu::lo("VM RESULT") << vm.stack.getTop() << "\n";
 
     printNode<true>(std::cout, *b, 0);
 